@@ -1,28 +1,151 @@
 #include "CliApp.hpp"
 
+#include <chrono>
+#include <climits>
 #include <iostream>
+#include <optional>
 #include <string>
 
+#include "Formatter.hpp"
 #include "commands/CommandHandlers.hpp"
+#include "core/HandleCache.hpp"
+#include "core/RowFilter.hpp"
+#include "core/SymbolWorker.hpp"
 #include "external/argparse.hpp"
+#include "utils/ScopeExit.hpp"
+#include "utils/StringUtils.hpp"
+#include "utils/ThreadPool.hpp"
+
+// --tree, --children and --cmdline, for the commands that act on whole processes.
+static void AddTargetArguments(argparse::ArgumentParser &cmd) {
+	auto &scopeMutex = cmd.add_mutually_exclusive_group();
+	scopeMutex.add_argument("--tree")
+		.help("Also act on every descendant of the target processes")
+		.default_value(false)
+		.implicit_value(true);
+	scopeMutex.add_argument("--children")
+		.help("Act on every descendant of the target processes, but not on them")
+		.default_value(false)
+		.implicit_value(true);
+	cmd.add_argument("--cmdline")
+		.help("Only target processes whose command line matches <regex>")
+		.default_value(std::string{});
+}
+
+static TargetOptions GetTargetOptions(const argparse::ArgumentParser &cmd) {
+	TargetOptions options;
+	if (cmd.get<bool>("--tree")) options.Scope = TargetScope::Tree;
+	if (cmd.get<bool>("--children")) options.Scope = TargetScope::Children;
+	options.CommandLine = cmd.get<std::string>("--cmdline");
+	return options;
+}
+
+// --symbol-workers, for the commands that symbolize start addresses. Takes a
+// parser or a mutually exclusive group.
+template <typename Parent>
+static argparse::Argument &AddSymbolWorkersArgument(Parent &cmd) {
+	return cmd.add_argument("--symbol-workers")
+		.help("Resolve symbols in <n> parallel worker processes")
+		.default_value(std::string{});
+}
+
+// Reads an integer option within [min, max]. Prints the error and returns nullopt
+// when the value is out of range or not a number.
+static std::optional<size_t> GetCount(
+	const argparse::ArgumentParser &cmd,
+	const std::string &name,
+	std::string_view what,
+	long min = 1,
+	long max = LONG_MAX
+) {
+	auto text = cmd.get<std::string>(name);
+	auto value = StringUtils::TryParseInt(text);
+	if (!value || value.value() < min || value.value() > max) {
+		std::cerr << "Error: Invalid " << what << ": " << text << "\n";
+		return std::nullopt;
+	}
+	return static_cast<size_t>(value.value());
+}
+
+// Reads a non-zero duration option (e.g. 1s, 500ms), printing the error if invalid.
+static std::optional<std::chrono::milliseconds> GetDuration(
+	const argparse::ArgumentParser &cmd, const std::string &name, std::string_view what
+) {
+	auto text = cmd.get<std::string>(name);
+	auto duration = StringUtils::TryParseDuration(text);
+	if (!duration || duration->count() == 0) {
+		std::cerr << "Error: Invalid " << what << ": " << text << "\n";
+		return std::nullopt;
+	}
+	return duration;
+}
+
+// 0 (symbolize in-process) unless --symbol-workers was given; nullopt if invalid.
+static std::optional<size_t> GetSymbolWorkers(const argparse::ArgumentParser &cmd) {
+	if (!cmd.is_used("--symbol-workers")) return size_t{0};
+	return GetCount(cmd, "--symbol-workers", "symbol worker count");
+}
 
 int CliApp::Run(int argc, char *argv[]) {
+	// Hidden mode: serve symbol resolution requests for a parent winproc process.
+	if (argc == 2 && std::string_view(argv[1]) == "--symbol-worker") {
+		return SymbolWorker::Serve();
+	}
+
 	argparse::ArgumentParser parser("winproc");
 	constexpr const char version[] = "0.2.0";
 
+	parser.add_argument("--handle-stats")
+		.help("Print handle cache hits and misses when the command finishes")
+		.default_value(false)
+		.implicit_value(true);
+	parser.add_argument("--jobs")
+		.help("Threads used for per-thread queries and bulk actions (default: cores)")
+		.default_value(std::string{});
+
 	// --- list ---
 	argparse::ArgumentParser listCmd("list", version, argparse::default_arguments::help);
 	listCmd.add_description("List all processes");
+	listCmd.add_argument("--suspended-only")
+		.help("List only processes whose threads are all suspended")
+		.default_value(false)
+		.implicit_value(true);
+	listCmd.add_argument("--where")
+		.help("Filter rows, e.g. \"mem > 500MB && prio == high && session != services\"")
+		.default_value(std::string{});
+
+	// --- pids ---
+	argparse::ArgumentParser pidsCmd("pids", version, argparse::default_arguments::help);
+	pidsCmd.add_description("Print the PIDs of matching processes, one per line");
+	pidsCmd.add_argument("pattern").help(
+		"Process PIDs or names, comma-separated (* and ? globs allowed)"
+	);
+
+	// --- tree ---
+	argparse::ArgumentParser treeCmd("tree", version, argparse::default_arguments::help);
+	treeCmd.add_description("Show the process hierarchy with per-subtree totals");
+	treeCmd.add_argument("target")
+		.help("Show only the trees under these PIDs or names (default: every process)")
+		.nargs(argparse::nargs_pattern::optional)
+		.default_value(std::string{});
+	treeCmd.add_argument("--sort")
+		.help("Order siblings by pid, mem, threads or cpu (largest subtree first)")
+		.default_value(std::string{"pid"});
 
 	// --- kill ---
 	argparse::ArgumentParser killCmd("kill", version, argparse::default_arguments::help);
 	killCmd.add_description("Terminate process by <PID/Name>");
-	killCmd.add_argument("target").help("Process PID or name");
+	killCmd.add_argument("target").help(
+		"Process PIDs or names, comma-separated (* and ? globs allowed)"
+	);
+	AddTargetArguments(killCmd);
 
 	// --- query ---
 	argparse::ArgumentParser queryCmd("query", version, argparse::default_arguments::help);
 	queryCmd.add_description("Query process details by <PID/Name>");
-	queryCmd.add_argument("target").help("Process PID or name");
+	queryCmd.add_argument("target").help(
+		"Process PIDs or names, comma-separated (* and ? globs allowed)"
+	);
 
 	auto &queryMutex = queryCmd.add_mutually_exclusive_group();
 	queryMutex.add_argument("-thread")
@@ -33,12 +156,75 @@ int CliApp::Run(int argc, char *argv[]) {
 		.default_value(false)
 		.implicit_value(true);
 
+	// The budget resolves in-process on a background thread; workers resolve
+	// everything before printing. The two don't combine.
+	auto &symbolMutex = queryCmd.add_mutually_exclusive_group();
+	symbolMutex.add_argument("--symbol-budget")
+		.help("Print threads immediately and resolve symbols for at most <ms>")
+		.default_value(std::string{});
+	AddSymbolWorkersArgument(symbolMutex);
+	queryCmd.add_argument("--sample")
+		.help("Measure thread CPU% and context switches over <duration> (e.g. 1s, 500ms)")
+		.default_value(std::string{});
+	queryCmd.add_argument("--sort")
+		.help("Sort threads by tid, priority, cpu or csw (default with --sample: cpu)")
+		.default_value(std::string{});
+	queryCmd.add_argument("--where")
+		.help("Filter threads, e.g. \"state == waiting && cpu > 5\" (implies -threads)")
+		.default_value(std::string{});
+
+	// --- threads ---
+	argparse::ArgumentParser threadsCmd(
+		"threads", version, argparse::default_arguments::help
+	);
+	threadsCmd.add_description("Aggregate all threads on the system");
+	threadsCmd.add_argument("--group-by")
+		.help("Aggregation key (start: symbolized start address, state: wait reason)")
+		.default_value(std::string{"start"});
+	threadsCmd.add_argument("--top")
+		.help("Number of rows to print per table")
+		.default_value(std::string{"25"});
+	AddSymbolWorkersArgument(threadsCmd);
+
+	// --- hot ---
+	argparse::ArgumentParser hotCmd("hot", version, argparse::default_arguments::help);
+	hotCmd.add_description("Rank the threads using the most CPU across the system");
+	hotCmd.add_argument("--interval")
+		.help("Sampling interval (e.g. 1s, 500ms)")
+		.default_value(std::string{"1s"});
+	hotCmd.add_argument("--top")
+		.help("Number of threads to print")
+		.default_value(std::string{"20"});
+	AddSymbolWorkersArgument(hotCmd);
+
+	// --- profile ---
+	argparse::ArgumentParser profileCmd(
+		"profile", version, argparse::default_arguments::help
+	);
+	profileCmd.add_description("Sample thread stacks of <PID/Name> as folded stacks");
+	profileCmd.add_argument("target").help("Process PID or name");
+	profileCmd.add_argument("--duration")
+		.help("How long to profile (e.g. 10s, 500ms)")
+		.default_value(std::string{"10s"});
+	profileCmd.add_argument("--hz")
+		.help("Sampling rounds per second")
+		.default_value(std::string{"100"});
+	profileCmd.add_argument("--max-frames")
+		.help("Deepest stack to walk per sample")
+		.default_value(std::string{"128"});
+	profileCmd.add_argument("-o", "--output")
+		.help("Write folded stacks to <file> instead of stdout")
+		.default_value(std::string{});
+	AddSymbolWorkersArgument(profileCmd);
+
 	// --- suspend ---
 	argparse::ArgumentParser suspendCmd(
 		"suspend", version, argparse::default_arguments::help
 	);
 	suspendCmd.add_description("Suspend process by <PID/Name>");
-	suspendCmd.add_argument("target").help("Process PID or name");
+	suspendCmd.add_argument("target").help(
+		"Process PIDs or names, comma-separated (* and ? globs allowed)"
+	);
 
 	auto &suspendMutex = suspendCmd.add_mutually_exclusive_group();
 	suspendMutex.add_argument("-thread")
@@ -51,13 +237,16 @@ int CliApp::Run(int argc, char *argv[]) {
 	suspendCmd.add_argument("-withpriority")
 		.help("Filter target threads by priority level")
 		.default_value(std::string{});
+	AddTargetArguments(suspendCmd);
 
 	// --- resume ---
 	argparse::ArgumentParser resumeCmd(
 		"resume", version, argparse::default_arguments::help
 	);
 	resumeCmd.add_description("Resume process by <PID/Name>");
-	resumeCmd.add_argument("target").help("Process PID or name");
+	resumeCmd.add_argument("target").help(
+		"Process PIDs or names, comma-separated (* and ? globs allowed)"
+	);
 
 	auto &resumeMutex = resumeCmd.add_mutually_exclusive_group();
 	resumeMutex.add_argument("-thread")
@@ -70,13 +259,16 @@ int CliApp::Run(int argc, char *argv[]) {
 	resumeCmd.add_argument("-withpriority")
 		.help("Filter target threads by priority level")
 		.default_value(std::string{});
+	AddTargetArguments(resumeCmd);
 
 	// --- setpriority ---
 	argparse::ArgumentParser setpriorityCmd(
 		"setpriority", version, argparse::default_arguments::help
 	);
 	setpriorityCmd.add_description("Set priority for process or thread by <PID/Name>");
-	setpriorityCmd.add_argument("target").help("Process PID or name");
+	setpriorityCmd.add_argument("target").help(
+		"Process PIDs or names, comma-separated (* and ? globs allowed)"
+	);
 	setpriorityCmd.add_argument("value").help(
 		"Priority value (e.g., normal, high, real-time, etc. or integer)"
 	);
@@ -92,11 +284,17 @@ int CliApp::Run(int argc, char *argv[]) {
 	setpriorityCmd.add_argument("-withpriority")
 		.help("Filter target threads by priority level")
 		.default_value(std::string{});
+	AddTargetArguments(setpriorityCmd);
 
 	// --- register subparsers ---
 	parser.add_subparser(listCmd);
+	parser.add_subparser(pidsCmd);
+	parser.add_subparser(treeCmd);
 	parser.add_subparser(killCmd);
 	parser.add_subparser(queryCmd);
+	parser.add_subparser(threadsCmd);
+	parser.add_subparser(hotCmd);
+	parser.add_subparser(profileCmd);
 	parser.add_subparser(suspendCmd);
 	parser.add_subparser(resumeCmd);
 	parser.add_subparser(setpriorityCmd);
@@ -109,26 +307,146 @@ int CliApp::Run(int argc, char *argv[]) {
 		return -1;
 	}
 
+	if (parser.is_used("--jobs")) {
+		auto jobCount = GetCount(parser, "--jobs", "job count");
+		if (!jobCount) return -1;
+		ThreadPool::SetDefaultConcurrency(jobCount.value());
+	}
+
+	for (const auto *cmd : {&suspendCmd, &resumeCmd, &setpriorityCmd}) {
+		if (!parser.is_subcommand_used(*cmd)) continue;
+		const bool selectsThreads =
+			cmd->is_used("-thread") || cmd->is_used("-thread_addr");
+		const bool selectsTree = cmd->is_used("--tree") || cmd->is_used("--children");
+		if (selectsThreads && (selectsTree || cmd->is_used("--cmdline"))) {
+			std::cerr << "Error: --tree, --children and --cmdline select whole "
+						 "processes, not -thread or -thread_addr\n";
+			return -1;
+		}
+	}
+
+	const bool handleStats = parser.get<bool>("--handle-stats");
+	SCOPE_EXIT(if (handleStats) {
+		Formatter::PrintHandleStats(HandleCache::Shared().GetStats());
+	});
+
 	if (parser.is_subcommand_used("list")) {
-		return CommandHandlers::HandleList();
+		return CommandHandlers::HandleList(
+			listCmd.get<bool>("--suspended-only"), listCmd.get<std::string>("--where")
+		);
+	}
+
+	if (parser.is_subcommand_used("pids")) {
+		return CommandHandlers::HandlePids(pidsCmd.get<std::string>("pattern"));
+	}
+
+	if (parser.is_subcommand_used("tree")) {
+		return CommandHandlers::HandleTree(
+			treeCmd.get<std::string>("target"), treeCmd.get<std::string>("--sort")
+		);
 	}
 
 	if (parser.is_subcommand_used("kill")) {
 		auto target = killCmd.get<std::string>("target");
-		return CommandHandlers::HandleKill(target);
+		return CommandHandlers::HandleKill(target, GetTargetOptions(killCmd));
 	}
 
 	if (parser.is_subcommand_used("query")) {
 		auto target = queryCmd.get<std::string>("target");
 
-		if (queryCmd.is_used("-thread") || queryCmd.is_used("-threads")) {
+		if (queryCmd.is_used("-thread") || queryCmd.is_used("-threads") ||
+			queryCmd.is_used("--where")) {
 			auto threadIdOrName = queryCmd.get<std::string>("-thread");
-			bool queryAll = queryCmd.get<bool>("-threads");
-			return CommandHandlers::HandleQueryThread(target, threadIdOrName, queryAll);
+			auto where = queryCmd.get<std::string>("--where");
+			bool queryAll = queryCmd.get<bool>("-threads") || threadIdOrName.empty();
+
+			CommandHandlers::SymbolOptions symbolOptions;
+			if (queryCmd.is_used("--symbol-budget")) {
+				auto budgetMs = GetCount(queryCmd, "--symbol-budget", "symbol budget", 0);
+				if (!budgetMs) return -1;
+				symbolOptions.Budget = std::chrono::milliseconds(budgetMs.value());
+
+				// Filtering on start symbolizes every thread synchronously before
+				// anything prints, so the budget could never apply. Errors in the
+				// expression itself are left to the handler.
+				if (!where.empty()) {
+					auto filter = ThreadFilter::Compile(where, true);
+					if (filter && filter.value().UsesStart()) {
+						std::cerr << "Error: --symbol-budget cannot be combined with a "
+									 "--where on start\n";
+						return -1;
+					}
+				}
+			}
+			auto symbolWorkers = GetSymbolWorkers(queryCmd);
+			if (!symbolWorkers) return -1;
+			symbolOptions.Workers = symbolWorkers.value();
+
+			CommandHandlers::SampleOptions sampleOptions;
+			if (queryCmd.is_used("--sample")) {
+				auto interval = GetDuration(queryCmd, "--sample", "sample duration");
+				if (!interval) return -1;
+				sampleOptions.Interval = interval;
+				sampleOptions.SortBy = "cpu";
+			}
+			if (queryCmd.is_used("--sort")) {
+				sampleOptions.SortBy = queryCmd.get<std::string>("--sort");
+				const auto &sortBy = sampleOptions.SortBy;
+				if (sortBy != "tid" && sortBy != "priority" && sortBy != "cpu" &&
+					sortBy != "csw") {
+					std::cerr << "Error: Invalid sort column: " << sortBy << "\n";
+					return -1;
+				}
+				if ((sortBy == "cpu" || sortBy == "csw") && !sampleOptions.Interval) {
+					std::cerr << "Error: Sorting by " << sortBy << " requires --sample\n";
+					return -1;
+				}
+			}
+
+			return CommandHandlers::HandleQueryThread(
+				target, threadIdOrName, queryAll, where, symbolOptions, sampleOptions
+			);
 		}
 		return CommandHandlers::HandleQuery(target);
 	}
 
+	if (parser.is_subcommand_used("threads")) {
+		auto groupBy = threadsCmd.get<std::string>("--group-by");
+		auto top = GetCount(threadsCmd, "--top", "row count");
+		auto symbolWorkers = GetSymbolWorkers(threadsCmd);
+		if (!top || !symbolWorkers) return -1;
+
+		return CommandHandlers::HandleThreads(groupBy, top.value(), symbolWorkers.value());
+	}
+
+	if (parser.is_subcommand_used("hot")) {
+		auto interval = GetDuration(hotCmd, "--interval", "sample duration");
+		auto top = GetCount(hotCmd, "--top", "row count");
+		auto symbolWorkers = GetSymbolWorkers(hotCmd);
+		if (!interval || !top || !symbolWorkers) return -1;
+
+		return CommandHandlers::HandleHot(
+			interval.value(), top.value(), symbolWorkers.value()
+		);
+	}
+
+	if (parser.is_subcommand_used("profile")) {
+		auto target = profileCmd.get<std::string>("target");
+
+		auto duration = GetDuration(profileCmd, "--duration", "profile duration");
+		auto hz = GetCount(profileCmd, "--hz", "sampling rate (1-1000)", 1, 1000);
+		auto maxFrames = GetCount(profileCmd, "--max-frames", "frame count");
+		auto symbolWorkers = GetSymbolWorkers(profileCmd);
+		if (!duration || !hz || !maxFrames || !symbolWorkers) return -1;
+
+		ProfileOptions options{
+			duration.value(), static_cast<unsigned>(hz.value()), maxFrames.value()
+		};
+		return CommandHandlers::HandleProfile(
+			target, options, symbolWorkers.value(), profileCmd.get<std::string>("--output")
+		);
+	}
+
 	if (parser.is_subcommand_used("suspend")) {
 		auto target = suspendCmd.get<std::string>("target");
 
@@ -144,7 +462,7 @@ int CliApp::Run(int argc, char *argv[]) {
 			auto regex = suspendCmd.get<std::string>("-thread_addr");
 			return CommandHandlers::HandleSuspendThreadByAddr(target, regex, withPriority);
 		}
-		return CommandHandlers::HandleSuspend(target);
+		return CommandHandlers::HandleSuspend(target, GetTargetOptions(suspendCmd));
 	}
 
 	if (parser.is_subcommand_used("resume")) {
@@ -162,7 +480,7 @@ int CliApp::Run(int argc, char *argv[]) {
 			auto regex = resumeCmd.get<std::string>("-thread_addr");
 			return CommandHandlers::HandleResumeThreadByAddr(target, regex, withPriority);
 		}
-		return CommandHandlers::HandleResume(target);
+		return CommandHandlers::HandleResume(target, GetTargetOptions(resumeCmd));
 	}
 
 	if (parser.is_subcommand_used("setpriority")) {
@@ -185,7 +503,9 @@ int CliApp::Run(int argc, char *argv[]) {
 				target, priority, regex, withPriority
 			);
 		}
-		return CommandHandlers::HandleSetPriority(target, priority);
+		return CommandHandlers::HandleSetPriority(
+			target, priority, GetTargetOptions(setpriorityCmd)
+		);
 	}
 
 	std::cerr << "Error: No command provided.\n";
@@ -2,6 +2,9 @@
 
 #include <iostream>
 #include <format>
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
 #include <map>
 #include <tuple>
 #include <regex>
@@ -34,16 +37,24 @@ void Formatter::PrintError(std::string_view message, std::string_view traceback)
 
 void Formatter::PrintProcessList(const std::vector<ProcessInfo> &processes) {
 	std::wcout << std::format(
-		L"{:<30} {:>8} {:<9} {:<14} {:>12}  {:<50}\n",
+		L"{:<30} {:>8} {:<9} {:<14} {:>12} {:<9}  {:<50}\n",
 		L"Image Name",
 		L"PID",
 		L"Session",
 		L"Priority",
 		L"Memory",
+		L"Suspended",
 		L"Description"
 	);
 	std::wcout << std::format(
-		L"{:=<30} {:=<8} {:=<9} {:=<14} {:=<12}  {:=<50}\n", L"", L"", L"", L"", L"", L""
+		L"{:=<30} {:=<8} {:=<9} {:=<14} {:=<12} {:=<9}  {:=<50}\n",
+		L"",
+		L"",
+		L"",
+		L"",
+		L"",
+		L"",
+		L""
 	);
 	for (const auto &p : processes) {
 		std::wstring desc = ProcessUtils::GetProcessDescription(p.Pid).value_or(L"");
@@ -54,18 +65,19 @@ void Formatter::PrintProcessList(const std::vector<ProcessInfo> &processes) {
 
 		std::wstring session = Convert::SessionIdToString(p.SessionId);
 		std::string memory = Convert::MemoryToMB(p.Memory);
-		std::string priority = Convert::ProcessPriorityToString(p.BasePriority);
+		std::string_view priority = Convert::ProcessPriorityToString(p.BasePriority);
 
 		std::wstring memStr(memory.begin(), memory.end());
 		std::wstring prioStr(priority.begin(), priority.end());
 
 		std::wcout << std::format(
-			L"{:<30} {:>8} {:<9} {:<14} {:>12}  {:<50}\n",
+			L"{:<30} {:>8} {:<9} {:<14} {:>12} {:<9}  {:<50}\n",
 			nameStr,
 			p.Pid,
 			session,
 			prioStr,
 			memStr,
+			p.Suspended ? L"Yes" : L"No",
 			desc
 		);
 	}
@@ -118,7 +130,7 @@ void Formatter::PrintProcessDetails(const std::vector<ProcessInfo> &processes) {
 			std::wstring ppidStr = std::to_wstring(p->ParentPid);
 			std::wstring session = Convert::SessionIdToString(p->SessionId);
 			std::string memory = Convert::MemoryToMB(p->Memory);
-			std::string priority = Convert::ProcessPriorityToString(p->BasePriority);
+			std::string_view priority = Convert::ProcessPriorityToString(p->BasePriority);
 
 			std::wstring memStr(memory.begin(), memory.end());
 			std::wstring prioStr(priority.begin(), priority.end());
@@ -184,38 +196,60 @@ void Formatter::PrintProcessDetails(const std::vector<ProcessInfo> &processes) {
 
 struct ThreadRow {
 	std::string tid, priority, state, reason, name, address;
+	std::string cpu, contextSwitches; // Set only for sampled threads
 };
 
 static void PrintTable(std::ostream &os, const std::vector<ThreadRow> &rows);
 
-void Formatter::PrintThreads(
-	DWORD pid, std::wstring_view processName, const std::vector<ThreadAddrInfo> &threads
-) {
+static std::vector<ThreadRow> MakeThreadRows(const std::vector<ThreadAddrInfo> &threads) {
 	std::vector<ThreadRow> rows;
 	for (const auto &t : threads) {
 		std::string tid = std::to_string(t.info.Tid);
-		std::string priority = Convert::ThreadPriorityToString(t.info.BasePriority);
-		std::string state = Convert::ThreadStateToString(t.info.ThreadState);
+		std::string priority(Convert::ThreadPriorityToString(t.info.BasePriority));
+		std::string state(Convert::ThreadStateToString(t.info.ThreadState));
 		// State 5 is "Waiting" according to Convert.cpp
-		std::string reason = (t.info.ThreadState == 5)
-								 ? Convert::WaitReasonToString(t.info.WaitReason)
-								 : "";
-		std::string name = t.Name;
-		std::string startAddr = t.StartAddress;
+		std::string reason;
+		if (t.info.ThreadState == 5) reason = Convert::WaitReasonToString(t.info.WaitReason);
+		std::string name = t.Name();
+		std::string startAddr = t.StartAddress();
 
 		rows.push_back({tid, priority, state, reason, name, startAddr});
+		ThreadRow &row = rows.back();
+		if (t.activity) {
+			row.cpu = std::format("{:.2f}", t.activity->CpuPercent);
+			row.contextSwitches =
+				std::format("{:.0f}", t.activity->ContextSwitchesPerSec);
+		}
 	}
+	return rows;
+}
 
+void Formatter::PrintThreads(
+	DWORD pid, std::wstring_view processName, const std::vector<ThreadAddrInfo> &threads
+) {
 	std::cout << std::format(
 		"--- Threads for {} (PID: {}) ---\n", StringUtils::WstrToString(processName), pid
 	);
 
-	PrintTable(std::cout, rows);
+	PrintTable(std::cout, MakeThreadRows(threads));
+}
+
+void Formatter::PrintResolvedThreads(
+	DWORD pid, std::wstring_view processName, const std::vector<ThreadAddrInfo> &threads
+) {
+	std::cout << std::format(
+		"--- Resolved start addresses for {} (PID: {}) ---\n",
+		StringUtils::WstrToString(processName),
+		pid
+	);
+
+	PrintTable(std::cout, MakeThreadRows(threads));
 }
 
 static void PrintTable(std::ostream &os, const std::vector<ThreadRow> &rows) {
 	size_t tidW = 3, priW = 8, staW = 5, reaW = 6, namW = 4, adrW = 12;
-	bool showName = false, showAddr = false;
+	size_t cpuW = 4, cswW = 5;
+	bool showName = false, showAddr = false, showActivity = false;
 
 	for (const auto &r : rows) {
 		tidW = (std::max)(tidW, r.tid.length());
@@ -230,6 +264,11 @@ static void PrintTable(std::ostream &os, const std::vector<ThreadRow> &rows) {
 			showAddr = true;
 			adrW = (std::max)(adrW, r.address.length());
 		}
+		if (!r.cpu.empty()) {
+			showActivity = true;
+			cpuW = (std::max)(cpuW, r.cpu.length());
+			cswW = (std::max)(cswW, r.contextSwitches.length());
+		}
 	}
 
 	// Header
@@ -244,6 +283,9 @@ static void PrintTable(std::ostream &os, const std::vector<ThreadRow> &rows) {
 		"Reason",
 		reaW
 	);
+	if (showActivity) {
+		os << std::format(" | {:>{}} | {:>{}}", "CPU%", cpuW, "CSw/s", cswW);
+	}
 	if (showName) os << std::format(" | {:<{}}", "Name", namW);
 	if (showAddr) os << std::format(" | {:<{}}", "StartAddress", adrW);
 	os << "\n";
@@ -260,6 +302,7 @@ static void PrintTable(std::ostream &os, const std::vector<ThreadRow> &rows) {
 		"",
 		reaW + 2
 	);
+	if (showActivity) os << std::format("+{:-<{}}+{:-<{}}", "", cpuW + 2, "", cswW + 2);
 	if (showName) os << std::format("+{:-<{}}", "", namW + 2);
 	if (showAddr) os << std::format("+{:-<{}}", "", adrW + 2);
 	os << "\n";
@@ -277,6 +320,9 @@ static void PrintTable(std::ostream &os, const std::vector<ThreadRow> &rows) {
 			r.reason,
 			reaW
 		);
+		if (showActivity) {
+			os << std::format(" | {:>{}} | {:>{}}", r.cpu, cpuW, r.contextSwitches, cswW);
+		}
 		if (showName) os << std::format(" | {:<{}}", r.name, namW);
 		if (showAddr) os << std::format(" | {:<{}}", r.address, adrW);
 		os << "\n";
@@ -284,19 +330,425 @@ static void PrintTable(std::ostream &os, const std::vector<ThreadRow> &rows) {
 	os << "\n";
 }
 
+void Formatter::PrintStartAddressReport(const StartAddressReport &report, size_t top) {
+	const size_t groupCount = (std::min)(top, report.Groups.size());
+	const size_t processGroupCount = (std::min)(top, report.ProcessGroups.size());
+
+	std::cout << std::format(
+		"--- {} threads in {} processes, {} distinct start addresses "
+		"({} symbol lookups) ---\n",
+		report.TotalThreads,
+		report.TotalProcesses,
+		report.Groups.size(),
+		report.SymbolLookups
+	);
+
+	size_t thrW = 7, procW = 9, adrW = 12;
+	for (size_t i = 0; i < groupCount; ++i) {
+		const auto &g = report.Groups[i];
+		thrW = (std::max)(thrW, std::to_string(g.Threads).length());
+		procW = (std::max)(procW, std::to_string(g.Processes).length());
+		adrW = (std::max)(adrW, g.StartAddress.length());
+	}
+
+	std::cout << std::format(
+		"{:>{}} | {:>{}} | {:<{}}\n", "Threads", thrW, "Processes", procW, "StartAddress", adrW
+	);
+	std::cout << std::format(
+		"{:-<{}}+{:-<{}}+{:-<{}}\n", "", thrW + 1, "", procW + 2, "", adrW + 2
+	);
+	for (size_t i = 0; i < groupCount; ++i) {
+		const auto &g = report.Groups[i];
+		std::cout << std::format(
+			"{:>{}} | {:>{}} | {:<{}}\n",
+			g.Threads,
+			thrW,
+			g.Processes,
+			procW,
+			g.StartAddress,
+			adrW
+		);
+	}
+	std::cout << "\n";
+
+	std::vector<std::string> names;
+	size_t pidW = 3, nameW = 7;
+	thrW = 7, adrW = 12;
+	for (size_t i = 0; i < processGroupCount; ++i) {
+		const auto &g = report.ProcessGroups[i];
+		names.push_back(StringUtils::WstrToString(g.ProcessName));
+		thrW = (std::max)(thrW, std::to_string(g.Threads).length());
+		pidW = (std::max)(pidW, std::to_string(g.Pid).length());
+		nameW = (std::max)(nameW, names.back().length());
+		adrW = (std::max)(adrW, g.StartAddress.length());
+	}
+
+	std::cout << "--- Per process ---\n";
+	std::cout << std::format(
+		"{:>{}} | {:>{}} | {:<{}} | {:<{}}\n",
+		"Threads",
+		thrW,
+		"PID",
+		pidW,
+		"Process",
+		nameW,
+		"StartAddress",
+		adrW
+	);
+	std::cout << std::format(
+		"{:-<{}}+{:-<{}}+{:-<{}}+{:-<{}}\n",
+		"",
+		thrW + 1,
+		"",
+		pidW + 2,
+		"",
+		nameW + 2,
+		"",
+		adrW + 2
+	);
+	for (size_t i = 0; i < processGroupCount; ++i) {
+		const auto &g = report.ProcessGroups[i];
+		std::cout << std::format(
+			"{:>{}} | {:>{}} | {:<{}} | {:<{}}\n",
+			g.Threads,
+			thrW,
+			g.Pid,
+			pidW,
+			names[i],
+			nameW,
+			g.StartAddress,
+			adrW
+		);
+	}
+	std::cout << "\n";
+}
+
+void Formatter::PrintThreadStateReport(const ThreadStateReport &report, size_t top) {
+	constexpr size_t kBarWidth = 40;
+	const auto &total = report.Total.Counts;
+
+	std::vector<size_t> buckets;
+	for (size_t b = 0; b < total.size(); ++b) {
+		if (total[b] > 0) buckets.push_back(b);
+	}
+	std::stable_sort(buckets.begin(), buckets.end(), [&](size_t a, size_t b) {
+		return total[a] > total[b];
+	});
+
+	std::cout << std::format(
+		"--- {} threads in {} processes by state ---\n",
+		report.TotalThreads,
+		report.Processes.size()
+	);
+
+	std::vector<std::string> names;
+	size_t namW = 5, cntW = 7;
+	for (size_t b : buckets) {
+		names.push_back(ThreadStateCounts::BucketName(b));
+		namW = (std::max)(namW, names.back().length());
+		cntW = (std::max)(cntW, std::to_string(total[b]).length());
+	}
+
+	const uint32_t peak = buckets.empty() ? 0 : total[buckets.front()];
+	for (size_t i = 0; i < buckets.size(); ++i) {
+		const uint32_t count = total[buckets[i]];
+		const double share = 100.0 * count / report.TotalThreads;
+		const size_t bar = (std::max)(size_t{1}, size_t{count} * kBarWidth / peak);
+		std::cout << std::format(
+			"{:<{}} | {:>{}} | {:>6.2f}% | {}\n",
+			names[i],
+			namW,
+			count,
+			cntW,
+			share,
+			std::string(bar, '#')
+		);
+	}
+	std::cout << "\n";
+
+	// Per process: the busiest buckets of each, most threads first.
+	const size_t processCount = (std::min)(top, report.Processes.size());
+	std::vector<std::string> procNames;
+	size_t pidW = 3, procW = 7, thrW = 7;
+	for (size_t i = 0; i < processCount; ++i) {
+		const auto &p = report.Processes[i];
+		procNames.push_back(StringUtils::WstrToString(p.ProcessName));
+		pidW = (std::max)(pidW, std::to_string(p.Pid).length());
+		procW = (std::max)(procW, procNames.back().length());
+		thrW = (std::max)(thrW, std::to_string(p.Threads).length());
+	}
+
+	std::cout << "--- Per process ---\n";
+	std::cout << std::format(
+		"{:>{}} | {:>{}} | {:<{}} | States\n", "Threads", thrW, "PID", pidW, "Process", procW
+	);
+	std::cout << std::format(
+		"{:-<{}}+{:-<{}}+{:-<{}}+{:-<8}\n", "", thrW + 1, "", pidW + 2, "", procW + 2, ""
+	);
+	for (size_t i = 0; i < processCount; ++i) {
+		const auto &p = report.Processes[i];
+		const auto &counts = p.States.Counts;
+
+		std::vector<size_t> used;
+		for (size_t b = 0; b < counts.size(); ++b) {
+			if (counts[b] > 0) used.push_back(b);
+		}
+		std::stable_sort(used.begin(), used.end(), [&](size_t a, size_t b) {
+			return counts[a] > counts[b];
+		});
+
+		std::string states;
+		for (size_t b : used) {
+			if (!states.empty()) states += ", ";
+			states += std::format("{} {}", ThreadStateCounts::BucketName(b), counts[b]);
+		}
+
+		std::cout << std::format(
+			"{:>{}} | {:>{}} | {:<{}} | {}\n",
+			p.Threads,
+			thrW,
+			p.Pid,
+			pidW,
+			procNames[i],
+			procW,
+			states
+		);
+	}
+	std::cout << "\n";
+}
+
+void Formatter::PrintHotThreads(const HotThreadReport &report) {
+	std::cout << std::format(
+		"--- Top {} of {} threads by CPU over {} ms ({} symbol lookups) ---\n",
+		report.Threads.size(),
+		report.TotalThreads,
+		report.Interval.count(),
+		report.SymbolLookups
+	);
+
+	struct Row {
+		std::string cpu, contextSwitches, pid, process, tid;
+	};
+	std::vector<Row> rows;
+	size_t cpuW = 4, cswW = 5, pidW = 3, procW = 7, tidW = 3, namW = 4, adrW = 12;
+	for (const auto &t : report.Threads) {
+		Row &r = rows.emplace_back();
+		r.cpu = std::format("{:.2f}", t.Activity.CpuPercent);
+		r.contextSwitches = std::format("{:.0f}", t.Activity.ContextSwitchesPerSec);
+		r.pid = std::to_string(t.Pid);
+		r.process = StringUtils::WstrToString(t.ProcessName);
+		r.tid = std::to_string(t.Tid);
+
+		cpuW = (std::max)(cpuW, r.cpu.length());
+		cswW = (std::max)(cswW, r.contextSwitches.length());
+		pidW = (std::max)(pidW, r.pid.length());
+		procW = (std::max)(procW, r.process.length());
+		tidW = (std::max)(tidW, r.tid.length());
+		namW = (std::max)(namW, t.Name.length());
+		adrW = (std::max)(adrW, t.StartAddress.length());
+	}
+
+	std::cout << std::format(
+		"{:>{}} | {:>{}} | {:>{}} | {:<{}} | {:>{}} | {:<{}} | {:<{}}\n",
+		"CPU%",
+		cpuW,
+		"CSw/s",
+		cswW,
+		"PID",
+		pidW,
+		"Process",
+		procW,
+		"TID",
+		tidW,
+		"Name",
+		namW,
+		"StartAddress",
+		adrW
+	);
+	std::cout << std::format(
+		"{:-<{}}+{:-<{}}+{:-<{}}+{:-<{}}+{:-<{}}+{:-<{}}+{:-<{}}\n",
+		"",
+		cpuW + 1,
+		"",
+		cswW + 2,
+		"",
+		pidW + 2,
+		"",
+		procW + 2,
+		"",
+		tidW + 2,
+		"",
+		namW + 2,
+		"",
+		adrW + 2
+	);
+	for (size_t i = 0; i < rows.size(); ++i) {
+		const Row &r = rows[i];
+		const HotThread &t = report.Threads[i];
+		std::cout << std::format(
+			"{:>{}} | {:>{}} | {:>{}} | {:<{}} | {:>{}} | {:<{}} | {:<{}}\n",
+			r.cpu,
+			cpuW,
+			r.contextSwitches,
+			cswW,
+			r.pid,
+			pidW,
+			r.process,
+			procW,
+			r.tid,
+			tidW,
+			t.Name,
+			namW,
+			t.StartAddress,
+			adrW
+		);
+	}
+	std::cout << "\n";
+}
+
+void Formatter::PrintProfileSummary(const Profile &profile, size_t symbolLookups) {
+	// stderr, so the summary never mixes with the folded stacks on stdout.
+	const double seconds = profile.Elapsed.count() / 1000.0;
+	std::cerr << std::format(
+		"Profiled PID {} for {:.1f} s: {} rounds ({:.0f} Hz), {} stacks, {} unique "
+		"frames, {} failed captures, {} symbol lookups\n",
+		profile.Pid,
+		seconds,
+		profile.Rounds,
+		seconds > 0 ? profile.Rounds / seconds : 0.0,
+		profile.Stacks.TotalSamples(),
+		profile.Stacks.Frames().size(),
+		profile.Failures,
+		symbolLookups
+	);
+}
+
+void Formatter::PrintPids(const std::vector<DWORD> &pids) {
+	// Scripts call this in loops: build the text by hand and write it once.
+	std::string out;
+	out.reserve(pids.size() * 8);
+	char digits[16];
+	for (DWORD pid : pids) {
+		auto [end, ec] = std::to_chars(digits, digits + sizeof(digits), pid);
+		out.append(digits, end);
+		out += '\n';
+	}
+	std::fwrite(out.data(), 1, out.size(), stdout);
+	std::fflush(stdout);
+}
+
+void Formatter::PrintProcessTree(const ProcessTreeReport &report) {
+	struct Row {
+		std::string name, pid, memory, treeMemory, threads, cpu;
+	};
+	std::vector<Row> rows;
+	rows.reserve(report.Rows.size());
+	size_t namW = 4, pidW = 3, memW = 6, treW = 11, thrW = 7, cpuW = 7;
+
+	// Guide lines are plain ASCII; the console code page is left as it is.
+	// open[d] is true while the ancestor at depth d still has siblings below.
+	std::vector<bool> open;
+	for (const auto &entry : report.Rows) {
+		const ProcessInfo &p = report.Processes[entry.Process];
+		const ProcessTotals &total = report.Totals[entry.Process];
+
+		open.resize(entry.Depth + 1);
+		open[entry.Depth] = !entry.LastChild;
+
+		Row &r = rows.emplace_back();
+		for (uint32_t d = 1; d < entry.Depth; ++d) r.name += open[d] ? "|  " : "   ";
+		if (entry.Depth > 0) r.name += entry.LastChild ? "`- " : "|- ";
+		r.name += StringUtils::WstrToString(p.Name);
+		r.pid = std::to_string(p.Pid);
+		r.memory = Convert::MemoryToMB(p.Memory);
+		r.treeMemory = Convert::MemoryToMB(total.Memory);
+		r.threads = std::to_string(total.Threads);
+		r.cpu = std::format("{:.2f}", static_cast<double>(total.CpuTime) / 1e7);
+
+		namW = (std::max)(namW, r.name.length());
+		pidW = (std::max)(pidW, r.pid.length());
+		memW = (std::max)(memW, r.memory.length());
+		treW = (std::max)(treW, r.treeMemory.length());
+		thrW = (std::max)(thrW, r.threads.length());
+		cpuW = (std::max)(cpuW, r.cpu.length());
+	}
+
+	std::string out = std::format(
+		"{:<{}} | {:>{}} | {:>{}} | {:>{}} | {:>{}} | {:>{}}\n",
+		"Name",
+		namW,
+		"PID",
+		pidW,
+		"Memory",
+		memW,
+		"Tree memory",
+		treW,
+		"Threads",
+		thrW,
+		"CPU (s)",
+		cpuW
+	);
+	out += std::format(
+		"{:-<{}}+{:-<{}}+{:-<{}}+{:-<{}}+{:-<{}}+{:-<{}}\n",
+		"",
+		namW + 1,
+		"",
+		pidW + 2,
+		"",
+		memW + 2,
+		"",
+		treW + 2,
+		"",
+		thrW + 2,
+		"",
+		cpuW + 1
+	);
+	for (const auto &r : rows) {
+		out += std::format(
+			"{:<{}} | {:>{}} | {:>{}} | {:>{}} | {:>{}} | {:>{}}\n",
+			r.name,
+			namW,
+			r.pid,
+			pidW,
+			r.memory,
+			memW,
+			r.treeMemory,
+			treW,
+			r.threads,
+			thrW,
+			r.cpu,
+			cpuW
+		);
+	}
+	std::cout << out;
+}
+
+void Formatter::PrintHandleStats(const HandleCache::Stats &stats) {
+	// stderr, so the stats never mix with output meant for pipes.
+	std::cerr << std::format(
+		"Handle cache: {} hits, {} misses ({} access upgrades), {} evictions\n",
+		stats.Hits,
+		stats.Misses,
+		stats.Upgrades,
+		stats.Evictions
+	);
+}
+
 namespace {
 	template <typename T> static ThreadRow MakeThreadRow(const T &t) {
 		ThreadRow r = {
 			std::to_string(t.info.Tid),
-			Convert::ThreadPriorityToString(t.info.BasePriority),
-			Convert::ThreadStateToString(t.info.ThreadState),
-			(t.info.ThreadState == 5) ? Convert::WaitReasonToString(t.info.WaitReason)
-									  : "",
-			t.Name,
+			std::string(Convert::ThreadPriorityToString(t.info.BasePriority)),
+			std::string(Convert::ThreadStateToString(t.info.ThreadState)),
+			std::string(
+				(t.info.ThreadState == 5) ? Convert::WaitReasonToString(t.info.WaitReason)
+										  : ""
+			),
+			t.Name(),
 			"" /*StartAddress*/
 		};
 		if constexpr (std::is_same_v<T, ThreadAddrInfo>) {
-			r.address = t.StartAddress;
+			r.address = t.StartAddress();
 		}
 		return r;
 	}
@@ -413,7 +865,8 @@ void Formatter::PrintThreadsResult(
 
 	// Re-query fresh thread info to get updated priority/state/reason
 	auto updatedResults = results;
-	auto freshThreads = NtUtils::GetProcessThreads(pid);
+	// (snapshot only: the start addresses were already resolved, no threads opened)
+	auto freshThreads = NtUtils::GetProcessThreads(pid, nullptr);
 	if (freshThreads.has_value()) {
 		std::map<DWORD, ThreadInfo> freshMap;
 		for (const auto &ti : freshThreads.value()) {
@@ -421,7 +874,10 @@ void Formatter::PrintThreadsResult(
 		}
 		for (auto &[t, res] : updatedResults) {
 			auto it = freshMap.find(t.info.Tid);
-			if (it != freshMap.end()) t.info = it->second;
+			if (it == freshMap.end()) continue;
+			t.info.BasePriority = it->second.BasePriority;
+			t.info.ThreadState = it->second.ThreadState;
+			t.info.WaitReason = it->second.WaitReason;
 		}
 	}
 
@@ -477,7 +933,8 @@ void Formatter::PrintThreadsResult(
 
 	// Re-query fresh thread info to get updated priority/state/reason
 	auto updatedResults = results;
-	auto freshThreads = NtUtils::GetProcessThreads(pid);
+	// (snapshot only: the start addresses were already resolved, no threads opened)
+	auto freshThreads = NtUtils::GetProcessThreads(pid, nullptr);
 	if (freshThreads.has_value()) {
 		std::map<DWORD, ThreadInfo> freshMap;
 		for (const auto &ti : freshThreads.value()) {
@@ -485,7 +942,10 @@ void Formatter::PrintThreadsResult(
 		}
 		for (auto &[t, res] : updatedResults) {
 			auto it = freshMap.find(t.info.Tid);
-			if (it != freshMap.end()) t.info = it->second;
+			if (it == freshMap.end()) continue;
+			t.info.BasePriority = it->second.BasePriority;
+			t.info.ThreadState = it->second.ThreadState;
+			t.info.WaitReason = it->second.WaitReason;
 		}
 	}
 
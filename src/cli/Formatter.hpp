@@ -2,8 +2,12 @@
 
 #include <vector>
 
+#include "core/HandleCache.hpp"
 #include "core/NtUtils.hpp"
+#include "core/ProcessTree.hpp"
 #include "core/ProcessUtils.hpp"
+#include "core/Profiler.hpp"
+#include "core/ThreadStats.hpp"
 
 enum class Action
 {
@@ -15,12 +19,24 @@ enum class Action
 
 namespace Formatter {
 	void PrintProcessList(const std::vector<ProcessInfo> &processes);
+	void PrintPids(const std::vector<DWORD> &pids);
+	void PrintProcessTree(const ProcessTreeReport &report);
 	void PrintProcessDetails(const std::vector<ProcessInfo> &processes);
 	void PrintThreads(
 		DWORD pid,
 		std::wstring_view processName,
 		const std::vector<ThreadAddrInfo> &threads
 	);
+	void PrintResolvedThreads(
+		DWORD pid,
+		std::wstring_view processName,
+		const std::vector<ThreadAddrInfo> &threads
+	);
+	void PrintStartAddressReport(const StartAddressReport &report, size_t top);
+	void PrintHotThreads(const HotThreadReport &report);
+	void PrintThreadStateReport(const ThreadStateReport &report, size_t top);
+	void PrintProfileSummary(const Profile &profile, size_t symbolLookups);
+	void PrintHandleStats(const HandleCache::Stats &stats);
 	void PrintCommandResult(
 		const std::pair<ProcessInfo, ResultVoid> &result, Action action
 	);
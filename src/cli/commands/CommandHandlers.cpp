@@ -1,39 +1,151 @@
 #include "CommandHandlers.hpp"
 
 #include <format>
-#include <regex>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
 #include <Windows.h>
 #include <DbgHelp.h>
 
 #include "WinError.hpp"
 #include "StringUtils.hpp"
+#include "core/BulkAction.hpp"
 #include "core/Convert.hpp"
+#include "core/HandleCache.hpp"
 #include "core/NtUtils.hpp"
+#include "core/ProcessTree.hpp"
 #include "core/ProcessUtils.hpp"
+#include "core/Profiler.hpp"
+#include "core/RowFilter.hpp"
+#include "core/Symbols.hpp"
+#include "core/SymbolWorker.hpp"
+#include "core/TargetMatcher.hpp"
+#include "core/ThreadQuery.hpp"
+#include "core/ThreadSampler.hpp"
+#include "core/ThreadStats.hpp"
 #include "cli/Formatter.hpp"
 
-static Result<std::vector<ThreadAddrInfo>, Error> GetMatchingThreads(
-	const std::vector<ThreadAddrInfo> &addrInfoList, std::string_view pattern
-) {
-	std::vector<ThreadAddrInfo> matchedThreads;
+// Validates the -withpriority filter and compiles the thread selection.
+// Prints the reason and returns nullopt when the query is invalid.
+static std::optional<ThreadQueryPlan>
+PlanThreadQuery(ThreadQuery query, std::string_view filterPriority) {
+	if (!filterPriority.empty()) {
+		query.Priority = PriorityFilter::Parse(filterPriority);
+		if (!query.Priority.has_value()) {
+			Formatter::PrintError(
+				std::format("Invalid priority value: {}", filterPriority)
+			);
+			return std::nullopt;
+		}
+	}
 
-	std::regex re;
-	try {
-		re = std::regex(pattern.begin(), pattern.end(), std::regex_constants::icase);
-	} catch (const std::regex_error &) {
-		return Error(std::format("Invalid regex pattern: {}", pattern));
+	auto planResult = ThreadQueryPlan::Compile(std::move(query));
+	if (!planResult.has_value()) {
+		Formatter::PrintError(planResult.error().message, planResult.error().traceback);
+		return std::nullopt;
 	}
+	return std::move(planResult.value());
+}
 
-	for (const auto &t : addrInfoList) {
-		if (std::regex_search(t.StartAddress, re)) {
-			matchedThreads.push_back(t);
+// Builds a TID query for a numeric argument, a name query otherwise.
+static ThreadQuery
+MakeIdOrNameQuery(std::string_view threadIdOrName, std::optional<long> threadIdOpt) {
+	ThreadQuery query;
+	if (threadIdOpt) {
+		query.Tid = static_cast<DWORD>(threadIdOpt.value());
+	} else {
+		query.Name = std::string(threadIdOrName);
+	}
+	return query;
+}
+
+int CommandHandlers::HandleList(bool suspendedOnly, std::string_view where) {
+	std::optional<ProcessFilter> filter;
+	if (!where.empty()) {
+		auto filterResult = ProcessFilter::Compile(where);
+		if (!filterResult.has_value()) {
+			const Error &err = filterResult.error();
+			Formatter::PrintError(err.message, err.traceback);
+			return 1;
 		}
+		filter = std::move(filterResult.value());
+	}
+
+	auto listResult = NtUtils::GetProcessList();
+	if (!listResult.has_value()) {
+		Formatter::PrintError(
+			std::format(
+				"Failed to retrieve process list"
+				"\nCause: {}",
+				listResult.error().message
+			),
+			listResult.error().traceback
+		);
+		return 1;
 	}
 
-	return matchedThreads;
+	auto &processes = listResult.value();
+	if (suspendedOnly) {
+		std::erase_if(processes, [](const ProcessInfo &p) {
+			return !p.Suspended;
+		});
+	}
+	if (filter) {
+		std::erase_if(processes, [&filter](const ProcessInfo &p) {
+			return !filter->Matches(p);
+		});
+	}
+	Formatter::PrintProcessList(processes);
+	return 0;
+}
+
+int CommandHandlers::HandlePids(std::string_view pattern) {
+	auto matcherResult = TargetMatcher::Compile(pattern);
+	if (!matcherResult.has_value()) {
+		const Error &err = matcherResult.error();
+		Formatter::PrintError(err.message, err.traceback);
+		return 1;
+	}
+	const TargetMatcher &matcher = matcherResult.value();
+
+	// Straight off the snapshot buffer: nothing is decoded, copied or looked up.
+	std::vector<DWORD> pids;
+	auto result = NtUtils::ForEachProcess([&](DWORD pid, std::wstring_view name) {
+		if (matcher.Matches(pid, name)) pids.push_back(pid);
+	});
+	if (!result.has_value()) {
+		Formatter::PrintError(result.error().message, result.error().traceback);
+		return 1;
+	}
+
+	Formatter::PrintPids(pids);
+	return pids.empty() ? 1 : 0; // Like pgrep: no match is a failure, silently
 }
 
-int CommandHandlers::HandleList() {
+int CommandHandlers::HandleTree(std::string_view target, std::string_view sortBy) {
+	TreeSort sort = TreeSort::Pid;
+	if (sortBy == "mem") {
+		sort = TreeSort::Memory;
+	} else if (sortBy == "threads") {
+		sort = TreeSort::Threads;
+	} else if (sortBy == "cpu") {
+		sort = TreeSort::Cpu;
+	} else if (sortBy != "pid") {
+		Formatter::PrintError(std::format("Invalid sort column: {}", sortBy));
+		return 1;
+	}
+
+	std::optional<TargetMatcher> matcher;
+	if (!target.empty()) {
+		auto matcherResult = TargetMatcher::Compile(target);
+		if (!matcherResult.has_value()) {
+			const Error &err = matcherResult.error();
+			Formatter::PrintError(err.message, err.traceback);
+			return 1;
+		}
+		matcher = std::move(matcherResult.value());
+	}
+
 	auto listResult = NtUtils::GetProcessList();
 	if (!listResult.has_value()) {
 		Formatter::PrintError(
@@ -46,12 +158,47 @@ int CommandHandlers::HandleList() {
 		);
 		return 1;
 	}
-	Formatter::PrintProcessList(listResult.value());
+
+	auto &processes = listResult.value();
+	std::vector<uint32_t> roots;
+	if (matcher) {
+		for (uint32_t i = 0; i < processes.size(); ++i) {
+			if (matcher->Matches(processes[i].Pid, processes[i].Name)) roots.push_back(i);
+		}
+		if (roots.empty()) {
+			Formatter::PrintError(std::format("No processes matched: \"{}\"", target));
+			return 1;
+		}
+	}
+
+	const auto report = ProcessTree::BuildReport(std::move(processes), roots, sort);
+	Formatter::PrintProcessTree(report);
 	return 0;
 }
 
-int CommandHandlers::HandleKill(std::string_view target) {
-	auto procsResult = ProcessUtils::GetTargetProcesses(target);
+// Runs the action on all targets, printing each batch of results as it completes.
+// Returns the exit code: 1 if any target failed.
+static int RunOnTargets(
+	std::vector<ProcessInfo> targets, const BulkAction::TargetAction &action, Action kind
+) {
+	bool anyError = false;
+	BulkAction::Run(
+		std::move(targets),
+		action,
+		[&anyError, kind](std::span<const BulkAction::Outcome> done) {
+			for (const auto &res : done) {
+				if (!res.second.has_value()) anyError = true;
+				Formatter::PrintCommandResult(res, kind);
+			}
+		}
+	);
+	return anyError ? 1 : 0;
+}
+
+int CommandHandlers::HandleKill(
+	std::string_view target, const TargetOptions &options
+) {
+	auto procsResult = ProcessUtils::GetTargetProcesses(target, options);
 	if (!procsResult.has_value()) {
 		Formatter::PrintError(
 			std::format(
@@ -65,25 +212,20 @@ int CommandHandlers::HandleKill(std::string_view target) {
 		return 1;
 	}
 
-	bool anyError = false;
-
-	for (const auto &proc : procsResult.value()) {
-		HANDLE hProcess = OpenProcess(PROCESS_TERMINATE, FALSE, proc.Pid);
+	auto terminate = [](const ProcessInfo &proc) -> ResultVoid {
+		auto hProcess = HandleCache::Shared().Process(proc.Pid, PROCESS_TERMINATE);
 		if (!hProcess) {
-			Error err = WinErr(
-				GetLastError(),
+			return Error(
 				std::format(
-					"Failed to open process \"{}\" with PID {}",
+					"Failed to open process \"{}\" with PID {}\nCause: {}",
 					StringUtils::WstrToString(proc.Name),
-					proc.Pid
+					proc.Pid,
+					hProcess.error().message
 				)
 			);
-			Formatter::PrintCommandResult({proc, err}, Action::Terminate);
-			anyError = true;
-			continue;
 		}
-		if (!TerminateProcess(hProcess, 0)) {
-			Error err = WinErr(
+		if (!TerminateProcess(hProcess.value().get(), 0)) {
+			return WinErr(
 				GetLastError(),
 				std::format(
 					"Failed to terminate process \"{}\" with PID {}",
@@ -91,14 +233,10 @@ int CommandHandlers::HandleKill(std::string_view target) {
 					proc.Pid
 				)
 			);
-			Formatter::PrintCommandResult({proc, err}, Action::Terminate);
-			anyError = true;
-		} else {
-			Formatter::PrintCommandResult({proc, std::monostate{}}, Action::Terminate);
 		}
-		CloseHandle(hProcess);
-	}
-	return anyError ? 1 : 0;
+		return std::monostate{};
+	};
+	return RunOnTargets(std::move(procsResult.value()), terminate, Action::Terminate);
 }
 
 int CommandHandlers::HandleQuery(std::string_view target) {
@@ -119,9 +257,132 @@ int CommandHandlers::HandleQuery(std::string_view target) {
 	return 0;
 }
 
+static void UpgradeStartAddresses(
+	std::vector<std::pair<ProcessInfo, std::vector<ThreadAddrInfo>>> &pending,
+	std::vector<Symbols::ResolveRequest> requests,
+	std::chrono::milliseconds budget
+) {
+	Symbols::AsyncResolver resolver(std::move(requests));
+	const auto deadline = std::chrono::steady_clock::now() + budget;
+
+	// Each process's table is printed as soon as its names are in; once the
+	// budget runs out, the rest are printed with whatever has resolved.
+	bool complete = true;
+	size_t unresolved = 0;
+	for (size_t i = 0; i < pending.size(); ++i) {
+		auto &[proc, threads] = pending[i];
+		if (complete) complete = resolver.WaitFor(i, deadline);
+		const auto symbols = resolver.Results(i);
+
+		bool anyResolved = false;
+		for (size_t j = 0; j < threads.size(); ++j) {
+			if (!symbols[j].has_value()) {
+				++unresolved;
+				continue;
+			}
+			if (!symbols[j]->empty()) threads[j].SetStartAddress(symbols[j].value());
+			anyResolved = true;
+		}
+
+		if (anyResolved) Formatter::PrintResolvedThreads(proc.Pid, proc.Name, threads);
+	}
+
+	if (!complete) {
+		Formatter::PrintWarning(
+			std::format(
+				"Symbol budget of {} ms expired, {} start addresses left unresolved.",
+				budget.count(),
+				unresolved
+			)
+		);
+	}
+}
+
+static void ResolveWithWorkers(
+	std::vector<std::pair<ProcessInfo, std::vector<ThreadAddrInfo>>> &pending,
+	const std::vector<Symbols::ResolveRequest> &requests,
+	size_t workers
+) {
+	SymbolWorker::Pool pool(workers, SymbolWorker::LaunchProcessWorker);
+	auto results = pool.ResolveAll(requests);
+
+	for (size_t i = 0; i < pending.size(); ++i) {
+		auto &[proc, threads] = pending[i];
+		if (!results[i].has_value()) {
+			Formatter::PrintWarning(
+				std::format(
+					"Symbol resolution failed for {} (PID: {}), showing module offsets"
+					"\nCause: {}",
+					StringUtils::WstrToString(proc.Name),
+					proc.Pid,
+					results[i].error().message
+				)
+			);
+		} else {
+			const auto &symbols = results[i].value();
+			for (size_t j = 0; j < threads.size(); ++j) {
+				if (!symbols[j].empty()) threads[j].SetStartAddress(symbols[j]);
+			}
+		}
+		Formatter::PrintThreads(proc.Pid, proc.Name, threads);
+	}
+}
+
+// Orders threads by a table column: TID ascending, everything else busiest first.
+static void SortThreads(std::vector<ThreadAddrInfo> &threads, std::string_view sortBy) {
+	auto descending = [&threads](auto key) {
+		std::stable_sort(
+			threads.begin(),
+			threads.end(),
+			[&key](const ThreadAddrInfo &a, const ThreadAddrInfo &b) {
+				return key(a) > key(b);
+			}
+		);
+	};
+
+	if (sortBy == "tid") {
+		std::stable_sort(
+			threads.begin(),
+			threads.end(),
+			[](const ThreadAddrInfo &a, const ThreadAddrInfo &b) {
+				return a.info.Tid < b.info.Tid;
+			}
+		);
+	} else if (sortBy == "priority") {
+		descending([](const ThreadAddrInfo &t) {
+			return t.info.BasePriority;
+		});
+	} else if (sortBy == "cpu") {
+		descending([](const ThreadAddrInfo &t) {
+			return t.activity ? t.activity->CpuPercent : 0.0;
+		});
+	} else if (sortBy == "csw") {
+		descending([](const ThreadAddrInfo &t) {
+			return t.activity ? t.activity->ContextSwitchesPerSec : 0.0;
+		});
+	}
+}
+
 int CommandHandlers::HandleQueryThread(
-	std::string_view target, std::string_view threadIdOrName, bool queryAll
+	std::string_view target,
+	std::string_view threadIdOrName,
+	bool queryAll,
+	std::string_view where,
+	const SymbolOptions &symbolOptions,
+	const SampleOptions &sampleOptions
 ) {
+	std::optional<ThreadFilter> filter;
+	if (!where.empty()) {
+		const bool sampled = sampleOptions.Interval.has_value();
+		auto filterResult = ThreadFilter::Compile(where, sampled);
+		if (!filterResult.has_value()) {
+			const Error &err = filterResult.error();
+			Formatter::PrintError(err.message, err.traceback);
+			return 1;
+		}
+		filter = std::move(filterResult.value());
+	}
+
 	auto procsResult = ProcessUtils::GetTargetProcesses(target);
 	if (!procsResult.has_value()) {
 		Formatter::PrintError(
@@ -145,9 +406,42 @@ int CommandHandlers::HandleQueryThread(
 	const auto threadIdOpt = StringUtils::TryParseInt(threadIdOrName);
 	bool anyError = false;
 	bool foundAny = false;
+	bool filteredOut = false;
+
+	// With a symbol budget, threads are printed as module+offset right away and
+	// symbol names are resolved in the background afterwards. With workers,
+	// symbols for all processes are resolved together in the worker pool.
+	const auto &symbolBudget = symbolOptions.Budget;
+	const bool deferSymbols = symbolBudget.has_value() || symbolOptions.Workers > 0;
+	std::vector<std::pair<ProcessInfo, std::vector<ThreadAddrInfo>>> pending;
+	std::vector<Symbols::ResolveRequest> requests;
+
+	auto threadHandles = std::make_shared<ThreadHandles>(
+		THREAD_QUERY_INFORMATION | THREAD_QUERY_LIMITED_INFORMATION
+	);
+
+	// Both snapshots cover the whole system, so all targets share one interval.
+	std::optional<ThreadActivityMap> activity;
+	if (sampleOptions.Interval) {
+		auto sampleResult = ThreadSampler::Sample(sampleOptions.Interval.value());
+		if (!sampleResult.has_value()) {
+			Formatter::PrintError(
+				std::format(
+					"Failed to sample thread activity"
+					"\nCause: {}",
+					sampleResult.error().message
+				),
+				sampleResult.error().traceback
+			);
+			return 1;
+		}
+		activity = std::move(sampleResult.value().Activity);
+	}
 
 	for (const auto &proc : procsResult.value()) {
-		auto addrInfoResult = ProcessUtils::GetThreadStartAddresses(proc.Pid);
+		// Columns are lazy: matching by TID reads only the kernel snapshot, matching
+		// by name never symbolizes, and only the matched threads get start addresses.
+		auto addrInfoResult = ProcessUtils::GetThreads(proc.Pid, threadHandles);
 		if (!addrInfoResult.has_value()) {
 			Formatter::PrintError(
 				std::format(
@@ -168,12 +462,14 @@ int CommandHandlers::HandleQueryThread(
 
 		bool found = queryAll;
 
+		if (queryAll || !threadIdOpt) ProcessUtils::PrefetchNames(addrInfoList);
+
 		if (queryAll) {
 			matchedThreads = addrInfoList;
 		} else if (!threadIdOrName.empty()) {
 			for (const auto &t : addrInfoList) {
 				if (threadIdOpt ? t.info.Tid == static_cast<DWORD>(threadIdOpt.value())
-								: t.Name == threadIdOrName) {
+								: t.Name() == threadIdOrName) {
 					found = true;
 					matchedThreads.push_back(t);
 					if (!threadIdOpt) break;
@@ -181,13 +477,72 @@ int CommandHandlers::HandleQueryThread(
 			}
 		}
 
-		if (found) Formatter::PrintThreads(proc.Pid, proc.Name, matchedThreads);
-		if (found) foundAny = true;
+		if (activity) {
+			for (auto &t : matchedThreads) {
+				auto it = activity->find(ThreadKey::Of(t.info));
+				// Missing if the thread started after the second snapshot, including
+				// a new thread that reused the TID of a sampled one.
+				t.activity = it != activity->end() ? it->second : ThreadActivity{};
+			}
+		}
+
+		if (filter) {
+			// Names were only prefetched above when matching by name or listing all.
+			if (filter->UsesName() && threadIdOpt && !queryAll) {
+				ProcessUtils::PrefetchNames(matchedThreads);
+			}
+			std::erase_if(matchedThreads, [&filter](const ThreadAddrInfo &t) {
+				return !filter->Matches(t);
+			});
+			filteredOut = filteredOut || (found && matchedThreads.empty());
+			found = found && !matchedThreads.empty();
+		}
+
+		if (!found) continue;
+		foundAny = true;
+
+		SortThreads(matchedThreads, sampleOptions.SortBy);
+
+		if (deferSymbols) ProcessUtils::FormatModuleAddresses(proc.Pid, matchedThreads);
+
+		if (!deferSymbols || symbolBudget) {
+			Formatter::PrintThreads(proc.Pid, proc.Name, matchedThreads);
+			std::cout.flush();
+		}
+
+		if (deferSymbols) {
+			Symbols::ResolveRequest request{proc.Pid, {}};
+			for (const auto &t : matchedThreads) {
+				request.Addresses.push_back(t.Address());
+			}
+			requests.push_back(std::move(request));
+			pending.push_back({proc, std::move(matchedThreads)});
+		}
+	}
+
+	if (!requests.empty()) {
+		if (symbolBudget) {
+			UpgradeStartAddresses(pending, std::move(requests), symbolBudget.value());
+		} else {
+			ResolveWithWorkers(pending, requests, symbolOptions.Workers);
+		}
 	}
 
 	if (!foundAny) {
 		ProcessInfo proc = procsResult.value().front();
 
+		if (filteredOut) {
+			Formatter::PrintError(
+				std::format(
+					"No threads matched --where \"{}\" for {} (PID: {}).",
+					where,
+					StringUtils::WstrToString(proc.Name),
+					proc.Pid
+				)
+			);
+			return 1;
+		}
+
 		Formatter::PrintError(
 			std::format(
 				"No threads matched {} \"{}\" for {} (PID: {}).",
@@ -204,7 +559,93 @@ int CommandHandlers::HandleQueryThread(
 	return anyError ? 1 : 0;
 }
 
-int CommandHandlers::HandleSuspend(std::string_view target) {
+int CommandHandlers::HandleThreads(
+	std::string_view groupBy, size_t top, size_t symbolWorkers
+) {
+	const std::string key = StringUtils::Normalize(groupBy);
+	if (key != "start" && key != "state") {
+		Formatter::PrintError(
+			std::format(
+				"Unsupported --group-by value: {} (expected: start, state)", groupBy
+			)
+		);
+		return 1;
+	}
+
+	auto result = ProcessUtils::EnableDebugPrivilege(GetCurrentProcess());
+	if (!result.has_value()) {
+		const Error &err = result.error();
+		Formatter::PrintWarning(err.message, err.traceback + "\n");
+	}
+
+	if (key == "state") {
+		// Reads only the kernel snapshot: no handles, no symbols.
+		auto stateResult = ThreadStats::GroupByState();
+		if (!stateResult.has_value()) {
+			Formatter::PrintError(
+				std::format(
+					"Failed to aggregate thread states"
+					"\nCause: {}",
+					stateResult.error().message
+				),
+				stateResult.error().traceback
+			);
+			return 1;
+		}
+
+		Formatter::PrintThreadStateReport(stateResult.value(), top);
+		return 0;
+	}
+
+	auto reportResult = ThreadStats::GroupByStartAddress(symbolWorkers);
+	if (!reportResult.has_value()) {
+		Formatter::PrintError(
+			std::format(
+				"Failed to aggregate thread start addresses"
+				"\nCause: {}",
+				reportResult.error().message
+			),
+			reportResult.error().traceback
+		);
+		return 1;
+	}
+
+	Formatter::PrintStartAddressReport(reportResult.value(), top);
+	return 0;
+}
+
+int CommandHandlers::HandleHot(
+	std::chrono::milliseconds interval, size_t top, size_t symbolWorkers
+) {
+	auto result = ProcessUtils::EnableDebugPrivilege(GetCurrentProcess());
+	if (!result.has_value()) {
+		const Error &err = result.error();
+		Formatter::PrintWarning(err.message, err.traceback + "\n");
+	}
+
+	auto reportResult = ThreadStats::TopByCpu(interval, top, symbolWorkers);
+	if (!reportResult.has_value()) {
+		Formatter::PrintError(
+			std::format(
+				"Failed to sample thread CPU usage"
+				"\nCause: {}",
+				reportResult.error().message
+			),
+			reportResult.error().traceback
+		);
+		return 1;
+	}
+
+	Formatter::PrintHotThreads(reportResult.value());
+	return 0;
+}
+
+int CommandHandlers::HandleProfile(
+	std::string_view target,
+	const ProfileOptions &options,
+	size_t symbolWorkers,
+	std::string_view outputPath
+) {
 	auto procsResult = ProcessUtils::GetTargetProcesses(target);
 	if (!procsResult.has_value()) {
 		Formatter::PrintError(
@@ -218,24 +659,59 @@ int CommandHandlers::HandleSuspend(std::string_view target) {
 		);
 		return 1;
 	}
+	if (procsResult.value().size() > 1) {
+		Formatter::PrintError(std::format(
+			"Target \"{}\" matches {} processes, profile one PID at a time",
+			target,
+			procsResult.value().size()
+		));
+		return 1;
+	}
+	const ProcessInfo &proc = procsResult.value().front();
 
-	std::vector<std::pair<ProcessInfo, ResultVoid>> results{};
+	auto result = ProcessUtils::EnableDebugPrivilege(GetCurrentProcess());
+	if (!result.has_value()) {
+		const Error &err = result.error();
+		Formatter::PrintWarning(err.message, err.traceback + "\n");
+	}
 
-	for (const auto &proc : procsResult.value()) {
-		auto res = NtUtils::SuspendProcess(proc.Pid);
-		results.push_back({proc, res});
+	std::ofstream file;
+	if (!outputPath.empty()) {
+		file.open(std::string(outputPath), std::ios::binary);
+		if (!file) {
+			Formatter::PrintError(std::format("Failed to open output file: {}", outputPath));
+			return 1;
+		}
 	}
 
-	bool anyError = false;
-	for (const auto &res : results) {
-		if (!res.second.has_value()) anyError = true;
-		Formatter::PrintCommandResult(res, Action::Suspend);
+	auto profileResult = Profiler::Run(proc.Pid, options);
+	if (!profileResult.has_value()) {
+		Formatter::PrintError(
+			std::format(
+				"Failed to profile process \"{}\" with PID {}"
+				"\nCause: {}",
+				StringUtils::WstrToString(proc.Name),
+				proc.Pid,
+				profileResult.error().message
+			),
+			profileResult.error().traceback
+		);
+		return 1;
 	}
-	return anyError ? 1 : 0;
+
+	size_t symbolLookups = 0;
+	const std::string folded =
+		Profiler::Fold(profileResult.value(), symbolWorkers, symbolLookups);
+	(outputPath.empty() ? std::cout : file) << folded;
+
+	Formatter::PrintProfileSummary(profileResult.value(), symbolLookups);
+	return 0;
 }
 
-int CommandHandlers::HandleResume(std::string_view target) {
-	auto procsResult = ProcessUtils::GetTargetProcesses(target);
+int CommandHandlers::HandleSuspend(
+	std::string_view target, const TargetOptions &options
+) {
+	auto procsResult = ProcessUtils::GetTargetProcesses(target, options);
 	if (!procsResult.has_value()) {
 		Formatter::PrintError(
 			std::format(
@@ -249,23 +725,40 @@ int CommandHandlers::HandleResume(std::string_view target) {
 		return 1;
 	}
 
-	std::vector<std::pair<ProcessInfo, ResultVoid>> results{};
+	return RunOnTargets(
+		std::move(procsResult.value()),
+		[](const ProcessInfo &proc) { return NtUtils::SuspendProcess(proc.Pid); },
+		Action::Suspend
+	);
+}
 
-	for (const auto &proc : procsResult.value()) {
-		auto res = NtUtils::ResumeProcess(proc.Pid);
-		results.push_back({proc, res});
+int CommandHandlers::HandleResume(
+	std::string_view target, const TargetOptions &options
+) {
+	auto procsResult = ProcessUtils::GetTargetProcesses(target, options);
+	if (!procsResult.has_value()) {
+		Formatter::PrintError(
+			std::format(
+				"Failed to resolve target: \"{}\""
+				"\nReason: {}",
+				target,
+				procsResult.error().message
+			),
+			procsResult.error().traceback
+		);
+		return 1;
 	}
 
-	bool anyError = false;
-	for (const auto &res : results) {
-		if (!res.second.has_value()) anyError = true;
-		Formatter::PrintCommandResult(res, Action::Resume);
-	}
-	return anyError ? 1 : 0;
+	return RunOnTargets(
+		std::move(procsResult.value()),
+		[](const ProcessInfo &proc) { return NtUtils::ResumeProcess(proc.Pid); },
+		Action::Resume
+	);
 }
 
-static bool SuspendThreadById(DWORD tid, const ProcessInfo &proc) {
-	ResultVoid result = ProcessUtils::SuspendThread(tid);
+static bool
+SuspendThreadById(ThreadHandles &handles, DWORD tid, const ProcessInfo &proc) {
+	ResultVoid result = ProcessUtils::SuspendThread(handles, tid);
 
 	if (result.has_value()) {
 		Formatter::PrintSuccess(
@@ -283,8 +776,8 @@ static bool SuspendThreadById(DWORD tid, const ProcessInfo &proc) {
 	return result.has_value();
 }
 
-static bool ResumeThreadById(DWORD tid, const ProcessInfo &proc) {
-	ResultVoid result = ProcessUtils::ResumeThread(tid);
+static bool ResumeThreadById(ThreadHandles &handles, DWORD tid, const ProcessInfo &proc) {
+	ResultVoid result = ProcessUtils::ResumeThread(handles, tid);
 
 	if (result.has_value()) {
 		Formatter::PrintSuccess(
@@ -304,12 +797,14 @@ static bool ResumeThreadById(DWORD tid, const ProcessInfo &proc) {
 }
 
 static bool inline SuspendThreadsByName(
-	const std::vector<ThreadNameInfo> &matchedThreads, const ProcessInfo &proc
+	ThreadHandles &handles,
+	const std::vector<ThreadAddrInfo> &matchedThreads,
+	const ProcessInfo &proc
 ) {
 	bool allOk = true;
 	std::vector<std::pair<ThreadNameInfo, ResultVoid>> results;
 	for (const auto &matchedInfo : matchedThreads) {
-		auto result = ProcessUtils::SuspendThread(matchedInfo.info.Tid);
+		auto result = ProcessUtils::SuspendThread(handles, matchedInfo.info.Tid);
 		if (!result.has_value()) allOk = false;
 		results.push_back({matchedInfo, result});
 	}
@@ -319,12 +814,14 @@ static bool inline SuspendThreadsByName(
 }
 
 static bool inline ResumeThreadsByName(
-	const std::vector<ThreadNameInfo> &matchedThreads, const ProcessInfo &proc
+	ThreadHandles &handles,
+	const std::vector<ThreadAddrInfo> &matchedThreads,
+	const ProcessInfo &proc
 ) {
 	bool allOk = true;
 	std::vector<std::pair<ThreadNameInfo, ResultVoid>> results;
 	for (const auto &matchedInfo : matchedThreads) {
-		auto res = ProcessUtils::ResumeThread(matchedInfo.info.Tid);
+		auto res = ProcessUtils::ResumeThread(handles, matchedInfo.info.Tid);
 		if (!res.has_value()) allOk = false;
 		results.push_back({matchedInfo, res});
 	}
@@ -353,85 +850,52 @@ int CommandHandlers::HandleSuspendThread(
 	}
 
 	const auto threadIdOpt = StringUtils::TryParseInt(threadIdOrName);
-	const auto filterPrioOpt = StringUtils::TryParseInt(filterPriority);
-	const std::string filterPrioNorm = StringUtils::Normalize(filterPriority);
+	auto plan =
+		PlanThreadQuery(MakeIdOrNameQuery(threadIdOrName, threadIdOpt), filterPriority);
+	if (!plan) return 1;
 
-	// Validate priority value is valid string or parsable number.
-	if (!filterPriority.empty() && !filterPrioOpt.has_value()) {
-		auto pRes = Convert::ParseThreadPriority(filterPriority);
-		if (!pRes.has_value()) {
-			Formatter::PrintError(
-				std::format("Invalid priority value: {}", filterPriority)
-			);
-			return 1;
-		}
-	}
+	// One handle per thread, shared by the name/address queries and the action.
+	auto threadHandles =
+		std::make_shared<ThreadHandles>(THREAD_QUERY_INFORMATION | THREAD_SUSPEND_RESUME);
 
 	if (threadIdOpt && procsResult.value().size() == 1 && filterPriority.empty()) {
 		const auto &proc = procsResult.value().front();
 		const DWORD tid = static_cast<DWORD>(threadIdOpt.value());
-		return SuspendThreadById(tid, proc) ? 0 : 1;
+		return SuspendThreadById(*threadHandles, tid, proc) ? 0 : 1;
 	}
 
 	bool foundAny = false;
 	bool anyError = false;
-	bool threadFound = false;
+	bool priorityExcluded = false;
 
 	for (const auto &proc : procsResult.value()) {
-		auto nameInfoResult = ProcessUtils::GetThreadNames(proc.Pid);
-		if (!nameInfoResult.has_value()) {
+		auto selectionResult = plan->Select(proc.Pid, threadHandles);
+		if (!selectionResult.has_value()) {
 			Formatter::PrintError(
 				std::format(
 					"Failed to get thread names for {} (PID: {})"
 					"\nReason: {}",
 					StringUtils::WstrToString(proc.Name),
 					proc.Pid,
-					nameInfoResult.error().message
+					selectionResult.error().message
 				),
-				nameInfoResult.error().traceback
+				selectionResult.error().traceback
 			);
 			anyError = true;
 			continue;
 		}
 
-		// Find threads by thread Id or thread name
-		std::vector<ThreadNameInfo> matchedThreads;
-		for (const auto &threadInfo : nameInfoResult.value()) {
-			if (
-				threadIdOpt
-					? threadInfo.info.Tid == static_cast<DWORD>(threadIdOpt.value())
-					: threadInfo.Name == threadIdOrName
-				//
-			) {
-				threadFound = true;
-				// Filter by priority if specified
-				if (!filterPriority.empty()) {
-					if (filterPrioOpt.has_value()) {
-						if (threadInfo.info.BasePriority !=
-							static_cast<LONG>(filterPrioOpt.value())) {
-							continue;
-						}
-					} else {
-						const std::string basePriority = StringUtils::Normalize(
-							Convert::ThreadPriorityToString(threadInfo.info.BasePriority)
-						);
-						if (basePriority != filterPrioNorm) continue;
-					}
-				}
-
-				matchedThreads.push_back(threadInfo);
-				// Thread Id is unique, so we can break after finding it.
-				if (threadIdOpt.has_value()) break;
-			}
-		}
+		const ThreadSelection &selection = selectionResult.value();
+		if (selection.PriorityExcluded) priorityExcluded = true;
 
+		const std::vector<ThreadAddrInfo> &matchedThreads = selection.Threads;
 		if (!matchedThreads.empty()) {
 			bool ok;
 			if (threadIdOpt) {
 				const DWORD tid = static_cast<DWORD>(threadIdOpt.value());
-				ok = SuspendThreadById(tid, proc);
+				ok = SuspendThreadById(*threadHandles, tid, proc);
 			} else {
-				ok = SuspendThreadsByName(matchedThreads, proc);
+				ok = SuspendThreadsByName(*threadHandles, matchedThreads, proc);
 			}
 			if (!ok) anyError = true;
 			foundAny = true;
@@ -441,7 +905,7 @@ int CommandHandlers::HandleSuspendThread(
 	if (!foundAny) {
 		ProcessInfo proc = procsResult.value().front();
 
-		if (threadFound && !filterPriority.empty()) {
+		if (priorityExcluded) {
 			Formatter::PrintError(
 				std::format(
 					"No threads matched {} '{}' with priority '{}' for {} (PID: {})",
@@ -489,84 +953,52 @@ int CommandHandlers::HandleResumeThread(
 	}
 
 	const auto threadIdOpt = StringUtils::TryParseInt(threadIdOrName);
-	const auto filterPrioOpt = StringUtils::TryParseInt(filterPriority);
-	const std::string filterPrioNorm = StringUtils::Normalize(filterPriority);
+	auto plan =
+		PlanThreadQuery(MakeIdOrNameQuery(threadIdOrName, threadIdOpt), filterPriority);
+	if (!plan) return 1;
 
-	// Validate priority value is valid string or parsable number.
-	if (!filterPriority.empty() && !filterPrioOpt.has_value()) {
-		auto pRes = Convert::ParseThreadPriority(filterPriority);
-		if (!pRes.has_value()) {
-			Formatter::PrintError(
-				std::format("Invalid priority value: {}", filterPriority)
-			);
-			return 1;
-		}
-	}
+	// One handle per thread, shared by the name/address queries and the action.
+	auto threadHandles =
+		std::make_shared<ThreadHandles>(THREAD_QUERY_INFORMATION | THREAD_SUSPEND_RESUME);
 
 	if (threadIdOpt && procsResult.value().size() == 1 && filterPriority.empty()) {
 		const auto &proc = procsResult.value().front();
 		const DWORD tid = static_cast<DWORD>(threadIdOpt.value());
-		return ResumeThreadById(tid, proc) ? 0 : 1;
+		return ResumeThreadById(*threadHandles, tid, proc) ? 0 : 1;
 	}
 
 	bool foundAny = false;
 	bool anyError = false;
-	bool threadFound = false;
+	bool priorityExcluded = false;
 
 	for (const auto &proc : procsResult.value()) {
-		auto nameInfoResult = ProcessUtils::GetThreadNames(proc.Pid);
-		if (!nameInfoResult.has_value()) {
+		auto selectionResult = plan->Select(proc.Pid, threadHandles);
+		if (!selectionResult.has_value()) {
 			Formatter::PrintError(
 				std::format(
 					"Failed to get thread names for {} (PID: {})"
 					"\nReason: {}",
 					StringUtils::WstrToString(proc.Name),
 					proc.Pid,
-					nameInfoResult.error().message
+					selectionResult.error().message
 				),
-				nameInfoResult.error().traceback
+				selectionResult.error().traceback
 			);
 			anyError = true;
 			continue;
 		}
 
-		// Find thread by Id or thread Name
-		std::vector<ThreadNameInfo> matchedThreads;
-		for (const ThreadNameInfo &threadInfo : nameInfoResult.value()) {
-			if (
-				threadIdOpt
-					? threadInfo.info.Tid == static_cast<DWORD>(threadIdOpt.value())
-					: threadInfo.Name == threadIdOrName
-				//
-			) {
-				threadFound = true;
-				// Filter by priority if specified
-				if (!filterPriority.empty()) {
-					if (filterPrioOpt.has_value()) {
-						if (threadInfo.info.BasePriority !=
-							static_cast<LONG>(filterPrioOpt.value())) {
-							continue;
-						}
-					} else {
-						const std::string basePriority = StringUtils::Normalize(
-							Convert::ThreadPriorityToString(threadInfo.info.BasePriority)
-						);
-						if (basePriority != filterPrioNorm) continue;
-					}
-				}
-
-				matchedThreads.push_back(threadInfo);
-				if (threadIdOpt.has_value()) break;
-			}
-		}
+		const ThreadSelection &selection = selectionResult.value();
+		if (selection.PriorityExcluded) priorityExcluded = true;
 
+		const std::vector<ThreadAddrInfo> &matchedThreads = selection.Threads;
 		if (!matchedThreads.empty()) {
 			bool ok;
 			if (threadIdOpt) {
 				const DWORD tid = static_cast<DWORD>(threadIdOpt.value());
-				ok = ResumeThreadById(tid, proc);
+				ok = ResumeThreadById(*threadHandles, tid, proc);
 			} else {
-				ok = ResumeThreadsByName(matchedThreads, proc);
+				ok = ResumeThreadsByName(*threadHandles, matchedThreads, proc);
 			}
 			if (!ok) anyError = true;
 			foundAny = true;
@@ -576,7 +1008,7 @@ int CommandHandlers::HandleResumeThread(
 	if (!foundAny) {
 		ProcessInfo proc = procsResult.value().front();
 
-		if (threadFound && !filterPriority.empty()) {
+		if (priorityExcluded) {
 			Formatter::PrintError(
 				std::format(
 					"No threads matched {} '{}' with priority '{}' for {} (PID: {})",
@@ -591,7 +1023,7 @@ int CommandHandlers::HandleResumeThread(
 			Formatter::PrintError(
 				std::format(
 					"No threads matched {} '{}' for {} (PID: {})",
-					threadIdOpt ? "TID" : "name",
+					threadIdOpt.has_value() ? "TID" : "name",
 					threadIdOrName,
 					StringUtils::WstrToString(proc.Name),
 					proc.Pid
@@ -623,19 +1055,10 @@ int CommandHandlers::HandleSuspendThreadByAddr(
 		return 1;
 	}
 
-	const auto filterPrioOpt = StringUtils::TryParseInt(filterPriority);
-	const std::string filterPrioNorm = StringUtils::Normalize(filterPriority);
-
-	// Validate priority value is valid string or parsable number.
-	if (!filterPriority.empty() && !filterPrioOpt.has_value()) {
-		auto pRes = Convert::ParseThreadPriority(filterPriority);
-		if (!pRes.has_value()) {
-			Formatter::PrintError(
-				std::format("Invalid priority value: {}", filterPriority)
-			);
-			return 1;
-		}
-	}
+	ThreadQuery query;
+	query.AddressPattern = std::string(threadAddrRegex);
+	auto plan = PlanThreadQuery(std::move(query), filterPriority);
+	if (!plan) return 1;
 
 	ResultVoid result = ProcessUtils::EnableDebugPrivilege(GetCurrentProcess());
 	if (!result.has_value()) {
@@ -650,85 +1073,52 @@ int CommandHandlers::HandleSuspendThreadByAddr(
 		return 1;
 	}
 
+	// One handle per thread, shared by the name/address queries and the action.
+	auto threadHandles =
+		std::make_shared<ThreadHandles>(THREAD_QUERY_INFORMATION | THREAD_SUSPEND_RESUME);
+
 	bool foundAny = false;
 	bool anyError = false;
-	bool patternMatched = false;
+	bool priorityExcluded = false;
 
 	for (const auto &proc : procsResult.value()) {
-		auto addrInfoResult = ProcessUtils::GetThreadStartAddresses(proc.Pid);
-		if (!addrInfoResult.has_value()) {
+		auto selectionResult = plan->Select(proc.Pid, threadHandles);
+		if (!selectionResult.has_value()) {
 			Formatter::PrintError(
 				std::format(
 					"Failed to get thread start addresses for {} (PID: {})"
 					"\nCause: {}",
 					StringUtils::WstrToString(proc.Name),
 					proc.Pid,
-					addrInfoResult.error().message
+					selectionResult.error().message
 				),
-				addrInfoResult.error().traceback
+				selectionResult.error().traceback
 			);
 			anyError = true;
 			continue;
 		}
 
-		auto matchedResult = GetMatchingThreads(addrInfoResult.value(), threadAddrRegex);
-		if (!matchedResult.has_value()) {
-			Formatter::PrintError(
-				std::format(
-					"Failed to get thread start addresses for {} (PID: {})"
-					"\nReason: {}",
-					StringUtils::WstrToString(proc.Name),
-					proc.Pid,
-					matchedResult.error().message
-				),
-				matchedResult.error().traceback
-			);
-			anyError = true;
-			continue;
-		}
+		const ThreadSelection &selection = selectionResult.value();
+		if (selection.PriorityExcluded) priorityExcluded = true;
+		if (selection.Threads.empty()) continue;
 
-		const std::vector<ThreadAddrInfo> matchedThreads = matchedResult.value();
-		if (!matchedThreads.empty()) patternMatched = true;
-
-		std::vector<ThreadAddrInfo> filteredThreads;
-		if (filterPriority.empty()) {
-			filteredThreads = matchedThreads;
-		} else {
-			// Filter threads by priority when specified
-			for (const auto &matchedInfo : matchedThreads) {
-				if (filterPrioOpt.has_value()) {
-					if (matchedInfo.info.BasePriority !=
-						static_cast<LONG>(filterPrioOpt.value())) {
-						continue;
-					}
-				} else {
-					const std::string basePriority = StringUtils::Normalize(
-						Convert::ThreadPriorityToString(matchedInfo.info.BasePriority)
-					);
-					if (basePriority != filterPrioNorm) continue;
-				}
-				filteredThreads.push_back(matchedInfo);
-			}
-		}
+		ProcessUtils::PrefetchNames(selection.Threads);
 
 		std::vector<std::pair<ThreadAddrInfo, ResultVoid>> results;
-
-		for (const auto &matchedInfo : filteredThreads) {
-			auto res = ProcessUtils::SuspendThread(matchedInfo.info.Tid);
+		for (const auto &matchedInfo : selection.Threads) {
+			auto res = ProcessUtils::SuspendThread(*threadHandles, matchedInfo.info.Tid);
 			if (!res.has_value()) anyError = true;
 			results.push_back({matchedInfo, res});
 		}
 
-		if (!filteredThreads.empty()) {
-			Formatter::PrintThreadsResult(proc.Pid, proc.Name, Action::Suspend, results);
-			foundAny = true;
-		}
+		Formatter::PrintThreadsResult(proc.Pid, proc.Name, Action::Suspend, results);
+		foundAny = true;
 	}
 
 	if (!foundAny) {
 		ProcessInfo proc = procsResult.value().front();
 
-		if (patternMatched && !filterPriority.empty()) {
+		if (priorityExcluded) {
 			Formatter::PrintError(
 				std::format(
 					"No threads matched pattern '{}' with priority '{}' "
@@ -774,19 +1164,10 @@ int CommandHandlers::HandleResumeThreadByAddr(
 		return 1;
 	}
 
-	const auto filterPrioOpt = StringUtils::TryParseInt(filterPriority);
-	const std::string filterPrioNorm = StringUtils::Normalize(filterPriority);
-
-	// Validate priority value is valid string or parsable number.
-	if (!filterPriority.empty() && !filterPrioOpt.has_value()) {
-		auto pRes = Convert::ParseThreadPriority(filterPriority);
-		if (!pRes.has_value()) {
-			Formatter::PrintError(
-				std::format("Invalid priority value: {}", filterPriority)
-			);
-			return 1;
-		}
-	}
+	ThreadQuery query;
+	query.AddressPattern = std::string(threadAddrRegex);
+	auto plan = PlanThreadQuery(std::move(query), filterPriority);
+	if (!plan) return 1;
 
 	ResultVoid result = ProcessUtils::EnableDebugPrivilege(GetCurrentProcess());
 	if (!result.has_value()) {
@@ -801,86 +1182,52 @@ int CommandHandlers::HandleResumeThreadByAddr(
 		return 1;
 	}
 
-	bool anyError = false;
+	// One handle per thread, shared by the name/address queries and the action.
+	auto threadHandles =
+		std::make_shared<ThreadHandles>(THREAD_QUERY_INFORMATION | THREAD_SUSPEND_RESUME);
+
 	bool foundAny = false;
-	bool patternMatched = false;
+	bool anyError = false;
+	bool priorityExcluded = false;
 
 	for (const auto &proc : procsResult.value()) {
-		auto addrInfoResult = ProcessUtils::GetThreadStartAddresses(proc.Pid);
-		if (!addrInfoResult.has_value()) {
+		auto selectionResult = plan->Select(proc.Pid, threadHandles);
+		if (!selectionResult.has_value()) {
 			Formatter::PrintError(
 				std::format(
 					"Failed to get thread start addresses for {} (PID: {})"
 					"\nCause: {}",
 					StringUtils::WstrToString(proc.Name),
 					proc.Pid,
-					addrInfoResult.error().message
-				),
-				addrInfoResult.error().traceback
-			);
-			anyError = true;
-			continue;
-		}
-
-		auto matchedResult = GetMatchingThreads(addrInfoResult.value(), threadAddrRegex);
-		if (!matchedResult.has_value()) {
-			Formatter::PrintError(
-				std::format(
-					"Failed to get thread start addresses for {} (PID: {})"
-					"\nReason: {}",
-					StringUtils::WstrToString(proc.Name),
-					proc.Pid,
-					matchedResult.error().message
+					selectionResult.error().message
 				),
-				matchedResult.error().traceback
+				selectionResult.error().traceback
 			);
 			anyError = true;
 			continue;
 		}
 
-		const std::vector<ThreadAddrInfo> matchedThreads = matchedResult.value();
-		if (!matchedThreads.empty()) patternMatched = true;
+		const ThreadSelection &selection = selectionResult.value();
+		if (selection.PriorityExcluded) priorityExcluded = true;
+		if (selection.Threads.empty()) continue;
 
-		std::vector<ThreadAddrInfo> filteredThreads;
-
-		if (filterPriority.empty()) {
-			filteredThreads = matchedThreads;
-		} else {
-			// Filter threads by priority when specified
-			for (const auto &matchedInfo : matchedThreads) {
-				if (filterPrioOpt.has_value()) {
-					if (matchedInfo.info.BasePriority !=
-						static_cast<LONG>(filterPrioOpt.value())) {
-						continue;
-					}
-				} else {
-					const std::string basePriority = StringUtils::Normalize(
-						Convert::ThreadPriorityToString(matchedInfo.info.BasePriority)
-					);
-					if (basePriority != filterPrioNorm) continue;
-				}
-				filteredThreads.push_back(matchedInfo);
-			}
-		}
+		ProcessUtils::PrefetchNames(selection.Threads);
 
 		std::vector<std::pair<ThreadAddrInfo, ResultVoid>> results;
-
-		for (const auto &matchedInfo : filteredThreads) {
-			auto res = ProcessUtils::ResumeThread(matchedInfo.info.Tid);
+		for (const auto &matchedInfo : selection.Threads) {
+			auto res = ProcessUtils::ResumeThread(*threadHandles, matchedInfo.info.Tid);
 			if (!res.has_value()) anyError = true;
 			results.push_back({matchedInfo, res});
 		}
 
-		if (!filteredThreads.empty()) {
-			Formatter::PrintThreadsResult(proc.Pid, proc.Name, Action::Resume, results);
-			foundAny = true;
-		}
+		Formatter::PrintThreadsResult(proc.Pid, proc.Name, Action::Resume, results);
+		foundAny = true;
 	}
 
 	if (!foundAny) {
 		ProcessInfo proc = procsResult.value().front();
 
-		if (patternMatched && !filterPriority.empty()) {
+		if (priorityExcluded) {
 			Formatter::PrintError(
 				std::format(
 					"No threads matched pattern '{}' with priority '{}' "
@@ -907,8 +1254,10 @@ int CommandHandlers::HandleResumeThreadByAddr(
 	return anyError ? 1 : 0;
 }
 
-int CommandHandlers::HandleSetPriority(std::string_view target, std::string_view value) {
-	auto procsResult = ProcessUtils::GetTargetProcesses(target);
+int CommandHandlers::HandleSetPriority(
+	std::string_view target, std::string_view value, const TargetOptions &options
+) {
+	auto procsResult = ProcessUtils::GetTargetProcesses(target, options);
 	if (!procsResult.has_value()) {
 		Formatter::PrintError(
 			std::format(
@@ -929,23 +1278,19 @@ int CommandHandlers::HandleSetPriority(std::string_view target, std::string_view
 	}
 	DWORD priorityClass = prioResult.value();
 
-	bool anyError = false;
-	std::vector<std::pair<ProcessInfo, ResultVoid>> results;
-
-	for (const auto &proc : procsResult.value()) {
-		auto result = ProcessUtils::SetProcessPriority(proc.Pid, priorityClass);
-		results.push_back({proc, result});
-	}
-
-	for (const auto &res : results) {
-		Formatter::PrintCommandResult(res, Action::SetPriority);
-		if (!res.second.has_value()) anyError = true;
-	}
-	return anyError ? 1 : 0;
+	return RunOnTargets(
+		std::move(procsResult.value()),
+		[priorityClass](const ProcessInfo &proc) {
+			return ProcessUtils::SetProcessPriority(proc.Pid, priorityClass);
+		},
+		Action::SetPriority
+	);
 }
 
-static bool SetPriorityThreadById(DWORD tid, int priorityLevel, const ProcessInfo &proc) {
-	ResultVoid result = ProcessUtils::SetThreadPriorityLevel(tid, priorityLevel);
+static bool SetPriorityThreadById(
+	ThreadHandles &handles, DWORD tid, int priorityLevel, const ProcessInfo &proc
+) {
+	ResultVoid result = ProcessUtils::SetThreadPriorityLevel(handles, tid, priorityLevel);
 
 	if (result.has_value()) {
 		Formatter::PrintSuccess(
@@ -965,15 +1310,17 @@ static bool SetPriorityThreadById(DWORD tid, int priorityLevel, const ProcessInf
 }
 
 static bool SetPriorityThreadsByName(
-	const std::vector<ThreadNameInfo> &matchedThreads,
+	ThreadHandles &handles,
+	const std::vector<ThreadAddrInfo> &matchedThreads,
 	int priorityLevel,
 	const ProcessInfo &proc
 ) {
 	bool allOk = true;
 	std::vector<std::pair<ThreadNameInfo, ResultVoid>> results;
 	for (const auto &matchedInfo : matchedThreads) {
-		auto result =
-			ProcessUtils::SetThreadPriorityLevel(matchedInfo.info.Tid, priorityLevel);
+		auto result = ProcessUtils::SetThreadPriorityLevel(
+			handles, matchedInfo.info.Tid, priorityLevel
+		);
 		if (!result.has_value()) allOk = false;
 		results.push_back({matchedInfo, result});
 	}
@@ -1007,87 +1354,58 @@ int CommandHandlers::HandleSetPriorityThread(
 		Formatter::PrintError(std::format("Invalid thread priority value: {}", priority));
 		return 1;
 	}
-
 	const int priorityLevel = prioResult.value();
+
 	const auto threadIdOpt = StringUtils::TryParseInt(threadIdOrName);
-	const auto filterPrioOpt = StringUtils::TryParseInt(filterPriority);
-	const std::string filterPrioNorm = StringUtils::Normalize(filterPriority);
+	auto plan =
+		PlanThreadQuery(MakeIdOrNameQuery(threadIdOrName, threadIdOpt), filterPriority);
+	if (!plan) return 1;
 
-	// Validate priority value is valid string or parsable number.
-	if (!filterPriority.empty() && !filterPrioOpt.has_value()) {
-		auto pRes = Convert::ParseThreadPriority(filterPriority);
-		if (!pRes.has_value()) {
-			Formatter::PrintError(
-				std::format("Invalid priority value: {}", filterPriority)
-			);
-			return 1;
-		}
-	}
+	// One handle per thread, shared by the name/address queries and the action.
+	auto threadHandles = std::make_shared<ThreadHandles>(
+		THREAD_QUERY_INFORMATION | THREAD_SET_INFORMATION
+	);
 
 	if (threadIdOpt && procsResult.value().size() == 1 && filterPriority.empty()) {
 		const auto &proc = procsResult.value().front();
 		const DWORD tid = static_cast<DWORD>(threadIdOpt.value());
-		return SetPriorityThreadById(tid, priorityLevel, proc) ? 0 : 1;
+		return SetPriorityThreadById(*threadHandles, tid, priorityLevel, proc) ? 0 : 1;
 	}
 
 	bool foundAny = false;
 	bool anyError = false;
-	bool threadFound = false;
+	bool priorityExcluded = false;
 
 	for (const auto &proc : procsResult.value()) {
-		auto nameInfoResult = ProcessUtils::GetThreadNames(proc.Pid);
-		if (!nameInfoResult.has_value()) {
+		auto selectionResult = plan->Select(proc.Pid, threadHandles);
+		if (!selectionResult.has_value()) {
 			Formatter::PrintError(
 				std::format(
 					"Failed to get thread names for {} (PID: {})"
 					"\nReason: {}",
 					StringUtils::WstrToString(proc.Name),
 					proc.Pid,
-					nameInfoResult.error().message
+					selectionResult.error().message
 				),
-				nameInfoResult.error().traceback
+				selectionResult.error().traceback
 			);
 			anyError = true;
 			continue;
 		}
 
-		// Find threads by thread Id or thread name
-		std::vector<ThreadNameInfo> matchedThreads;
-		for (const auto &threadInfo : nameInfoResult.value()) {
-			if (
-				threadIdOpt
-					? threadInfo.info.Tid == static_cast<DWORD>(threadIdOpt.value())
-					: threadInfo.Name == threadIdOrName
-				//
-			) {
-				threadFound = true;
-				// Filter threads by priority when specified
-				if (!filterPriority.empty()) {
-					if (filterPrioOpt.has_value()) {
-						if (threadInfo.info.BasePriority !=
-							static_cast<LONG>(filterPrioOpt.value())) {
-							continue;
-						}
-					} else {
-						const std::string basePriority = StringUtils::Normalize(
-							Convert::ThreadPriorityToString(threadInfo.info.BasePriority)
-						);
-						if (basePriority != filterPrioNorm) continue;
-					}
-				}
-
-				matchedThreads.push_back(threadInfo);
-				if (threadIdOpt.has_value()) break;
-			}
-		}
+		const ThreadSelection &selection = selectionResult.value();
+		if (selection.PriorityExcluded) priorityExcluded = true;
 
+		const std::vector<ThreadAddrInfo> &matchedThreads = selection.Threads;
 		if (!matchedThreads.empty()) {
 			bool ok;
 			if (threadIdOpt) {
 				const DWORD tid = static_cast<DWORD>(threadIdOpt.value());
-				ok = SetPriorityThreadById(tid, priorityLevel, proc);
+				ok = SetPriorityThreadById(*threadHandles, tid, priorityLevel, proc);
 			} else {
-				ok = SetPriorityThreadsByName(matchedThreads, priorityLevel, proc);
+				ok = SetPriorityThreadsByName(
+					*threadHandles, matchedThreads, priorityLevel, proc
+				);
 			}
 			if (!ok) anyError = true;
 			foundAny = true;
@@ -1097,7 +1415,7 @@ int CommandHandlers::HandleSetPriorityThread(
 	if (!foundAny) {
 		ProcessInfo proc = procsResult.value().front();
 
-		if (threadFound && !filterPriority.empty()) {
+		if (priorityExcluded) {
 			Formatter::PrintError(
 				std::format(
 					"No threads matched {} '{}' with priority '{}' for {} (PID: {})",
@@ -1112,7 +1430,7 @@ int CommandHandlers::HandleSetPriorityThread(
 			Formatter::PrintError(
 				std::format(
 					"No threads matched {} '{}' for {} (PID: {})",
-					threadIdOpt ? "TID" : "name",
+					threadIdOpt.has_value() ? "TID" : "name",
 					threadIdOrName,
 					StringUtils::WstrToString(proc.Name),
 					proc.Pid
@@ -1150,22 +1468,12 @@ int CommandHandlers::HandleSetPriorityThreadByAddr(
 		Formatter::PrintError(std::format("Invalid thread priority value: {}", priority));
 		return 1;
 	}
-
 	const int priorityLevel = prioResult.value();
-	const auto filterPrioOpt = StringUtils::TryParseInt(filterPriority);
-
-	// Validate priority value is valid string or parsable number.
-	if (!filterPriority.empty() && !filterPrioOpt.has_value()) {
-		auto pRes = Convert::ParseThreadPriority(filterPriority);
-		if (!pRes.has_value()) {
-			Formatter::PrintError(
-				std::format("Invalid priority value: {}", filterPriority)
-			);
-			return 1;
-		}
-	}
 
-	const std::string filterPrioNorm = StringUtils::Normalize(filterPriority);
+	ThreadQuery query;
+	query.AddressPattern = std::string(threadAddrRegex);
+	auto plan = PlanThreadQuery(std::move(query), filterPriority);
+	if (!plan) return 1;
 
 	ResultVoid result = ProcessUtils::EnableDebugPrivilege(GetCurrentProcess());
 	if (!result.has_value()) {
@@ -1180,88 +1488,55 @@ int CommandHandlers::HandleSetPriorityThreadByAddr(
 		return 1;
 	}
 
+	// One handle per thread, shared by the name/address queries and the action.
+	auto threadHandles = std::make_shared<ThreadHandles>(
+		THREAD_QUERY_INFORMATION | THREAD_SET_INFORMATION
+	);
+
 	bool foundAny = false;
 	bool anyError = false;
-	bool patternMatched = false;
+	bool priorityExcluded = false;
 
 	for (const auto &proc : procsResult.value()) {
-		std::vector<std::pair<ThreadAddrInfo, ResultVoid>> results;
-
-		auto addrInfoResult = ProcessUtils::GetThreadStartAddresses(proc.Pid);
-		if (!addrInfoResult.has_value()) {
+		auto selectionResult = plan->Select(proc.Pid, threadHandles);
+		if (!selectionResult.has_value()) {
 			Formatter::PrintError(
 				std::format(
 					"Failed to get thread start addresses for {} (PID: {})"
 					"\nCause: {}",
 					StringUtils::WstrToString(proc.Name),
 					proc.Pid,
-					addrInfoResult.error().message
-				),
-				addrInfoResult.error().traceback
-			);
-			anyError = true;
-			continue;
-		}
-
-		auto matchedResult = GetMatchingThreads(addrInfoResult.value(), threadAddrRegex);
-		if (!matchedResult.has_value()) {
-			Formatter::PrintError(
-				std::format(
-					"Failed matching thread addresses for {} (PID: {})"
-					"\nReason: {}",
-					StringUtils::WstrToString(proc.Name),
-					proc.Pid,
-					matchedResult.error().message
+					selectionResult.error().message
 				),
-				matchedResult.error().traceback
+				selectionResult.error().traceback
 			);
 			anyError = true;
 			continue;
 		}
 
-		const std::vector<ThreadAddrInfo> matchedThreads = matchedResult.value();
-		if (!matchedThreads.empty()) patternMatched = true;
+		const ThreadSelection &selection = selectionResult.value();
+		if (selection.PriorityExcluded) priorityExcluded = true;
+		if (selection.Threads.empty()) continue;
 
-		std::vector<ThreadAddrInfo> filteredThreads;
-		if (filterPriority.empty()) {
-			filteredThreads = matchedThreads;
-		} else {
-			// Filter threads by priority when specified
-			for (const auto &matchedInfo : matchedThreads) {
-				if (filterPrioOpt.has_value()) {
-					if (matchedInfo.info.BasePriority !=
-						static_cast<LONG>(filterPrioOpt.value())) {
-						continue;
-					}
-				} else {
-					const std::string basePriority = StringUtils::Normalize(
-						Convert::ThreadPriorityToString(matchedInfo.info.BasePriority)
-					);
-					if (basePriority != filterPrioNorm) continue;
-				}
-				filteredThreads.push_back(matchedInfo);
-			}
-		}
+		ProcessUtils::PrefetchNames(selection.Threads);
 
-		for (const auto &matchedInfo : filteredThreads) {
-			auto res =
-				ProcessUtils::SetThreadPriorityLevel(matchedInfo.info.Tid, priorityLevel);
+		std::vector<std::pair<ThreadAddrInfo, ResultVoid>> results;
+		for (const auto &matchedInfo : selection.Threads) {
+			auto res = ProcessUtils::SetThreadPriorityLevel(
+				*threadHandles, matchedInfo.info.Tid, priorityLevel
+			);
 			if (!res.has_value()) anyError = true;
 			results.push_back({matchedInfo, res});
 		}
 
-		if (!filteredThreads.empty()) {
-			Formatter::PrintThreadsResult(
-				proc.Pid, proc.Name, Action::SetPriority, results
-			);
-			foundAny = true;
-		}
+		Formatter::PrintThreadsResult(proc.Pid, proc.Name, Action::SetPriority, results);
+		foundAny = true;
 	}
 
 	if (!foundAny) {
 		ProcessInfo proc = procsResult.value().front();
 
-		if (patternMatched && !filterPriority.empty()) {
+		if (priorityExcluded) {
 			Formatter::PrintError(
 				std::format(
 					"No threads matched pattern '{}' with priority '{}' "
@@ -1,16 +1,51 @@
 #pragma once
 
+#include <chrono>
+#include <optional>
+#include <string>
 #include <string_view>
 
+#include "core/Profiler.hpp"
+#include "core/ProcessUtils.hpp"
+
 namespace CommandHandlers {
-	int HandleList();
-	int HandleKill(std::string_view target);
+	struct SymbolOptions {
+		// Print module+offset first and resolve symbols for at most this long.
+		std::optional<std::chrono::milliseconds> Budget;
+		// Resolve symbols in this many --symbol-worker processes (0 = in-process).
+		size_t Workers = 0;
+	};
+
+	struct SampleOptions {
+		// Measure per-thread CPU usage and context switches over this interval.
+		std::optional<std::chrono::milliseconds> Interval;
+		// Thread table column to sort by: tid, priority, cpu or csw (empty = unsorted).
+		std::string SortBy;
+	};
+
+	int HandleList(bool suspendedOnly, std::string_view where);
+	int HandlePids(std::string_view pattern);
+	int HandleTree(std::string_view target, std::string_view sortBy);
+	int HandleKill(std::string_view target, const TargetOptions &options);
 	int HandleQuery(std::string_view target);
 	int HandleQueryThread(
-		std::string_view target, std::string_view threadIdOrName, bool queryAll
+		std::string_view target,
+		std::string_view threadIdOrName,
+		bool queryAll,
+		std::string_view where,
+		const SymbolOptions &symbolOptions,
+		const SampleOptions &sampleOptions
+	);
+	int HandleThreads(std::string_view groupBy, size_t top, size_t symbolWorkers);
+	int HandleHot(std::chrono::milliseconds interval, size_t top, size_t symbolWorkers);
+	int HandleProfile(
+		std::string_view target,
+		const ProfileOptions &options,
+		size_t symbolWorkers,
+		std::string_view outputPath
 	);
-	int HandleSuspend(std::string_view target);
-	int HandleResume(std::string_view target);
+	int HandleSuspend(std::string_view target, const TargetOptions &options);
+	int HandleResume(std::string_view target, const TargetOptions &options);
 	int HandleSuspendThread(
 		std::string_view target,
 		std::string_view threadIdOrName,
@@ -31,7 +66,9 @@ namespace CommandHandlers {
 		std::string_view threadAddrRegex,
 		std::string_view filterPriority
 	);
-	int HandleSetPriority(std::string_view target, std::string_view value);
+	int HandleSetPriority(
+		std::string_view target, std::string_view value, const TargetOptions &options
+	);
 	int HandleSetPriorityThread(
 		std::string_view target,
 		std::string_view priority,
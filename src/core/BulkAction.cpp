@@ -0,0 +1,53 @@
+#include "BulkAction.hpp"
+
+#include <algorithm>
+
+#include "ProcessTree.hpp"
+
+void BulkAction::Run(
+	std::vector<ProcessInfo> targets,
+	const TargetAction &action,
+	const Report &report,
+	ThreadPool &pool
+) {
+	const ProcessTree tree(targets);
+
+	// Wave d holds the targets with d target ancestors; each wave waits for the
+	// one before it. Unrelated targets all land in the first wave.
+	std::vector<uint32_t> depth(tree.Size(), 0);
+	std::vector<std::vector<uint32_t>> waves;
+	for (uint32_t i : tree.Subtrees(tree.Roots(), true)) {
+		const uint32_t parent = tree.Parent(i);
+		depth[i] = parent == ProcessTree::NoParent ? 0 : depth[parent] + 1;
+		if (waves.size() <= depth[i]) waves.resize(depth[i] + 1);
+		waves[depth[i]].push_back(i);
+	}
+
+	// Slots in wave order, so every finished batch is one contiguous span.
+	std::vector<Outcome> outcomes;
+	outcomes.reserve(targets.size());
+	std::vector<size_t> waveEnds;
+	for (auto &wave : waves) {
+		std::sort(wave.begin(), wave.end());
+		for (uint32_t i : wave) {
+			outcomes.emplace_back(std::move(targets[i]), std::monostate{});
+		}
+		waveEnds.push_back(outcomes.size());
+	}
+
+	// Large waves are split so results show up while the rest is still running;
+	// a few items per thread keeps the wait for each batch's straggler short.
+	const size_t batch = pool.Concurrency() * 8;
+	size_t begin = 0;
+	for (size_t waveEnd : waveEnds) {
+		while (begin < waveEnd) {
+			const size_t end = (std::min)(begin + batch, waveEnd);
+			pool.ParallelFor(end - begin, [&](size_t k) {
+				auto &[proc, result] = outcomes[begin + k];
+				result = action(proc);
+			});
+			report(std::span<const Outcome>(outcomes).subspan(begin, end - begin));
+			begin = end;
+		}
+	}
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <functional>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "Result.hpp"
+#include "Error.hpp"
+#include "NtUtils.hpp"
+#include "utils/ThreadPool.hpp"
+
+/**
+ * @brief Runs one action per target process (kill, suspend, ...) over a bounded
+ *        thread pool. Outcomes land in pre-sized slots and are reported batch by
+ *        batch from the calling thread, in an order that doesn't depend on
+ *        scheduling.
+ */
+namespace BulkAction {
+
+	using Outcome = std::pair<ProcessInfo, ResultVoid>;
+	using TargetAction = std::function<ResultVoid(const ProcessInfo &)>;
+	using Report = std::function<void(std::span<const Outcome>)>;
+
+	/**
+	 * @brief Run the action on every target. A target whose parent is also a
+	 *        target runs only once the parent's action is done, so tree targets
+	 *        are acted on parents first. report is called after each batch
+	 *        completes; over the whole run it sees every outcome once, ordered by
+	 *        wave (number of target ancestors), then by target order.
+	 */
+	void Run(
+		std::vector<ProcessInfo> targets,
+		const TargetAction &action,
+		const Report &report,
+		ThreadPool &pool = ThreadPool::Shared()
+	);
+
+} // namespace BulkAction
@@ -1,63 +1,138 @@
 #include "Convert.hpp"
 
+#include <array>
+#include <cstdint>
 #include <sstream>
 #include <iomanip>
 #include <Wtsapi32.h>
 
+#include "utils/PerfectHash.hpp"
 #include "utils/StringUtils.hpp"
 
-std::string Convert::ProcessPriorityToString(LONG priority) {
-	switch (priority) {
-		case 4:
-			return "Idle";
-		case 6:
-			return "Below normal";
-		case 8:
-			return "Normal";
-		case 10:
-			return "Above normal";
-		case 13:
-			return "High";
-		case 24:
-			return "Realtime";
-		default:
-			return std::to_string(priority);
+namespace {
+	// Text for values without a name, built at compile time: "0" to "255" and
+	// "Unknown (0)" to "Unknown (255)".
+	template <size_t Width> class LabelTable {
+	public:
+		constexpr LabelTable(std::string_view prefix, std::string_view suffix) {
+			for (size_t value = 0; value < 256; ++value) {
+				auto &text = m_text[value];
+				size_t length = 0;
+				for (char c : prefix) text[length++] = c;
+
+				char digits[3];
+				size_t count = 0;
+				size_t rest = value;
+				do {
+					digits[count++] = static_cast<char>('0' + rest % 10);
+					rest /= 10;
+				} while (rest != 0);
+				while (count != 0) text[length++] = digits[--count];
+
+				for (char c : suffix) text[length++] = c;
+				m_length[value] = static_cast<uint8_t>(length);
+			}
+		}
+
+		constexpr std::string_view operator[](size_t value) const {
+			if (value >= 256) return "Unknown";
+			return {m_text[value].data(), m_length[value]};
+		}
+
+	private:
+		std::array<std::array<char, Width>, 256> m_text{};
+		std::array<uint8_t, 256> m_length{};
+	};
+
+	constexpr LabelTable<3> kNumbers("", "");
+	constexpr LabelTable<13> kUnknown("Unknown (", ")");
+
+	constexpr auto kProcessPriorityNames = [] {
+		std::array<std::string_view, 32> names{};
+		names[4] = "Idle";
+		names[6] = "Below normal";
+		names[8] = "Normal";
+		names[10] = "Above normal";
+		names[13] = "High";
+		names[24] = "Realtime";
+		return names;
+	}();
+
+	constexpr auto kThreadPriorityNames = [] {
+		std::array<std::string_view, 32> names{};
+		names[1] = names[16] = "Idle";
+		names[6] = "Lowest";
+		names[7] = "Below normal";
+		names[8] = names[24] = "Normal";
+		names[9] = "Above Normal";
+		names[10] = "Highest";
+		names[15] = names[31] = "Time critical";
+		return names;
+	}();
+
+	// Matches KTHREAD_STATE enum from the NT kernel / WinInternals
+	constexpr std::string_view kThreadStateNames[] = {
+		"Initialized", "Ready", "Running", "Standby", "Terminated", "Waiting",
+		"Transition", "DeferredReady", "GateWaitObsolete", "WaitingForProcessInSwap",
+	};
+
+	// Matches KWAIT_REASON enum from the NT kernel / WinInternals
+	constexpr std::string_view kWaitReasonNames[] = {
+		"Executive", "FreePage", "PageIn", "PoolAllocation", "DelayExecution",
+		"Suspended", "UserRequest", "WrExecutive", "WrFreePage", "WrPageIn",
+		"WrPoolAllocation", "WrDelayExecution", "WrSuspended", "WrUserRequest",
+		"WrEventPair", "WrQueue", "WrLpcReceive", "WrLpcReply", "WrVirtualMemory",
+		"WrPageOut", "WrRendezvous", "WrKeyedEvent", "WrTerminated", "WrProcessInSwap",
+		"WrCpuRateControl", "WrCalloutStack", "WrKernel", "WrResource", "WrPushLock",
+		"WrMutex", "WrQuantumEnd", "WrDispatchInt", "WrPreempted", "WrYieldExecution",
+		"WrFastMutex", "WrGuardedMutex", "WrRundown", "WrAlertByThreadId",
+		"WrDeferredPreempt", "WrPhysicalFault", "WrIoRing", "WrMdlCache", "WrRcu",
+	};
+
+	constexpr auto kProcessPriorityByName = PerfectHash::Make<DWORD>({
+		{"idle", IDLE_PRIORITY_CLASS},
+		{"below_normal", BELOW_NORMAL_PRIORITY_CLASS},
+		{"normal", NORMAL_PRIORITY_CLASS},
+		{"above_normal", ABOVE_NORMAL_PRIORITY_CLASS},
+		{"high", HIGH_PRIORITY_CLASS},
+		{"realtime", REALTIME_PRIORITY_CLASS},
+	});
+
+	constexpr auto kThreadPriorityByName = PerfectHash::Make<int>({
+		{"idle", THREAD_PRIORITY_IDLE},
+		{"lowest", THREAD_PRIORITY_LOWEST},
+		{"below_normal", THREAD_PRIORITY_BELOW_NORMAL},
+		{"normal", THREAD_PRIORITY_NORMAL},
+		{"above_normal", THREAD_PRIORITY_ABOVE_NORMAL},
+		{"highest", THREAD_PRIORITY_HIGHEST},
+		{"time_critical", THREAD_PRIORITY_TIME_CRITICAL},
+	});
+
+	template <size_t N>
+	constexpr std::string_view Lookup(const std::string_view (&names)[N], ULONG value) {
+		return value < N ? names[value] : kUnknown[value];
 	}
-}
 
-std::string Convert::ThreadPriorityToString(LONG priority) {
-	switch (priority) {
-		case 1:
-		case 16:
-			return "Idle";
-		case 6:
-			return "Lowest";
-		case 7:
-			return "Below normal";
-		case 8:
-		case 24:
-			return "Normal";
-		case 9:
-			return "Above Normal";
-		case 10:
-			return "Highest";
-		case 15:
-		case 31:
-			return "Time critical";
-		default:
-			return std::to_string(priority);
+	template <size_t N>
+	constexpr std::string_view
+	Lookup(const std::array<std::string_view, N> &names, LONG value) {
+		if (value >= 0 && static_cast<size_t>(value) < N && !names[value].empty()) {
+			return names[value];
+		}
+		return value >= 0 ? kNumbers[static_cast<size_t>(value)] : "Unknown";
 	}
+} // namespace
+
+std::string_view Convert::ProcessPriorityToString(LONG priority) {
+	return Lookup(kProcessPriorityNames, priority);
 }
 
-std::optional<DWORD> Convert::ParseProcessPriority(std::string_view value) {
-	std::string normalized = StringUtils::Normalize(value);
+std::string_view Convert::ThreadPriorityToString(LONG priority) {
+	return Lookup(kThreadPriorityNames, priority);
+}
 
-	if (normalized == "idle") return IDLE_PRIORITY_CLASS;
-	if (normalized == "below_normal") return BELOW_NORMAL_PRIORITY_CLASS;
-	if (normalized == "normal") return NORMAL_PRIORITY_CLASS;
-	if (normalized == "above_normal") return ABOVE_NORMAL_PRIORITY_CLASS;
-	if (normalized == "high") return HIGH_PRIORITY_CLASS;
-	if (normalized == "realtime") return REALTIME_PRIORITY_CLASS;
+std::optional<DWORD> Convert::ParseProcessPriority(std::string_view value) {
+	if (auto priorityClass = kProcessPriorityByName.Find(value)) return priorityClass;
 
 	auto parsed = StringUtils::TryParseInt(value);
 	if (parsed.has_value()) {
@@ -68,15 +143,7 @@ std::optional<DWORD> Convert::ParseProcessPriority(std::string_view value) {
 }
 
 std::optional<int> Convert::ParseThreadPriority(std::string_view value) {
-	std::string normalized = StringUtils::Normalize(value);
-
-	if (normalized == "idle") return THREAD_PRIORITY_IDLE;
-	if (normalized == "lowest") return THREAD_PRIORITY_LOWEST;
-	if (normalized == "below_normal") return THREAD_PRIORITY_BELOW_NORMAL;
-	if (normalized == "normal") return THREAD_PRIORITY_NORMAL;
-	if (normalized == "above_normal") return THREAD_PRIORITY_ABOVE_NORMAL;
-	if (normalized == "highest") return THREAD_PRIORITY_HIGHEST;
-	if (normalized == "time_critical") return THREAD_PRIORITY_TIME_CRITICAL;
+	if (auto level = kThreadPriorityByName.Find(value)) return level;
 
 	auto parsed = StringUtils::TryParseInt(value);
 	if (parsed.has_value()) {
@@ -86,126 +153,12 @@ std::optional<int> Convert::ParseThreadPriority(std::string_view value) {
 	return std::nullopt;
 }
 
-std::string Convert::ThreadStateToString(ULONG threadState) {
-	// Matches KTHREAD_STATE enum from the NT kernel / WinInternals
-	switch (threadState) {
-		case 0:
-			return "Initialized";
-		case 1:
-			return "Ready";
-		case 2:
-			return "Running";
-		case 3:
-			return "Standby";
-		case 4:
-			return "Terminated";
-		case 5:
-			return "Waiting";
-		case 6:
-			return "Transition";
-		case 7:
-			return "DeferredReady";
-		case 8:
-			return "GateWaitObsolete";
-		case 9:
-			return "WaitingForProcessInSwap";
-		default:
-			return "Unknown (" + std::to_string(threadState) + ")";
-	}
+std::string_view Convert::ThreadStateToString(ULONG threadState) {
+	return Lookup(kThreadStateNames, threadState);
 }
 
-std::string Convert::WaitReasonToString(ULONG waitReason) {
-	// Matches KWAIT_REASON enum from the NT kernel / WinInternals
-	switch (waitReason) {
-		case 0:
-			return "Executive";
-		case 1:
-			return "FreePage";
-		case 2:
-			return "PageIn";
-		case 3:
-			return "PoolAllocation";
-		case 4:
-			return "DelayExecution";
-		case 5:
-			return "Suspended";
-		case 6:
-			return "UserRequest";
-		case 7:
-			return "WrExecutive";
-		case 8:
-			return "WrFreePage";
-		case 9:
-			return "WrPageIn";
-		case 10:
-			return "WrPoolAllocation";
-		case 11:
-			return "WrDelayExecution";
-		case 12:
-			return "WrSuspended";
-		case 13:
-			return "WrUserRequest";
-		case 14:
-			return "WrEventPair";
-		case 15:
-			return "WrQueue";
-		case 16:
-			return "WrLpcReceive";
-		case 17:
-			return "WrLpcReply";
-		case 18:
-			return "WrVirtualMemory";
-		case 19:
-			return "WrPageOut";
-		case 20:
-			return "WrRendezvous";
-		case 21:
-			return "WrKeyedEvent";
-		case 22:
-			return "WrTerminated";
-		case 23:
-			return "WrProcessInSwap";
-		case 24:
-			return "WrCpuRateControl";
-		case 25:
-			return "WrCalloutStack";
-		case 26:
-			return "WrKernel";
-		case 27:
-			return "WrResource";
-		case 28:
-			return "WrPushLock";
-		case 29:
-			return "WrMutex";
-		case 30:
-			return "WrQuantumEnd";
-		case 31:
-			return "WrDispatchInt";
-		case 32:
-			return "WrPreempted";
-		case 33:
-			return "WrYieldExecution";
-		case 34:
-			return "WrFastMutex";
-		case 35:
-			return "WrGuardedMutex";
-		case 36:
-			return "WrRundown";
-		case 37:
-			return "WrAlertByThreadId";
-		case 38:
-			return "WrDeferredPreempt";
-		case 39:
-			return "WrPhysicalFault";
-		case 40:
-			return "WrIoRing";
-		case 41:
-			return "WrMdlCache";
-		case 42:
-			return "WrRcu";
-		default:
-			return "Unknown (" + std::to_string(waitReason) + ")";
-	}
+std::string_view Convert::WaitReasonToString(ULONG waitReason) {
+	return Lookup(kWaitReasonNames, waitReason);
 }
 
 std::string Convert::MemoryToMB(SIZE_T bytes) {
@@ -2,22 +2,26 @@
 
 #include <optional>
 #include <string>
+#include <string_view>
 #include <Windows.h>
 
 namespace Convert {
 
 	/**
 	 * @brief Convert base priority (typically 4, 6, 8, 10, 13, 24) to a human-readable string.
+	 *        Names and fallback numbers come from constant tables, nothing is allocated.
 	 */
-	std::string ProcessPriorityToString(LONG priority);
+	std::string_view ProcessPriorityToString(LONG priority);
 
 	/**
 	 * @brief Convert thread dynamic or base priority to a human-readable string.
 	 */
-	std::string ThreadPriorityToString(LONG priority);
+	std::string_view ThreadPriorityToString(LONG priority);
 
 	/**
 	 * @brief Parse a process priority class string or numeric value.
+	 *        Names are looked up in a compile-time perfect hash, without normalizing
+	 *        the input into a new string.
 	 */
 	std::optional<DWORD> ParseProcessPriority(std::string_view value);
 
@@ -41,10 +45,10 @@ namespace Convert {
 	 * @brief Convert KTHREAD_STATE value to a human-readable string.
 	 *        Values match the KTHREAD_STATE enum (0=Initialized, 1=Ready, 2=Running, ...).
 	 */
-	std::string ThreadStateToString(ULONG threadState);
+	std::string_view ThreadStateToString(ULONG threadState);
 
 	/**
 	 * @brief Convert KWAIT_REASON value to a human-readable string.
 	 */
-	std::string WaitReasonToString(ULONG waitReason);
+	std::string_view WaitReasonToString(ULONG waitReason);
 } // namespace Convert
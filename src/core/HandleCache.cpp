@@ -0,0 +1,162 @@
+#include "HandleCache.hpp"
+
+#include <format>
+
+#include "WinError.hpp"
+
+namespace {
+	// Rights requested alongside every open, so entries can be timed.
+	DWORD AmbientAccess(bool isProcess) {
+		return isProcess ? PROCESS_QUERY_LIMITED_INFORMATION
+						 : THREAD_QUERY_LIMITED_INFORMATION;
+	}
+
+	// Full query/set rights implicitly grant their limited counterparts.
+	DWORD ExpandAccess(bool isProcess, DWORD access) {
+		if (isProcess) {
+			if (access & PROCESS_QUERY_INFORMATION) {
+				access |= PROCESS_QUERY_LIMITED_INFORMATION;
+			}
+			if (access & PROCESS_SET_INFORMATION) {
+				access |= PROCESS_SET_LIMITED_INFORMATION;
+			}
+		} else {
+			if (access & THREAD_QUERY_INFORMATION) {
+				access |= THREAD_QUERY_LIMITED_INFORMATION;
+			}
+			if (access & THREAD_SET_INFORMATION) {
+				access |= THREAD_SET_LIMITED_INFORMATION;
+			}
+		}
+		return access;
+	}
+
+	ULONGLONG ToTicks(const FILETIME &ft) {
+		return (static_cast<ULONGLONG>(ft.dwHighDateTime) << 32) | ft.dwLowDateTime;
+	}
+
+	// Creation time in FILETIME ticks; 0 when times can't be queried.
+	ULONGLONG QueryCreateTime(bool isProcess, HANDLE handle) {
+		FILETIME creation, exit, kernel, user;
+		const BOOL ok = isProcess
+							? GetProcessTimes(handle, &creation, &exit, &kernel, &user)
+							: GetThreadTimes(handle, &creation, &exit, &kernel, &user);
+		return ok ? ToTicks(creation) : 0;
+	}
+} // namespace
+
+HandleCache &HandleCache::Shared() {
+	static HandleCache instance(512);
+	return instance;
+}
+
+HandleCache::HandleCache(size_t capacity) : m_capacity(capacity) {}
+
+size_t HandleCache::KeyHash::operator()(const Key &key) const noexcept {
+	return std::hash<ULONGLONG>{}(
+		(static_cast<ULONGLONG>(key.Type) << 32) | static_cast<ULONGLONG>(key.Id)
+	);
+}
+
+Result<SharedHandle, Error>
+HandleCache::Process(DWORD pid, DWORD access, DWORD preferred) {
+	auto entry = Acquire(Kind::Process, pid, access, preferred);
+	if (!entry) return entry.error();
+	return entry.value().Handle;
+}
+
+Result<SharedHandle, Error>
+HandleCache::Thread(DWORD tid, DWORD access, DWORD preferred) {
+	auto entry = Acquire(Kind::Thread, tid, access, preferred);
+	if (!entry) return entry.error();
+	return entry.value().Handle;
+}
+
+ULONGLONG HandleCache::ProcessCreateTime(DWORD pid) {
+	auto entry = Acquire(Kind::Process, pid, PROCESS_QUERY_LIMITED_INFORMATION, 0);
+	return entry ? entry.value().CreateTime : 0;
+}
+
+HandleCache::Stats HandleCache::GetStats() const {
+	std::lock_guard lock(m_mutex);
+	return m_stats;
+}
+
+Result<HandleCache::Entry, Error>
+HandleCache::Acquire(Kind kind, DWORD id, DWORD access, DWORD preferred) {
+	const bool isProcess = kind == Kind::Process;
+	const Key key{kind, id};
+	DWORD held = 0;
+
+	// A hit costs no syscall: the entry's open handle keeps the id from being
+	// reused, so it still names the same object even if that object has exited.
+	{
+		std::lock_guard lock(m_mutex);
+		auto it = m_index.find(key);
+		if (it != m_index.end()) {
+			Entry &entry = *it->second;
+			if ((entry.Access & access) == access) {
+				++m_stats.Hits;
+				m_lru.splice(m_lru.begin(), m_lru, it->second);
+				return entry;
+			}
+			held = entry.Access;
+			++m_stats.Upgrades;
+		}
+		++m_stats.Misses;
+	}
+
+	// Widest first: everything the caller may want, then only what it needs.
+	const DWORD ambient = AmbientAccess(isProcess);
+	const DWORD attempts[] = {
+		access | held | preferred | ambient,
+		access | held | ambient,
+		access | ambient,
+		access,
+	};
+
+	HANDLE handle = nullptr;
+	DWORD granted = 0;
+	for (DWORD attempt : attempts) {
+		handle = isProcess ? OpenProcess(attempt, FALSE, id)
+						   : OpenThread(attempt, FALSE, id);
+		if (handle) {
+			granted = ExpandAccess(isProcess, attempt);
+			break;
+		}
+		if (GetLastError() != ERROR_ACCESS_DENIED) break;
+	}
+
+	if (!handle) {
+		return WinErr(
+			GetLastError(),
+			isProcess ? std::format("OpenProcess failed for PID {}", id)
+					  : std::format("OpenThread failed for TID {}", id)
+		);
+	}
+
+	Entry entry{key, SharedHandle(handle, CloseHandle), granted, 0};
+	entry.CreateTime = QueryCreateTime(isProcess, handle);
+	Insert(entry);
+	return entry;
+}
+
+void HandleCache::Insert(Entry entry) {
+	std::lock_guard lock(m_mutex);
+
+	// Another caller may have opened the same object meanwhile; the newer one wins.
+	auto it = m_index.find(entry.Id);
+	if (it != m_index.end()) {
+		m_lru.erase(it->second);
+		m_index.erase(it);
+	}
+
+	m_lru.push_front(std::move(entry));
+	m_index[m_lru.front().Id] = m_lru.begin();
+
+	while (m_lru.size() > m_capacity) {
+		m_index.erase(m_lru.back().Id);
+		m_lru.pop_back();
+		++m_stats.Evictions;
+	}
+}
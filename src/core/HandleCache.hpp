@@ -0,0 +1,90 @@
+#pragma once
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <Windows.h>
+
+#include "Result.hpp"
+#include "Error.hpp"
+
+/**
+ * @brief Shared owner of a cached HANDLE; stays open after eviction until released.
+ */
+using SharedHandle = std::shared_ptr<void>;
+
+/**
+ * @brief Process-wide LRU cache of process and thread handles. An entry stands for
+ *        (id, CreateTime) without checking either on a hit: Windows doesn't reuse
+ *        an id while a handle to its object is open, so as long as the entry holds
+ *        its handle the id can only mean that object. Once evicted, the id is
+ *        opened afresh. A call needing rights the cached handle lacks re-opens the
+ *        object with the combined mask. Thread-safe.
+ */
+class HandleCache {
+public:
+	struct Stats {
+		size_t Hits;
+		size_t Misses;
+		size_t Upgrades; // Misses that replaced a cached handle with too few rights
+		size_t Evictions;
+	};
+
+	static HandleCache &Shared();
+
+	/**
+	 * @brief Get a handle to the process with at least the requested rights.
+	 * @param preferred Extra rights to ask for up front; dropped if denied.
+	 */
+	Result<SharedHandle, Error> Process(DWORD pid, DWORD access, DWORD preferred = 0);
+
+	/**
+	 * @brief Get a handle to the thread with at least the requested rights.
+	 * @param preferred Extra rights to ask for up front; dropped if denied.
+	 */
+	Result<SharedHandle, Error> Thread(DWORD tid, DWORD access, DWORD preferred = 0);
+
+	/**
+	 * @brief Creation time of the process (FILETIME ticks), or 0 if it can't be read.
+	 */
+	ULONGLONG ProcessCreateTime(DWORD pid);
+
+	Stats GetStats() const;
+
+private:
+	enum class Kind
+	{
+		Process,
+		Thread,
+	};
+
+	struct Key {
+		Kind Type;
+		DWORD Id;
+
+		bool operator==(const Key &) const = default;
+	};
+
+	struct KeyHash {
+		size_t operator()(const Key &key) const noexcept;
+	};
+
+	struct Entry {
+		Key Id;
+		SharedHandle Handle;
+		DWORD Access;         // Granted rights, with implied rights expanded
+		ULONGLONG CreateTime; // 0 if the handle can't query times
+	};
+
+	explicit HandleCache(size_t capacity);
+
+	Result<Entry, Error> Acquire(Kind kind, DWORD id, DWORD access, DWORD preferred);
+	void Insert(Entry entry);
+
+	size_t m_capacity;
+	mutable std::mutex m_mutex;
+	std::list<Entry> m_lru; // Most recently used first
+	std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> m_index;
+	Stats m_stats{};
+};
@@ -0,0 +1,135 @@
+#include "ModuleMap.hpp"
+
+#include <format>
+#include <algorithm>
+
+#include "utils/CaseFold.hpp"
+
+// Only capturing talks to the system; the map and its cache also build off
+// Windows, for the tests under tests/.
+#if defined(_WIN32)
+#include <TlHelp32.h>
+
+#include "WinError.hpp"
+#include "HandleCache.hpp"
+#include "utils/ScopeExit.hpp"
+#include "utils/StringUtils.hpp"
+#endif
+
+ModuleMap::ModuleMap(std::vector<ModuleEntry> modules) : m_modules(std::move(modules)) {
+	std::erase_if(m_modules, [](const ModuleEntry &m) {
+		return m.Size == 0;
+	});
+	std::sort(
+		m_modules.begin(),
+		m_modules.end(),
+		[](const ModuleEntry &a, const ModuleEntry &b) {
+			return a.Base < b.Base;
+		}
+	);
+
+	// Keep intervals disjoint so a single upper_bound finds the owner.
+	std::vector<ModuleEntry> disjoint;
+	disjoint.reserve(m_modules.size());
+	for (auto &m : m_modules) {
+		if (!disjoint.empty()) {
+			const auto &prev = disjoint.back();
+			if (m.Base - prev.Base < prev.Size) continue;
+		}
+		disjoint.push_back(std::move(m));
+	}
+	m_modules = std::move(disjoint);
+}
+
+const ModuleEntry *ModuleMap::Find(ULONG_PTR address) const {
+	auto it = std::upper_bound(
+		m_modules.begin(),
+		m_modules.end(),
+		address,
+		[](ULONG_PTR value, const ModuleEntry &m) {
+			return value < m.Base;
+		}
+	);
+
+	if (it == m_modules.begin()) return nullptr;
+	--it;
+	return (address - it->Base < it->Size) ? &*it : nullptr;
+}
+
+std::vector<const ModuleEntry *> ModuleMap::FindByName(std::string_view name) const {
+	std::vector<const ModuleEntry *> matches;
+	for (const auto &m : m_modules) {
+		if (CaseFold::Equals(m.Name, name)) matches.push_back(&m);
+	}
+	return matches;
+}
+
+std::string ModuleMap::FormatAddress(ULONG_PTR address) const {
+	if (!address) return "";
+
+	if (const ModuleEntry *m = Find(address)) {
+		return std::format("{}+0x{:x}", m->Name, address - m->Base);
+	}
+	return std::format("0x{:x}", address);
+}
+
+Result<std::shared_ptr<const ModuleMap>, Error>
+ModuleMapCache::Get(DWORD pid, ULONGLONG createTime) {
+	if (createTime != 0) {
+		std::lock_guard lock(m_mutex);
+		auto it = m_maps.find({pid, createTime});
+		if (it != m_maps.end()) return it->second;
+	}
+
+	auto captured = m_capture(pid);
+	if (!captured) return captured.error();
+
+	auto map = std::make_shared<const ModuleMap>(std::move(captured.value()));
+	if (createTime == 0) return map; // Can't prove identity, don't cache
+
+	std::lock_guard lock(m_mutex);
+	// Drop maps of earlier processes that held the same PID.
+	std::erase_if(m_maps, [pid](const auto &item) {
+		return item.first.first == pid;
+	});
+	m_maps[{pid, createTime}] = map;
+	return map;
+}
+
+#if defined(_WIN32)
+Result<ModuleMap, Error> ModuleMap::Capture(DWORD pid) {
+	HANDLE hSnapshot;
+	// Toolhelp fails with ERROR_BAD_LENGTH while the target is loading modules.
+	do {
+		hSnapshot = CreateToolhelp32Snapshot(TH32CS_SNAPMODULE | TH32CS_SNAPMODULE32, pid);
+	} while (hSnapshot == INVALID_HANDLE_VALUE && GetLastError() == ERROR_BAD_LENGTH);
+
+	if (hSnapshot == INVALID_HANDLE_VALUE) {
+		return WinErr(
+			GetLastError(), std::format("Failed to snapshot modules for PID {}", pid)
+		);
+	}
+
+	SCOPE_EXIT(CloseHandle(hSnapshot));
+
+	std::vector<ModuleEntry> modules;
+	MODULEENTRY32W entry{};
+	entry.dwSize = sizeof(entry);
+	for (BOOL ok = Module32FirstW(hSnapshot, &entry); ok;
+		 ok = Module32NextW(hSnapshot, &entry)) {
+		modules.push_back(
+			{reinterpret_cast<ULONG_PTR>(entry.modBaseAddr),
+			 entry.modBaseSize,
+			 StringUtils::WstrToString(entry.szModule),
+			 entry.szExePath}
+		);
+	}
+
+	return ModuleMap(std::move(modules));
+}
+
+Result<std::shared_ptr<const ModuleMap>, Error> ModuleMap::ForProcess(DWORD pid) {
+	static ModuleMapCache cache(&ModuleMap::Capture);
+	return cache.Get(pid, HandleCache::Shared().ProcessCreateTime(pid));
+}
+#endif
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <Windows.h>
+
+#include "Result.hpp"
+#include "Error.hpp"
+
+struct ModuleEntry {
+	ULONG_PTR Base;
+	ULONG_PTR Size;
+	std::string Name; // Base name, e.g. "ntdll.dll"
+	std::wstring Path;
+};
+
+/**
+ * @brief Snapshot of the modules loaded in a process, sorted by base address
+ *        for O(log n) address to module lookups.
+ */
+class ModuleMap {
+public:
+	ModuleMap() = default;
+	explicit ModuleMap(std::vector<ModuleEntry> modules);
+
+	/**
+	 * @brief Find the module containing the address, or nullptr if none does.
+	 */
+	const ModuleEntry *Find(ULONG_PTR address) const;
+
+	/**
+	 * @brief Find all modules whose base name matches (case-insensitive).
+	 */
+	std::vector<const ModuleEntry *> FindByName(std::string_view name) const;
+
+	/**
+	 * @brief Format an address as module+0xoff, or 0xaddr outside any module.
+	 */
+	std::string FormatAddress(ULONG_PTR address) const;
+
+	const std::vector<ModuleEntry> &Modules() const { return m_modules; }
+
+	/**
+	 * @brief Capture the loaded modules of a process (uncached).
+	 */
+	static Result<ModuleMap, Error> Capture(DWORD pid);
+
+	/**
+	 * @brief Get the cached module map of a process, keyed by PID and creation time
+	 *        so a reused PID never sees the modules of an exited process.
+	 */
+	static Result<std::shared_ptr<const ModuleMap>, Error> ForProcess(DWORD pid);
+
+private:
+	std::vector<ModuleEntry> m_modules; // Sorted by Base, non-overlapping
+};
+
+/**
+ * @brief Module maps keyed by PID and creation time, so a reused PID never sees
+ *        the modules of an exited process. A creation time of 0 means the
+ *        process's identity couldn't be proven; such maps are never cached.
+ */
+class ModuleMapCache {
+public:
+	using CaptureFn = std::function<Result<ModuleMap, Error>(DWORD pid)>;
+
+	explicit ModuleMapCache(CaptureFn capture) : m_capture(std::move(capture)) {}
+
+	Result<std::shared_ptr<const ModuleMap>, Error> Get(DWORD pid, ULONGLONG createTime);
+
+private:
+	CaptureFn m_capture;
+	std::mutex m_mutex;
+	std::map<std::pair<DWORD, ULONGLONG>, std::shared_ptr<const ModuleMap>> m_maps;
+};
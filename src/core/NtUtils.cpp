@@ -1,7 +1,9 @@
 #include "NtUtils.hpp"
 
 #include <string>
+#include <cstring>
 #include <format>
+#include <memory>
 #include <vector>
 
 #define WIN32_LEAN_AND_MEAN
@@ -9,6 +11,9 @@
 #include <winternl.h>
 
 #include "WinError.hpp"
+#include "HandleCache.hpp"
+#include "ThreadHandles.hpp"
+#include "utils/ThreadPool.hpp"
 
 // Only need these two from ntstatus.h — can't include the full header
 // because NtUtils.hpp already pulled in Windows.h (which defines a
@@ -34,6 +39,7 @@ typedef struct _SYSTEM_PROCESS_ID_INFORMATION {
 typedef NTSTATUS(WINAPI *PNtQueryInformationProcess)(HANDLE, UINT, PVOID, ULONG, PULONG);
 
 static std::wstring DevicePathToDrivePath(const std::wstring &ntPath);
+static bool IsFullySuspended(const SYSTEM_PROCESS_INFORMATION *procInfo);
 
 NtUtils::NtUtils() {
 	m_hNtDll = GetModuleHandleW(L"ntdll.dll");
@@ -48,81 +54,30 @@ HMODULE NtUtils::GetNtdllModule() {
 }
 
 Result<bool, Error> NtUtils::IsProcessSuspended(DWORD pid) {
-	HMODULE hNtDll = GetNtdllModule();
-	if (!hNtDll) {
-		return WinErr(GetLastError(), "Failed to load module ntdll.dll");
-	}
-
-	// Resolve NtQuerySystemInformation
-	using NtQuerySystemInformationFn = NTSTATUS(NTAPI *)(
-		ULONG SystemInformationClass,
-		PVOID SystemInformation,
-		ULONG SystemInformationLength,
-		PULONG ReturnLength
-	);
-
-	auto NtQuerySystemInformation = reinterpret_cast<NtQuerySystemInformationFn>(
-		GetProcAddress(hNtDll, "NtQuerySystemInformation")
-	);
-
-	if (!NtQuerySystemInformation) {
-		return Error("Symbol not found: ntdll.dll!NtQuerySystemInformation");
-	}
-
-	constexpr ULONG SystemProcessInformation = 5;
-	constexpr ULONG StateWaiting = 5;
-	constexpr ULONG ReasonSuspended = 5;
-
-	// Query system process information with dynamic buffer sizing
-	ULONG bufferSize = 1024 * 1024; // Start with 1 MB
-	auto buffer = std::make_unique<BYTE[]>(bufferSize);
-
-	ULONG returnLength = 0;
-	NTSTATUS status = NtQuerySystemInformation(
-		SystemProcessInformation, buffer.get(), bufferSize, &returnLength
-	);
-
-	if (status == STATUS_INFO_LENGTH_MISMATCH) {
-		bufferSize = returnLength;
-		buffer = std::make_unique<BYTE[]>(bufferSize);
-		status = NtQuerySystemInformation(
-			SystemProcessInformation, buffer.get(), bufferSize, &returnLength
-		);
-	}
-
-	if (!NT_SUCCESS(status)) {
-		return NtStatusErr(
-			status,
-			std::format("Failed to query system process information for PID: {}", pid)
+	auto bufferResult = QuerySystemProcessInformation();
+	if (!bufferResult) {
+		return Error(
+			std::format(
+				"Failed to query system process information for PID: {}\nCause: {}",
+				pid,
+				bufferResult.error().message
+			)
 		);
 	}
 
 	// Walk the process list to find our target PID
-	auto *procInfo = reinterpret_cast<SYSTEM_PROCESS_INFORMATION *>(buffer.get());
+	const BYTE *buffer = bufferResult.value().get();
+	auto *procInfo = reinterpret_cast<const SYSTEM_PROCESS_INFORMATION *>(buffer);
 
 	while (true) {
 		if (reinterpret_cast<ULONG_PTR>(procInfo->UniqueProcessId) ==
 			static_cast<ULONG_PTR>(pid)) {
-			ULONG threadCount = procInfo->NumberOfThreads;
-			if (threadCount == 0) return false;
-
-			// Thread array follows immediately after the SYSTEM_PROCESS_INFORMATION header
-			auto *threads = reinterpret_cast<SYSTEM_THREAD_INFORMATION *>(
-				reinterpret_cast<BYTE *>(procInfo) + sizeof(SYSTEM_PROCESS_INFORMATION)
-			);
-
-			for (ULONG i = 0; i < threadCount; ++i) {
-				if (threads[i].ThreadState != StateWaiting ||
-					threads[i].WaitReason != ReasonSuspended) {
-					return false;
-				}
-			}
-			return true;
+			return IsFullySuspended(procInfo);
 		}
 
 		if (procInfo->NextEntryOffset == 0) break;
-		procInfo = reinterpret_cast<SYSTEM_PROCESS_INFORMATION *>(
-			reinterpret_cast<BYTE *>(procInfo) + procInfo->NextEntryOffset
+		procInfo = reinterpret_cast<const SYSTEM_PROCESS_INFORMATION *>(
+			reinterpret_cast<const BYTE *>(procInfo) + procInfo->NextEntryOffset
 		);
 	}
 
@@ -143,15 +98,18 @@ Result<std::monostate, Error> NtUtils::SuspendProcess(DWORD pid) {
 		return Error("Symbol not found: ntdll.dll!NtSuspendProcess");
 	}
 
-	HANDLE hProcess = OpenProcess(PROCESS_SUSPEND_RESUME, FALSE, pid);
+	auto hProcess = HandleCache::Shared().Process(pid, PROCESS_SUSPEND_RESUME);
 	if (!hProcess) {
-		return WinErr(
-			GetLastError(), std::format("Failed to open process with PID: {}", pid)
+		return Error(
+			std::format(
+				"Failed to open process with PID: {}\nCause: {}",
+				pid,
+				hProcess.error().message
+			)
 		);
 	}
 
-	NTSTATUS status = NtSuspendProcessPtr(hProcess);
-	CloseHandle(hProcess);
+	NTSTATUS status = NtSuspendProcessPtr(hProcess.value().get());
 
 	if (!NT_SUCCESS(status)) {
 		return NtStatusErr(
@@ -176,15 +134,18 @@ Result<std::monostate, Error> NtUtils::ResumeProcess(DWORD pid) {
 		return Error("Symbol not found: ntdll.dll!NtResumeProcess");
 	}
 
-	HANDLE hProcess = OpenProcess(PROCESS_SUSPEND_RESUME, FALSE, pid);
+	auto hProcess = HandleCache::Shared().Process(pid, PROCESS_SUSPEND_RESUME);
 	if (!hProcess) {
-		return WinErr(
-			GetLastError(), std::format("Failed to open process with PID: {}", pid)
+		return Error(
+			std::format(
+				"Failed to open process with PID: {}\nCause: {}",
+				pid,
+				hProcess.error().message
+			)
 		);
 	}
 
-	NTSTATUS status = NtResumeProcessPtr(hProcess);
-	CloseHandle(hProcess);
+	NTSTATUS status = NtResumeProcessPtr(hProcess.value().get());
 
 	if (!NT_SUCCESS(status)) {
 		return NtStatusErr(
@@ -195,7 +156,7 @@ Result<std::monostate, Error> NtUtils::ResumeProcess(DWORD pid) {
 	return std::monostate{};
 }
 
-Result<std::vector<ProcessInfo>, Error> NtUtils::GetProcessList() {
+Result<std::unique_ptr<BYTE[]>, Error> NtUtils::QuerySystemProcessInformation() {
 	HMODULE hNtDll = GetNtdllModule();
 	if (!hNtDll) {
 		return WinErr(GetLastError(), "Failed to load module ntdll.dll");
@@ -217,82 +178,81 @@ Result<std::vector<ProcessInfo>, Error> NtUtils::GetProcessList() {
 	}
 
 	constexpr ULONG SystemProcessInformation = 5;
-	ULONG bufferSize = 1024 * 1024; // Start with 1 MB
-	auto buffer = std::make_unique<BYTE[]>(bufferSize);
+	ULONG bufferSize = 1024 * 1024; // Start with 1 MB, filled only by the call
+	auto buffer = std::make_unique_for_overwrite<BYTE[]>(bufferSize);
 
 	ULONG returnLength = 0;
 	NTSTATUS status = NtQuerySystemInformation(
 		SystemProcessInformation, buffer.get(), bufferSize, &returnLength
 	);
 
-	if (status == STATUS_INFO_LENGTH_MISMATCH) {
-		bufferSize = returnLength;
-		buffer = std::make_unique<BYTE[]>(bufferSize);
+	// Processes and threads may be created between the calls, so keep growing.
+	while (status == STATUS_INFO_LENGTH_MISMATCH) {
+		bufferSize = returnLength + 64 * 1024;
+		buffer = std::make_unique_for_overwrite<BYTE[]>(bufferSize);
 		status = NtQuerySystemInformation(
 			SystemProcessInformation, buffer.get(), bufferSize, &returnLength
 		);
 	}
 
 	if (!NT_SUCCESS(status)) {
-		return NtStatusErr(status, std::format("Failed to query system process list"));
+		return NtStatusErr(status, "Failed to query system process information");
 	}
 
-	auto *procInfo = reinterpret_cast<SYSTEM_PROCESS_INFORMATION *>(buffer.get());
-	std::vector<ProcessInfo> processList;
-	processList.reserve(bufferSize);
-
-	while (true) {
-		ProcessInfo info{};
-		info.Pid =
-			static_cast<DWORD>(reinterpret_cast<ULONG_PTR>(procInfo->UniqueProcessId));
-		info.ParentPid =
-			static_cast<DWORD>(reinterpret_cast<ULONG_PTR>(procInfo->Reserved2));
-		info.SessionId = procInfo->SessionId;
-		info.BasePriority = procInfo->BasePriority;
-		info.Memory = procInfo->WorkingSetSize;
-
-		if (procInfo->ImageName.Buffer) {
-			info.Name = std::wstring(
-				procInfo->ImageName.Buffer, procInfo->ImageName.Length / sizeof(WCHAR)
-			);
-		} else if (info.Pid == 0) {
-			info.Name = L"Idle";
-		} else {
-			info.Name = L"System";
-		}
-
-		processList.push_back(info);
-
-		if (procInfo->NextEntryOffset == 0) break;
-		procInfo = reinterpret_cast<SYSTEM_PROCESS_INFORMATION *>(
-			reinterpret_cast<BYTE *>(procInfo) + procInfo->NextEntryOffset
-		);
-	}
-
-	return processList;
+	return buffer;
 }
 
-Result<std::vector<ThreadInfo>, Error> NtUtils::GetProcessThreads(DWORD pid) {
-	HMODULE hNtDll = GetNtdllModule();
-	if (!hNtDll) {
-		return WinErr(GetLastError(), "Failed to load module ntdll.dll");
-	}
+// True when the process has threads and every one of them is waiting as suspended.
+static bool IsFullySuspended(const SYSTEM_PROCESS_INFORMATION *procInfo) {
+	constexpr ULONG StateWaiting = 5;
+	constexpr ULONG ReasonSuspended = 5;
 
-	using NtQuerySystemInformationFn = NTSTATUS(NTAPI *)(
-		ULONG SystemInformationClass,
-		PVOID SystemInformation,
-		ULONG SystemInformationLength,
-		PULONG ReturnLength
-	);
+	ULONG threadCount = procInfo->NumberOfThreads;
+	if (threadCount == 0) return false;
 
-	auto NtQuerySystemInformation = reinterpret_cast<NtQuerySystemInformationFn>(
-		GetProcAddress(hNtDll, "NtQuerySystemInformation")
+	// Thread array follows immediately after the SYSTEM_PROCESS_INFORMATION header
+	auto *threads = reinterpret_cast<const SYSTEM_THREAD_INFORMATION *>(
+		reinterpret_cast<const BYTE *>(procInfo) + sizeof(SYSTEM_PROCESS_INFORMATION)
 	);
 
-	if (!NtQuerySystemInformation) {
-		return Error("Symbol not found: ntdll.dll!NtQuerySystemInformation");
+	for (ULONG i = 0; i < threadCount; ++i) {
+		if (threads[i].ThreadState != StateWaiting ||
+			threads[i].WaitReason != ReasonSuspended) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static ProcessInfo DecodeProcessInfo(const SYSTEM_PROCESS_INFORMATION *procInfo) {
+	ProcessInfo info{};
+	info.Pid = static_cast<DWORD>(reinterpret_cast<ULONG_PTR>(procInfo->UniqueProcessId));
+	info.ParentPid = static_cast<DWORD>(reinterpret_cast<ULONG_PTR>(procInfo->Reserved2));
+	info.SessionId = procInfo->SessionId;
+	info.BasePriority = procInfo->BasePriority;
+	info.Memory = procInfo->WorkingSetSize;
+	info.ThreadCount = procInfo->NumberOfThreads;
+	// Reserved1 = {WorkingSetPrivateSize, HardFaultCount, NumberOfThreadsHighWatermark,
+	//              CycleTime, CreateTime, UserTime, KernelTime}
+	LARGE_INTEGER times[3]; // CreateTime, UserTime, KernelTime
+	std::memcpy(times, procInfo->Reserved1 + 24, sizeof(times));
+	info.CreateTime = times[0].QuadPart;
+	info.CpuTime = times[1].QuadPart + times[2].QuadPart;
+	info.Suspended = IsFullySuspended(procInfo);
+
+	if (procInfo->ImageName.Buffer) {
+		info.Name = std::wstring(
+			procInfo->ImageName.Buffer, procInfo->ImageName.Length / sizeof(WCHAR)
+		);
+	} else if (info.Pid == 0) {
+		info.Name = L"Idle";
+	} else {
+		info.Name = L"System";
 	}
+	return info;
+}
 
+PVOID NtUtils::GetThreadStartAddress(HANDLE hThread) {
 	using NtQueryInformationThreadFn = NTSTATUS(NTAPI *)(
 		HANDLE ThreadHandle,
 		ULONG ThreadInformationClass,
@@ -301,99 +261,190 @@ Result<std::vector<ThreadInfo>, Error> NtUtils::GetProcessThreads(DWORD pid) {
 		PULONG ReturnLength
 	);
 
-	auto NtQueryInformationThread = reinterpret_cast<NtQueryInformationThreadFn>(
-		GetProcAddress(hNtDll, "NtQueryInformationThread")
+	static auto NtQueryInformationThread = reinterpret_cast<NtQueryInformationThreadFn>(
+		GetProcAddress(GetNtdllModule(), "NtQueryInformationThread")
 	);
 
-	if (!NtQueryInformationThread) {
-		return Error("Symbol not found: ntdll.dll!NtQueryInformationThread");
-	}
+	if (!NtQueryInformationThread) return nullptr;
 
-	constexpr ULONG SystemProcessInformation = 5;
 	constexpr ULONG ThreadQuerySetWin32StartAddress = 9;
 
-	ULONG bufferSize = 1024 * 1024; // Start with 1 MB
-	auto buffer = std::make_unique<BYTE[]>(bufferSize);
+	PVOID win32StartAddress = nullptr;
+	NTSTATUS status = NtQueryInformationThread(
+		hThread,
+		ThreadQuerySetWin32StartAddress,
+		&win32StartAddress,
+		sizeof(PVOID),
+		nullptr
+	);
 
-	ULONG returnLength = 0;
-	NTSTATUS status = NtQuerySystemInformation(
-		SystemProcessInformation, buffer.get(), bufferSize, &returnLength
+	return status == STATUS_SUCCESS ? win32StartAddress : nullptr;
+}
+
+static std::vector<ThreadInfo>
+DecodeThreads(const SYSTEM_PROCESS_INFORMATION *procInfo, ThreadHandles *handles) {
+	ULONG threadCount = procInfo->NumberOfThreads;
+
+	// Thread array follows immediately after the SYSTEM_PROCESS_INFORMATION header
+	auto *threads = reinterpret_cast<const SYSTEM_THREAD_INFORMATION *>(
+		reinterpret_cast<const BYTE *>(procInfo) + sizeof(SYSTEM_PROCESS_INFORMATION)
 	);
 
-	if (status == STATUS_INFO_LENGTH_MISMATCH) {
-		bufferSize = returnLength;
-		buffer = std::make_unique<BYTE[]>(bufferSize);
-		status = NtQuerySystemInformation(
-			SystemProcessInformation, buffer.get(), bufferSize, &returnLength
+	std::vector<ThreadInfo> threadsList(threadCount);
+
+	for (ULONG i = 0; i < threadCount; ++i) {
+		ThreadInfo &info = threadsList[i];
+		info.Tid = static_cast<DWORD>(
+			reinterpret_cast<ULONG_PTR>(threads[i].ClientId.UniqueThread)
+		);
+		info.NativeStartAddress = threads[i].StartAddress;
+		info.Win32StartAddress = nullptr;
+		info.BasePriority = threads[i].BasePriority;
+		info.ThreadState = threads[i].ThreadState;
+		info.WaitReason = threads[i].WaitReason;
+		// Reserved1 = {KernelTime, UserTime, CreateTime}, Reserved3 = ContextSwitches
+		info.KernelTime = threads[i].Reserved1[0].QuadPart;
+		info.UserTime = threads[i].Reserved1[1].QuadPart;
+		info.CreateTime = threads[i].Reserved1[2].QuadPart;
+		info.ContextSwitches = threads[i].Reserved3;
+	}
+
+	if (!handles) return threadsList;
+
+	// One OpenThread + query per thread: fan out, each writes only its own slot.
+	ThreadPool::Shared().ParallelFor(threadsList.size(), [&](size_t i) {
+		ThreadInfo &info = threadsList[i];
+		auto hThread = handles->Get(info.Tid, THREAD_QUERY_INFORMATION);
+		if (hThread) {
+			info.Win32StartAddress = NtUtils::GetThreadStartAddress(hThread.value());
+		}
+	});
+	return threadsList;
+}
+
+Result<std::vector<ProcessInfo>, Error> NtUtils::GetProcessList() {
+	auto bufferResult = QuerySystemProcessInformation();
+	if (!bufferResult) {
+		return Error(
+			std::format(
+				"Failed to query system process list\nCause: {}",
+				bufferResult.error().message
+			)
 		);
 	}
 
-	if (!NT_SUCCESS(status)) {
-		return NtStatusErr(
-			status,
-			std::format("Failed to query system thread information for PID: {}", pid)
+	const BYTE *buffer = bufferResult.value().get();
+	auto *procInfo = reinterpret_cast<const SYSTEM_PROCESS_INFORMATION *>(buffer);
+	std::vector<ProcessInfo> processList;
+
+	while (true) {
+		processList.push_back(DecodeProcessInfo(procInfo));
+
+		if (procInfo->NextEntryOffset == 0) break;
+		procInfo = reinterpret_cast<const SYSTEM_PROCESS_INFORMATION *>(
+			reinterpret_cast<const BYTE *>(procInfo) + procInfo->NextEntryOffset
+		);
+	}
+
+	return processList;
+}
+
+ResultVoid NtUtils::ForEachProcess(const ProcessVisitor &visit) {
+	auto bufferResult = QuerySystemProcessInformation();
+	if (!bufferResult) {
+		return Error(
+			std::format(
+				"Failed to query system process list\nCause: {}",
+				bufferResult.error().message
+			)
 		);
 	}
 
-	auto *procInfo = reinterpret_cast<SYSTEM_PROCESS_INFORMATION *>(buffer.get());
+	const BYTE *buffer = bufferResult.value().get();
+	auto *procInfo = reinterpret_cast<const SYSTEM_PROCESS_INFORMATION *>(buffer);
+
+	while (true) {
+		const auto pid =
+			static_cast<DWORD>(reinterpret_cast<ULONG_PTR>(procInfo->UniqueProcessId));
+		const UNICODE_STRING &image = procInfo->ImageName;
+
+		if (image.Buffer) {
+			visit(pid, std::wstring_view(image.Buffer, image.Length / sizeof(WCHAR)));
+		} else {
+			visit(pid, pid == 0 ? L"Idle" : L"System"); // Same names as GetProcessList
+		}
+
+		if (procInfo->NextEntryOffset == 0) break;
+		procInfo = reinterpret_cast<const SYSTEM_PROCESS_INFORMATION *>(
+			reinterpret_cast<const BYTE *>(procInfo) + procInfo->NextEntryOffset
+		);
+	}
+
+	return std::monostate{};
+}
+
+Result<std::vector<ThreadInfo>, Error> NtUtils::GetProcessThreads(DWORD pid) {
+	ThreadHandles handles(THREAD_QUERY_INFORMATION);
+	return GetProcessThreads(pid, &handles);
+}
+
+Result<std::vector<ThreadInfo>, Error>
+NtUtils::GetProcessThreads(DWORD pid, ThreadHandles *handles) {
+	auto bufferResult = QuerySystemProcessInformation();
+	if (!bufferResult) {
+		return Error(
+			std::format(
+				"Failed to query system thread information for PID: {}\nCause: {}",
+				pid,
+				bufferResult.error().message
+			)
+		);
+	}
+
+	const BYTE *buffer = bufferResult.value().get();
+	auto *procInfo = reinterpret_cast<const SYSTEM_PROCESS_INFORMATION *>(buffer);
 
 	while (true) {
 		if (reinterpret_cast<ULONG_PTR>(procInfo->UniqueProcessId) ==
 			static_cast<ULONG_PTR>(pid)) {
-			ULONG threadCount = procInfo->NumberOfThreads;
-
-			auto *threads = reinterpret_cast<SYSTEM_THREAD_INFORMATION *>(
-				reinterpret_cast<BYTE *>(procInfo) + sizeof(SYSTEM_PROCESS_INFORMATION)
-			);
-
-			std::vector<ThreadInfo> threadsList;
-			threadsList.reserve(threadCount);
-
-			for (ULONG i = 0; i < threadCount; ++i) {
-				ThreadInfo info{};
-				info.Tid = static_cast<DWORD>(
-					reinterpret_cast<ULONG_PTR>(threads[i].ClientId.UniqueThread)
-				);
-				info.NativeStartAddress = threads[i].StartAddress;
-
-				HANDLE hThread = OpenThread(THREAD_QUERY_INFORMATION, FALSE, info.Tid);
-				if (hThread) {
-					PVOID win32StartAddress = nullptr;
-					status = NtQueryInformationThread(
-						hThread,
-						ThreadQuerySetWin32StartAddress,
-						&win32StartAddress,
-						sizeof(PVOID),
-						nullptr
-					);
-
-					if (status == STATUS_SUCCESS) {
-						info.Win32StartAddress = win32StartAddress;
-					} else {
-						info.Win32StartAddress = nullptr;
-					}
-					CloseHandle(hThread);
-				} else {
-					info.Win32StartAddress = nullptr;
-				}
-
-				info.BasePriority = threads[i].BasePriority;
-				info.ThreadState = threads[i].ThreadState;
-				info.WaitReason = threads[i].WaitReason;
-				threadsList.push_back(info);
-			}
-			return threadsList;
+			return DecodeThreads(procInfo, handles);
 		}
 
 		if (procInfo->NextEntryOffset == 0) break;
-		procInfo = reinterpret_cast<SYSTEM_PROCESS_INFORMATION *>(
-			reinterpret_cast<BYTE *>(procInfo) + procInfo->NextEntryOffset
+		procInfo = reinterpret_cast<const SYSTEM_PROCESS_INFORMATION *>(
+			reinterpret_cast<const BYTE *>(procInfo) + procInfo->NextEntryOffset
 		);
 	}
 
 	return Error(std::format("No process found with PID: {}", pid));
 }
 
+Result<std::vector<ProcessThreads>, Error>
+NtUtils::GetAllProcessThreads(bool queryStartAddress) {
+	auto bufferResult = QuerySystemProcessInformation();
+	if (!bufferResult) return bufferResult.error();
+
+	const BYTE *buffer = bufferResult.value().get();
+	auto *procInfo = reinterpret_cast<const SYSTEM_PROCESS_INFORMATION *>(buffer);
+	std::vector<ProcessThreads> snapshot;
+
+	while (true) {
+		// Per process, so a system-wide walk doesn't hold every thread open at once.
+		ThreadHandles handles(THREAD_QUERY_INFORMATION);
+		snapshot.push_back(
+			{DecodeProcessInfo(procInfo),
+			 DecodeThreads(procInfo, queryStartAddress ? &handles : nullptr)}
+		);
+
+		if (procInfo->NextEntryOffset == 0) break;
+		procInfo = reinterpret_cast<const SYSTEM_PROCESS_INFORMATION *>(
+			reinterpret_cast<const BYTE *>(procInfo) + procInfo->NextEntryOffset
+		);
+	}
+
+	return snapshot;
+}
+
 Result<std::wstring, Error> NtUtils::GetProcessPath(DWORD pid) {
 	HMODULE hNtDll = GetNtdllModule();
 	if (!hNtDll) {
@@ -446,6 +497,47 @@ Result<std::wstring, Error> NtUtils::GetProcessPath(DWORD pid) {
 	}
 }
 
+Result<std::wstring, Error> NtUtils::GetProcessCommandLine(HANDLE hProcess) {
+	static auto NtQueryInformationProcess = reinterpret_cast<PNtQueryInformationProcess>(
+		GetProcAddress(GetNtdllModule(), "NtQueryInformationProcess")
+	);
+
+	if (!NtQueryInformationProcess) {
+		return Error("Symbol not found: ntdll.dll!NtQueryInformationProcess");
+	}
+
+	// Returns a UNICODE_STRING followed by its characters. Most command lines fit
+	// the first buffer; otherwise the call reports the size it needs.
+	constexpr UINT ProcessCommandLineInformation = 60;
+	ULONG bufferSize = 2048;
+	auto buffer = std::make_unique<BYTE[]>(bufferSize);
+
+	ULONG returnLength = 0;
+	NTSTATUS status = NtQueryInformationProcess(
+		hProcess, ProcessCommandLineInformation, buffer.get(), bufferSize, &returnLength
+	);
+
+	if (status == STATUS_INFO_LENGTH_MISMATCH && returnLength > bufferSize) {
+		bufferSize = returnLength;
+		buffer = std::make_unique<BYTE[]>(bufferSize);
+		status = NtQueryInformationProcess(
+			hProcess,
+			ProcessCommandLineInformation,
+			buffer.get(),
+			bufferSize,
+			&returnLength
+		);
+	}
+
+	if (!NT_SUCCESS(status)) {
+		return NtStatusErr(status, "Failed to query process command line");
+	}
+
+	const auto *commandLine = reinterpret_cast<const UNICODE_STRING *>(buffer.get());
+	if (!commandLine->Buffer) return std::wstring();
+	return std::wstring(commandLine->Buffer, commandLine->Length / sizeof(WCHAR));
+}
+
 // Helper to convert NT internal path to Drive path
 static std::wstring DevicePathToDrivePath(const std::wstring &ntPath) {
 	if (ntPath.empty()) return ntPath;
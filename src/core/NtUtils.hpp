@@ -1,5 +1,9 @@
 #pragma once
 
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
 #include <variant>
 #include <vector>
 #include <Windows.h>
@@ -14,6 +18,10 @@ struct ThreadInfo {
 	LONG BasePriority;
 	ULONG ThreadState;
 	ULONG WaitReason;
+	ULONGLONG KernelTime; // 100ns units
+	ULONGLONG UserTime;   // 100ns units
+	ULONGLONG CreateTime; // FILETIME, tells a reused TID apart
+	ULONG ContextSwitches;
 };
 
 struct ProcessInfo {
@@ -23,6 +31,17 @@ struct ProcessInfo {
 	ULONG SessionId;
 	LONG BasePriority;
 	SIZE_T Memory;
+	ULONG ThreadCount;
+	ULONGLONG CpuTime;    // Kernel + user time, 100ns units
+	ULONGLONG CreateTime; // FILETIME, tells a reused PID apart
+	bool Suspended;       // Every thread is waiting as suspended
+};
+
+class ThreadHandles;
+
+struct ProcessThreads {
+	ProcessInfo Process;
+	std::vector<ThreadInfo> Threads;
 };
 
 class NtUtils {
@@ -48,18 +67,56 @@ public:
 	static Result<std::vector<ThreadInfo>, Error> GetProcessThreads(DWORD pid);
 
 	/**
-	 * @brief Get a list of all running processes.
+	 * @brief Get threads information for the specified process, opening threads for
+	 *        the Win32 start address through the shared handle table.
+	 *        Pass nullptr to skip the start address query (snapshot only).
+	 */
+	static Result<std::vector<ThreadInfo>, Error>
+	GetProcessThreads(DWORD pid, ThreadHandles *handles);
+
+	/**
+	 * @brief Get every process with its threads from a single system snapshot.
+	 *        Win32 start addresses need one OpenThread per thread, so they are optional.
+	 */
+	static Result<std::vector<ProcessThreads>, Error>
+	GetAllProcessThreads(bool queryStartAddress);
+
+	/**
+	 * @brief Get the Win32 start address of a thread (nullptr if it can't be queried).
+	 *        The handle needs THREAD_QUERY_INFORMATION.
+	 */
+	static PVOID GetThreadStartAddress(HANDLE hThread);
+
+	/**
+	 * @brief Get a list of all running processes. Suspended state is computed for
+	 *        every process in the same pass over one snapshot.
 	 */
 	static Result<std::vector<ProcessInfo>, Error> GetProcessList();
 
+	using ProcessVisitor = std::function<void(DWORD pid, std::wstring_view name)>;
+
+	/**
+	 * @brief Visit every process in one snapshot without decoding it into
+	 *        ProcessInfo. Names point into the snapshot buffer and are only valid
+	 *        during the call.
+	 */
+	static ResultVoid ForEachProcess(const ProcessVisitor &visit);
+
 	/**
 	 * @brief Get the image path of the specified process.
 	 */
 	static Result<std::wstring, Error> GetProcessPath(DWORD pid);
 
+	/**
+	 * @brief Get the command line of a process without reading its memory.
+	 *        The handle needs PROCESS_QUERY_LIMITED_INFORMATION.
+	 */
+	static Result<std::wstring, Error> GetProcessCommandLine(HANDLE hProcess);
+
 private:
 	NtUtils();
 	~NtUtils() = default;
 	static HMODULE GetNtdllModule();
+	static Result<std::unique_ptr<BYTE[]>, Error> QuerySystemProcessInformation();
 	HMODULE m_hNtDll; /* Handle to the ntdll.dll module */
 };
@@ -0,0 +1,175 @@
+#include "ProcessTree.hpp"
+
+#include <algorithm>
+#include <unordered_map>
+
+ProcessTree::ProcessTree(std::span<const ProcessInfo> processes)
+	: m_parents(processes.size(), NoParent), m_offsets(processes.size() + 1, 0) {
+	const auto count = static_cast<uint32_t>(processes.size());
+
+	std::unordered_map<DWORD, uint32_t> byPid;
+	byPid.reserve(count);
+	for (uint32_t i = 0; i < count; ++i) byPid.emplace(processes[i].Pid, i);
+
+	for (uint32_t i = 0; i < count; ++i) {
+		auto it = byPid.find(processes[i].ParentPid);
+		if (it == byPid.end() || it->second == i) continue;
+
+		const uint32_t parent = it->second;
+		// The PID was reused by a process started after this one.
+		if (processes[parent].CreateTime > processes[i].CreateTime) continue;
+
+		m_parents[i] = parent;
+	}
+
+	// Cut loops: walk up from each process, marking the path, until reaching a
+	// process already placed. Arriving back on the current path closes a loop.
+	enum : uint8_t { Unseen, OnPath, Placed };
+	std::vector<uint8_t> state(count, Unseen);
+	for (uint32_t i = 0; i < count; ++i) {
+		uint32_t node = i;
+		while (node != NoParent && state[node] == Unseen) {
+			state[node] = OnPath;
+			node = m_parents[node];
+		}
+		const uint32_t closing = node != NoParent && state[node] == OnPath ? node : NoParent;
+
+		for (node = i; node != NoParent && state[node] == OnPath;) {
+			state[node] = Placed;
+			node = m_parents[node];
+		}
+		if (closing != NoParent) m_parents[closing] = NoParent;
+	}
+
+	for (uint32_t i = 0; i < count; ++i) {
+		if (m_parents[i] != NoParent) ++m_offsets[m_parents[i] + 1];
+	}
+
+	for (uint32_t i = 0; i < count; ++i) m_offsets[i + 1] += m_offsets[i];
+
+	// Children land in snapshot order within each parent's slice.
+	m_children.resize(m_offsets[count]);
+	std::vector<uint32_t> cursor(m_offsets.begin(), m_offsets.end() - 1);
+	for (uint32_t i = 0; i < count; ++i) {
+		if (m_parents[i] != NoParent) m_children[cursor[m_parents[i]]++] = i;
+	}
+}
+
+std::vector<uint32_t> ProcessTree::Roots() const {
+	std::vector<uint32_t> roots;
+	for (uint32_t i = 0; i < Size(); ++i) {
+		if (m_parents[i] == NoParent) roots.push_back(i);
+	}
+	return roots;
+}
+
+std::vector<uint32_t> ProcessTree::Topmost(std::span<const uint32_t> roots) const {
+	std::vector<bool> isRoot(Size(), false);
+	for (uint32_t root : roots) isRoot[root] = true;
+
+	std::vector<uint32_t> topmost;
+	for (uint32_t root : roots) {
+		uint32_t node = m_parents[root];
+		while (node != NoParent && !isRoot[node]) node = m_parents[node];
+		if (node == NoParent) topmost.push_back(root);
+	}
+	return topmost;
+}
+
+std::vector<uint32_t>
+ProcessTree::Subtrees(std::span<const uint32_t> roots, bool includeRoots) const {
+	// Start only from roots with no other root above them, so that every parent
+	// is listed before its children.
+	const auto topmost = Topmost(roots);
+
+	std::vector<uint32_t> stack;
+	for (auto it = topmost.rbegin(); it != topmost.rend(); ++it) {
+		if (includeRoots) {
+			stack.push_back(*it);
+		} else {
+			const auto children = Children(*it);
+			stack.insert(stack.end(), children.rbegin(), children.rend());
+		}
+	}
+
+	std::vector<uint32_t> order;
+	std::vector<bool> visited(Size(), false);
+	while (!stack.empty()) {
+		const uint32_t node = stack.back();
+		stack.pop_back();
+		if (visited[node]) continue;
+
+		visited[node] = true;
+		order.push_back(node);
+		const auto children = Children(node);
+		stack.insert(stack.end(), children.rbegin(), children.rend());
+	}
+	return order;
+}
+
+std::vector<ProcessTotals>
+ProcessTree::Rollup(std::span<const ProcessInfo> processes) const {
+	std::vector<ProcessTotals> totals(Size());
+	for (size_t i = 0; i < Size(); ++i) {
+		totals[i] = {processes[i].Memory, processes[i].ThreadCount, processes[i].CpuTime};
+	}
+
+	// Children come after their parent in preorder, so walking it backwards
+	// finishes every subtree before its total is added to the parent.
+	const auto order = Subtrees(Roots(), true);
+	for (auto it = order.rbegin(); it != order.rend(); ++it) {
+		if (m_parents[*it] != NoParent) totals[m_parents[*it]] += totals[*it];
+	}
+	return totals;
+}
+
+ProcessTreeReport ProcessTree::BuildReport(
+	std::vector<ProcessInfo> processes, std::span<const uint32_t> roots, TreeSort sort
+) {
+	const ProcessTree tree(processes);
+
+	ProcessTreeReport report;
+	report.Totals = tree.Rollup(processes);
+	const auto &totals = report.Totals;
+
+	auto order = [&](std::vector<uint32_t> &siblings) {
+		auto key = [&](uint32_t i) -> ULONGLONG {
+			switch (sort) {
+			case TreeSort::Memory: return totals[i].Memory;
+			case TreeSort::Threads: return totals[i].Threads;
+			case TreeSort::Cpu: return totals[i].CpuTime;
+			default: return 0;
+			}
+		};
+		std::stable_sort(siblings.begin(), siblings.end(), [&](uint32_t a, uint32_t b) {
+			if (sort == TreeSort::Pid) return processes[a].Pid < processes[b].Pid;
+			return key(a) > key(b);
+		});
+	};
+
+	struct Pending {
+		uint32_t Process;
+		uint32_t Depth;
+		bool LastChild;
+	};
+	std::vector<Pending> stack;
+	auto push = [&](std::vector<uint32_t> siblings, uint32_t depth) {
+		order(siblings);
+		for (size_t k = siblings.size(); k-- > 0;) {
+			stack.push_back({siblings[k], depth, k + 1 == siblings.size()});
+		}
+	};
+
+	push(roots.empty() ? tree.Roots() : tree.Topmost(roots), 0);
+	while (!stack.empty()) {
+		const Pending row = stack.back();
+		stack.pop_back();
+		report.Rows.push_back({row.Process, row.Depth, row.LastChild});
+
+		const auto children = tree.Children(row.Process);
+		push({children.begin(), children.end()}, row.Depth + 1);
+	}
+
+	report.Processes = std::move(processes);
+	return report;
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "NtUtils.hpp"
+
+/**
+ * @brief Which processes a target selects: the matches, the matches with all
+ *        their descendants (--tree), or only the descendants (--children).
+ */
+enum class TargetScope { Self, Tree, Children };
+
+/**
+ * @brief Resource totals of one process, or of a process and its descendants.
+ */
+struct ProcessTotals {
+	SIZE_T Memory = 0;     // Working set, bytes
+	ULONGLONG Threads = 0;
+	ULONGLONG CpuTime = 0; // Kernel + user time, 100ns units
+
+	ProcessTotals &operator+=(const ProcessTotals &other) {
+		Memory += other.Memory;
+		Threads += other.Threads;
+		CpuTime += other.CpuTime;
+		return *this;
+	}
+};
+
+/**
+ * @brief Column the children of each process are ordered by in a tree view.
+ */
+enum class TreeSort { Pid, Memory, Threads, Cpu };
+
+/**
+ * @brief Hierarchy of one snapshot, ready to print.
+ */
+struct ProcessTreeReport {
+	struct Row {
+		uint32_t Process; // Index into Processes and Totals
+		uint32_t Depth;   // 0 for the top-level processes
+		bool LastChild;   // No sibling follows; decides the guide lines drawn
+	};
+
+	std::vector<ProcessInfo> Processes;
+	std::vector<ProcessTotals> Totals; // Per process: itself and all descendants
+	std::vector<Row> Rows;             // Preorder, parents before their children
+};
+
+/**
+ * @brief Parent -> children index over one process snapshot, stored as a flat
+ *        CSR array: the children of process i are
+ *        m_children[m_offsets[i] .. m_offsets[i + 1]). Processes are referred
+ *        to by their index in the snapshot.
+ *
+ *        A parent link is kept only when the parent was created before the
+ *        child. A child outliving its parent keeps the stale parent PID, so
+ *        without this check a process that later reused that PID would adopt
+ *        children it never started. Creation times tick coarsely, so a pair
+ *        created in the same tick could still point at each other; such loops
+ *        are cut, leaving every process under exactly one root.
+ */
+class ProcessTree {
+public:
+	static constexpr uint32_t NoParent = UINT32_MAX;
+
+	explicit ProcessTree(std::span<const ProcessInfo> processes);
+
+	size_t Size() const { return m_parents.size(); }
+
+	uint32_t Parent(uint32_t index) const { return m_parents[index]; }
+
+	std::span<const uint32_t> Children(uint32_t index) const {
+		const uint32_t *first = m_children.data();
+		return {first + m_offsets[index], first + m_offsets[index + 1]};
+	}
+
+	/**
+	 * @brief Processes without a live parent, in snapshot order.
+	 */
+	std::vector<uint32_t> Roots() const;
+
+	/**
+	 * @brief The subtrees under the given processes in preorder (every parent
+	 *        before its children), each process once. The given processes are
+	 *        included unless includeRoots is false, in which case one of them is
+	 *        still listed when it descends from another.
+	 */
+	std::vector<uint32_t>
+	Subtrees(std::span<const uint32_t> roots, bool includeRoots) const;
+
+	/**
+	 * @brief Totals of every process together with its descendants, summed bottom-up
+	 *        in one pass over the reversed preorder.
+	 */
+	std::vector<ProcessTotals> Rollup(std::span<const ProcessInfo> processes) const;
+
+	/**
+	 * @brief Rows for the subtrees under the given processes (every process when
+	 *        roots is empty), siblings ordered by the sort column, largest first.
+	 *        The walk is iterative, so no tree depth can overflow the stack.
+	 */
+	static ProcessTreeReport BuildReport(
+		std::vector<ProcessInfo> processes, std::span<const uint32_t> roots, TreeSort sort
+	);
+
+private:
+	// The given processes that have no other given process above them.
+	std::vector<uint32_t> Topmost(std::span<const uint32_t> roots) const;
+
+	std::vector<uint32_t> m_parents;
+	std::vector<uint32_t> m_offsets;
+	std::vector<uint32_t> m_children;
+};
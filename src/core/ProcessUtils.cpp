@@ -3,11 +3,17 @@
 #include <format>
 #include <algorithm>
 #include <cwctype>
-#include <DbgHelp.h>
+#include <map>
+#include <mutex>
+#include <regex>
 
 #pragma comment(lib, "version.lib")
 
 #include "WinError.hpp"
+#include "HandleCache.hpp"
+#include "ModuleMap.hpp"
+#include "TargetMatcher.hpp"
+#include "utils/DfaRegex.hpp"
 #include "utils/ScopeExit.hpp"
 #include "utils/StringUtils.hpp"
 
@@ -50,188 +56,250 @@ ResultVoid ProcessUtils::EnableDebugPrivilege(HANDLE hProcess) {
 	return std::monostate{};
 }
 
-// Format a thread or function address into a readable string (e.g. module!function).
-static inline std::string FormatAddress(HANDLE hProcess, PVOID address) {
-	if (!address) return "";
-
-	DWORD64 addr64 = reinterpret_cast<DWORD64>(address);
-	char buffer[sizeof(SYMBOL_INFO) + MAX_SYM_NAME * sizeof(CHAR)];
-	PSYMBOL_INFO pSymbol = reinterpret_cast<PSYMBOL_INFO>(buffer);
-	pSymbol->SizeOfStruct = sizeof(SYMBOL_INFO);
-	pSymbol->MaxNameLen = MAX_SYM_NAME;
-
-	DWORD64 displacement = 0;
-
-	IMAGEHLP_MODULE64 moduleInfo{};
-	moduleInfo.SizeOfStruct = sizeof(IMAGEHLP_MODULE64);
-	std::string baseName = "Unknown";
-	bool hasModule = SymGetModuleInfo64(hProcess, addr64, &moduleInfo);
-
-	if (hasModule) {
-		std::string imageName = moduleInfo.ImageName;
-		size_t slashPos = imageName.find_last_of("\\/");
-		if (slashPos != std::string::npos) {
-			baseName = imageName.substr(slashPos + 1);
-		} else {
-			baseName = imageName;
-		}
+ThreadNameInfo::ThreadNameInfo(
+	const ThreadInfo &info, std::shared_ptr<ThreadSource> source
+)
+	: info(info), m_source(std::move(source)) {}
+
+const std::string &ThreadNameInfo::Name() const {
+	if (!m_name) {
+		m_name = m_source ? m_source->QueryName(info.Tid).value_or("") : "";
 	}
+	return m_name.value();
+}
 
-	if (SymFromAddr(hProcess, addr64, &displacement, pSymbol)) {
-		if (hasModule) {
-			if (displacement > 0) {
-				return std::format("{}!{}+0x{:x}", baseName, pSymbol->Name, displacement);
-			} else {
-				return std::format("{}!{}", baseName, pSymbol->Name);
-			}
-		} else {
-			if (displacement > 0) {
-				return std::format("{}+0x{:x}", pSymbol->Name, displacement);
-			} else {
-				return std::format("{}", pSymbol->Name);
-			}
-		}
-	} else {
-		if (hasModule) {
-			return std::format("{}+0x{:x}", baseName, addr64 - moduleInfo.BaseOfImage);
-		} else {
-			return std::format("0x{:x}", addr64);
-		}
+PVOID ThreadAddrInfo::Address() const {
+	if (!m_address) {
+		m_address = m_source ? m_source->QueryStartAddress(info)
+							 : ProcessUtils::BestStartAddress(info);
 	}
+	return m_address.value();
 }
 
-typedef HRESULT(WINAPI *GetThreadDescription_t)(
-	HANDLE hThread, PWSTR *ppszThreadDescription
-);
+const std::string &ThreadAddrInfo::StartAddress() const {
+	if (!m_startAddress) {
+		m_startAddress = m_source ? m_source->Symbolize(Address()) : "";
+	}
+	return m_startAddress.value();
+}
 
-static Result<std::string, Error> GetThreadName(DWORD tid) {
-	static auto pGetThreadDescription = reinterpret_cast<GetThreadDescription_t>(
-		GetProcAddress(GetModuleHandleW(L"kernelbase.dll"), "GetThreadDescription")
-	);
+void ThreadAddrInfo::SetStartAddress(std::string startAddress) {
+	m_startAddress = std::move(startAddress);
+}
 
-	if (!pGetThreadDescription) {
-		pGetThreadDescription = reinterpret_cast<GetThreadDescription_t>(
-			GetProcAddress(GetModuleHandleW(L"kernel32.dll"), "GetThreadDescription")
-		);
-	}
+// Rights every thread query here needs; requested once per thread.
+static constexpr DWORD kThreadQueryAccess =
+	THREAD_QUERY_INFORMATION | THREAD_QUERY_LIMITED_INFORMATION;
 
-	if (!pGetThreadDescription) {
-		return Error(
-			"GetThreadDescription symbol not found in kernelbase.dll or "
-			"kernel32.dll"
-		);
-	}
+Result<std::vector<ThreadNameInfo>, Error> ProcessUtils::GetThreadNames(DWORD pid) {
+	return GetThreadNames(pid, std::make_shared<ThreadHandles>(kThreadQueryAccess));
+}
 
-	HANDLE hThread = OpenThread(THREAD_QUERY_LIMITED_INFORMATION, FALSE, tid);
-	if (!hThread) {
-		return WinErr(GetLastError(), std::format("OpenThread failed for TID {}", tid));
+Result<std::vector<ThreadNameInfo>, Error>
+ProcessUtils::GetThreadNames(DWORD pid, const std::shared_ptr<ThreadHandles> &handles) {
+	auto threadsResult = NtUtils::GetProcessThreads(pid, nullptr);
+	if (!threadsResult.has_value()) {
+		return threadsResult.error();
 	}
 
-	SCOPE_EXIT(CloseHandle(hThread));
-
-	PWSTR pszDesc = nullptr;
-	HRESULT hr = pGetThreadDescription(hThread, &pszDesc);
-	std::string name = "";
-	if (SUCCEEDED(hr)) {
-		if (pszDesc) {
-			name = StringUtils::WstrToString(pszDesc);
-			LocalFree(pszDesc);
-		}
-	} else {
-		return WinErr(hr, std::format("GetThreadDescription failed for TID {}", tid));
+	auto source = std::make_shared<ThreadSource>(pid, handles);
+	std::vector<ThreadNameInfo> nameInfoList;
+	nameInfoList.reserve(threadsResult.value().size());
+	for (const auto &t : threadsResult.value()) {
+		nameInfoList.emplace_back(t, source);
 	}
-	return name;
+
+	return nameInfoList;
 }
 
-Result<std::vector<ThreadNameInfo>, Error> ProcessUtils::GetThreadNames(DWORD pid) {
-	std::vector<ThreadNameInfo> nameInfoList;
-	auto threadsResult = NtUtils::GetProcessThreads(pid);
+Result<std::vector<ThreadAddrInfo>, Error>
+ProcessUtils::GetThreads(DWORD pid, const std::shared_ptr<ThreadHandles> &handles) {
+	auto threadsResult = NtUtils::GetProcessThreads(pid, nullptr);
 	if (!threadsResult.has_value()) {
 		return threadsResult.error();
 	}
 
-	for (const auto thread : threadsResult.value()) {
-		nameInfoList.push_back({thread, GetThreadName(thread.Tid).value_or("")});
+	auto source = std::make_shared<ThreadSource>(pid, handles);
+	std::vector<ThreadAddrInfo> addrInfoList;
+	addrInfoList.reserve(threadsResult.value().size());
+	for (const auto &t : threadsResult.value()) {
+		addrInfoList.emplace_back(t, source);
 	}
 
-	return nameInfoList;
+	return addrInfoList;
 }
 
 Result<std::vector<ThreadAddrInfo>, Error>
 ProcessUtils::GetThreadStartAddresses(DWORD pid) {
-	std::vector<ThreadAddrInfo> addrInfoList;
-	auto threadsResult = NtUtils::GetProcessThreads(pid);
+	return GetThreadStartAddresses(pid, [](PVOID) {
+		return true;
+	});
+}
+
+Result<std::vector<ThreadAddrInfo>, Error> ProcessUtils::GetThreadStartAddresses(
+	DWORD pid, const std::function<bool(PVOID)> &addressFilter
+) {
+	return GetThreadStartAddresses(
+		pid, addressFilter, std::make_shared<ThreadHandles>(kThreadQueryAccess)
+	);
+}
+
+Result<std::vector<ThreadAddrInfo>, Error> ProcessUtils::GetThreadStartAddresses(
+	DWORD pid,
+	const std::function<bool(PVOID)> &addressFilter,
+	const std::shared_ptr<ThreadHandles> &handles
+) {
+	// The filter needs every raw start address up front.
+	auto threadsResult = NtUtils::GetProcessThreads(pid, handles.get());
 	if (!threadsResult.has_value()) {
 		return threadsResult.error();
 	}
 
-	HANDLE hProcess =
-		OpenProcess(PROCESS_QUERY_INFORMATION | PROCESS_VM_READ, FALSE, pid);
-	if (hProcess) {
-		SymSetOptions(SYMOPT_UNDNAME | SYMOPT_DEFERRED_LOADS);
-		char symbolPath[MAX_PATH];
-		if (GetEnvironmentVariableA("_NT_SYMBOL_PATH", symbolPath, MAX_PATH) == 0) {
-			SymInitialize(
-				hProcess,
-				"srv*C:\\Symbols*https://msdl.microsoft.com/download/symbols",
-				TRUE
-			);
-		} else {
-			SymInitialize(hProcess, NULL, TRUE);
-		}
+	auto source = std::make_shared<ThreadSource>(pid, handles);
+	std::vector<ThreadAddrInfo> addrInfoList;
+	for (const auto &t : threadsResult.value()) {
+		if (addressFilter(BestStartAddress(t))) addrInfoList.emplace_back(t, source);
 	}
 
-	for (const auto t : threadsResult.value()) {
-		PVOID bestAddress = t.Win32StartAddress ? t.Win32StartAddress
-												: t.NativeStartAddress;
-		std::string formattedAddr = FormatAddress(hProcess, bestAddress);
+	PrefetchNames(addrInfoList);
+	return addrInfoList;
+}
+
+void ProcessUtils::FormatModuleAddresses(
+	DWORD pid, std::vector<ThreadAddrInfo> &threads
+) {
+	auto modules = ModuleMap::ForProcess(pid).value_or(std::make_shared<const ModuleMap>());
+
+	for (auto &t : threads) {
+		const auto address = reinterpret_cast<ULONG_PTR>(t.Address());
+		t.SetStartAddress(modules->FormatAddress(address));
+	}
+}
+
+Result<std::wstring, Error>
+ProcessUtils::GetProcessCommandLine(DWORD pid, ULONGLONG createTime) {
+	static std::mutex mutex;
+	static std::map<std::pair<DWORD, ULONGLONG>, std::wstring> cache;
 
-		std::string threadName = GetThreadName(t.Tid).value_or("");
-		addrInfoList.push_back({t, threadName, formattedAddr});
+	{
+		std::lock_guard lock(mutex);
+		auto it = cache.find({pid, createTime});
+		if (it != cache.end()) return it->second;
 	}
 
-	if (hProcess) {
-		SymCleanup(hProcess);
-		CloseHandle(hProcess);
+	auto hProcess = HandleCache::Shared().Process(pid, PROCESS_QUERY_LIMITED_INFORMATION);
+	if (!hProcess) return hProcess.error();
+
+	// The PID may have been reused since the caller's snapshot.
+	const ULONGLONG openedCreateTime = HandleCache::Shared().ProcessCreateTime(pid);
+	if (openedCreateTime != 0 && openedCreateTime != createTime) {
+		return Error(std::format("Process with PID {} has exited", pid));
 	}
 
-	return addrInfoList;
+	auto commandLine = NtUtils::GetProcessCommandLine(hProcess.value().get());
+	if (!commandLine) return commandLine.error();
+
+	std::lock_guard lock(mutex);
+	// Drop command lines of earlier processes that held the same PID.
+	std::erase_if(cache, [pid, createTime](const auto &item) {
+		return item.first.first == pid && item.first.second != createTime;
+	});
+	cache[{pid, createTime}] = commandLine.value();
+	return commandLine;
 }
 
-Result<std::vector<ProcessInfo>, Error>
-ProcessUtils::GetTargetProcesses(std::string_view target) {
-	if (target.empty()) {
-		return Error("Process name or PID cannot be empty.");
+// Keeps the candidates whose command line matches the pattern. Each candidate is
+// opened once, all of them in parallel; the pattern is compiled once and shared,
+// and matching runs in the same parallel pass since searches don't block each
+// other. Command lines that can't be read (e.g. protected processes) never match.
+static Result<std::vector<uint32_t>, Error> FilterByCommandLine(
+	const std::vector<ProcessInfo> &processes,
+	const std::vector<uint32_t> &candidates,
+	const std::string &pattern,
+	size_t &unreadable
+) {
+	auto dfa = DfaRegex::Compile(pattern, true);
+	std::optional<std::regex> regex;
+	if (!dfa) {
+		try {
+			regex = std::regex(pattern, std::regex_constants::icase);
+		} catch (const std::regex_error &) {
+			return Error(std::format("Invalid regex pattern: {}", pattern));
+		}
 	}
 
-	auto targetPidOpt = StringUtils::TryParseInt(target);
+	enum Outcome : uint8_t { Rejected, Matched, Unreadable };
+	std::vector<Outcome> outcomes(candidates.size(), Rejected);
+
+	ThreadPool::Shared().ParallelFor(candidates.size(), [&](size_t i) {
+		const ProcessInfo &proc = processes[candidates[i]];
+		auto commandLine = ProcessUtils::GetProcessCommandLine(proc.Pid, proc.CreateTime);
+		if (!commandLine) {
+			outcomes[i] = Unreadable;
+			return;
+		}
+		const std::string text = StringUtils::WstrToString(commandLine.value());
+		const bool match = dfa ? dfa->Search(text) : std::regex_search(text, *regex);
+		outcomes[i] = match ? Matched : Rejected;
+	});
+
+	std::vector<uint32_t> kept;
+	for (size_t i = 0; i < candidates.size(); ++i) {
+		if (outcomes[i] == Matched) kept.push_back(candidates[i]);
+		if (outcomes[i] == Unreadable) ++unreadable;
+	}
+	return kept;
+}
+
+Result<std::vector<ProcessInfo>, Error>
+ProcessUtils::GetTargetProcesses(std::string_view target, const TargetOptions &options) {
+	auto matcherResult = TargetMatcher::Compile(target);
+	if (!matcherResult) return matcherResult.error();
+	const TargetMatcher &matcher = matcherResult.value();
 
 	auto listResult = NtUtils::GetProcessList();
 	if (!listResult) return listResult;
+	auto &processes = listResult.value();
 
-	std::vector<ProcessInfo> targets;
-	std::wstring procName;
-	if (!targetPidOpt) {
-		procName = std::wstring(target.begin(), target.end());
-		std::transform(procName.begin(), procName.end(), procName.begin(), ::towlower);
-	}
-
-	for (const auto &proc : listResult.value()) {
-		if (targetPidOpt) {
-			if (proc.Pid == static_cast<DWORD>(targetPidOpt.value())) {
-				targets.push_back(proc);
-			}
-		} else {
-			std::wstring name = proc.Name;
-			std::transform(name.begin(), name.end(), name.begin(), ::towlower);
-			if (name == procName) targets.push_back(proc);
-		}
+	std::vector<uint32_t> matched;
+	for (uint32_t i = 0; i < processes.size(); ++i) {
+		if (matcher.Matches(processes[i].Pid, processes[i].Name)) matched.push_back(i);
 	}
 
-	if (targets.empty()) {
+	if (matched.empty()) {
 		return Error(std::format("Process '{}' not found", target));
 	}
 
+	if (!options.CommandLine.empty()) {
+		size_t unreadable = 0;
+		auto filtered =
+			FilterByCommandLine(processes, matched, options.CommandLine, unreadable);
+		if (!filtered) return filtered.error();
+		matched = std::move(filtered.value());
+
+		if (matched.empty()) {
+			return Error(
+				std::format(
+					"No process '{}' has a command line matching \"{}\" ({} unreadable)",
+					target,
+					options.CommandLine,
+					unreadable
+				)
+			);
+		}
+	}
+
+	if (options.Scope != TargetScope::Self) {
+		const ProcessTree tree(processes);
+		matched = tree.Subtrees(matched, options.Scope == TargetScope::Tree);
+		if (matched.empty()) {
+			return Error(std::format("Process '{}' has no child processes", target));
+		}
+	}
+
+	std::vector<ProcessInfo> targets;
+	targets.reserve(matched.size());
+	for (uint32_t i : matched) targets.push_back(std::move(processes[i]));
 	return targets;
 }
 
@@ -363,87 +431,102 @@ Result<std::wstring, Error> ProcessUtils::GetProcessDescription(DWORD pid) {
 }
 
 Result<std::monostate, Error> ProcessUtils::SuspendThread(DWORD tid) {
-	HANDLE hThread = OpenThread(THREAD_SUSPEND_RESUME, FALSE, tid);
-	if (!hThread) {
-		return WinErr(GetLastError(), std::format("OpenThread failed for TID {}", tid));
-	}
-	DWORD prevCount = ::SuspendThread(hThread);
-	DWORD err = GetLastError();
-	CloseHandle(hThread);
-	if (prevCount == static_cast<DWORD>(-1)) {
-		return WinErr(err, std::format("SuspendThread failed for TID {}", tid));
+	ThreadHandles handles(THREAD_SUSPEND_RESUME);
+	return SuspendThread(handles, tid);
+}
+
+Result<std::monostate, Error>
+ProcessUtils::SuspendThread(ThreadHandles &handles, DWORD tid) {
+	auto hThread = handles.Get(tid, THREAD_SUSPEND_RESUME);
+	if (!hThread) return hThread.error();
+
+	if (::SuspendThread(hThread.value()) == static_cast<DWORD>(-1)) {
+		return WinErr(
+			GetLastError(), std::format("SuspendThread failed for TID {}", tid)
+		);
 	}
 	return std::monostate{};
 }
 
 Result<std::monostate, Error> ProcessUtils::ResumeThread(DWORD tid) {
-	HANDLE hThread = OpenThread(THREAD_SUSPEND_RESUME, FALSE, tid);
-	if (!hThread) {
-		return WinErr(GetLastError(), std::format("OpenThread failed for TID {}", tid));
-	}
-	DWORD prevCount = ::ResumeThread(hThread);
-	DWORD err = GetLastError();
-	CloseHandle(hThread);
-	if (prevCount == static_cast<DWORD>(-1)) {
-		return WinErr(err, std::format("ResumeThread failed for TID {}", tid));
+	ThreadHandles handles(THREAD_SUSPEND_RESUME);
+	return ResumeThread(handles, tid);
+}
+
+Result<std::monostate, Error>
+ProcessUtils::ResumeThread(ThreadHandles &handles, DWORD tid) {
+	auto hThread = handles.Get(tid, THREAD_SUSPEND_RESUME);
+	if (!hThread) return hThread.error();
+
+	if (::ResumeThread(hThread.value()) == static_cast<DWORD>(-1)) {
+		return WinErr(
+			GetLastError(), std::format("ResumeThread failed for TID {}", tid)
+		);
 	}
 	return std::monostate{};
 }
 
 Result<DWORD, Error> ProcessUtils::GetProcessPriority(DWORD pid) {
-	HANDLE hProcess = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pid);
-	if (!hProcess) {
-		return WinErr(GetLastError(), std::format("OpenProcess failed for PID {}", pid));
-	}
-	DWORD priority = GetPriorityClass(hProcess);
-	DWORD err = GetLastError();
-	CloseHandle(hProcess);
+	auto hProcess = HandleCache::Shared().Process(pid, PROCESS_QUERY_LIMITED_INFORMATION);
+	if (!hProcess) return hProcess.error();
+
+	DWORD priority = GetPriorityClass(hProcess.value().get());
 	if (priority == 0) {
-		return WinErr(err, std::format("GetPriorityClass failed for PID {}", pid));
+		return WinErr(
+			GetLastError(), std::format("GetPriorityClass failed for PID {}", pid)
+		);
 	}
 	return priority;
 }
 
 Result<int, Error> ProcessUtils::GetThreadPriorityLevel(DWORD tid) {
-	HANDLE hThread = OpenThread(THREAD_QUERY_LIMITED_INFORMATION, FALSE, tid);
-	if (!hThread) {
-		return WinErr(GetLastError(), std::format("OpenThread failed for TID {}", tid));
-	}
-	int priority = GetThreadPriority(hThread);
-	DWORD err = GetLastError();
-	CloseHandle(hThread);
+	ThreadHandles handles(THREAD_QUERY_LIMITED_INFORMATION);
+	return GetThreadPriorityLevel(handles, tid);
+}
+
+Result<int, Error>
+ProcessUtils::GetThreadPriorityLevel(ThreadHandles &handles, DWORD tid) {
+	auto hThread = handles.Get(tid, THREAD_QUERY_LIMITED_INFORMATION);
+	if (!hThread) return hThread.error();
+
+	int priority = GetThreadPriority(hThread.value());
 	if (priority == THREAD_PRIORITY_ERROR_RETURN) {
-		return WinErr(err, std::format("GetThreadPriority failed for TID {}", tid));
+		return WinErr(
+			GetLastError(), std::format("GetThreadPriority failed for TID {}", tid)
+		);
 	}
 	return priority;
 }
 
 Result<std::monostate, Error>
 ProcessUtils::SetProcessPriority(DWORD pid, DWORD priorityClass) {
-	HANDLE hProcess = OpenProcess(PROCESS_SET_INFORMATION, FALSE, pid);
-	if (!hProcess) {
-		return WinErr(GetLastError(), std::format("OpenProcess failed for PID {}", pid));
-	}
-	BOOL success = SetPriorityClass(hProcess, priorityClass);
-	DWORD err = GetLastError();
-	CloseHandle(hProcess);
-	if (!success) {
-		return WinErr(err, std::format("SetPriorityClass failed for PID {}", pid));
+	auto hProcess = HandleCache::Shared().Process(pid, PROCESS_SET_INFORMATION);
+	if (!hProcess) return hProcess.error();
+
+	if (!SetPriorityClass(hProcess.value().get(), priorityClass)) {
+		return WinErr(
+			GetLastError(), std::format("SetPriorityClass failed for PID {}", pid)
+		);
 	}
 	return std::monostate{};
 }
 
 Result<std::monostate, Error>
 ProcessUtils::SetThreadPriorityLevel(DWORD tid, int priorityLevel) {
-	HANDLE hThread = OpenThread(THREAD_SET_INFORMATION, FALSE, tid);
-	if (!hThread) {
-		return WinErr(GetLastError(), std::format("OpenThread failed for TID {}", tid));
-	}
-	BOOL success = SetThreadPriority(hThread, priorityLevel);
-	DWORD err = GetLastError();
-	CloseHandle(hThread);
-	if (!success) {
-		return WinErr(err, std::format("SetThreadPriority failed for TID {}", tid));
+	ThreadHandles handles(THREAD_SET_INFORMATION);
+	return SetThreadPriorityLevel(handles, tid, priorityLevel);
+}
+
+Result<std::monostate, Error> ProcessUtils::SetThreadPriorityLevel(
+	ThreadHandles &handles, DWORD tid, int priorityLevel
+) {
+	auto hThread = handles.Get(tid, THREAD_SET_LIMITED_INFORMATION);
+	if (!hThread) return hThread.error();
+
+	if (!SetThreadPriority(hThread.value(), priorityLevel)) {
+		return WinErr(
+			GetLastError(), std::format("SetThreadPriority failed for TID {}", tid)
+		);
 	}
 	return std::monostate{};
 }
@@ -1,23 +1,63 @@
 #pragma once
 
+#include <functional>
+#include <memory>
+#include <optional>
 #include <string>
 #include <variant>
 #include <vector>
 #include <Windows.h>
 
 #include "NtUtils.hpp"
-
-// Define a struct to hold thread name info for output
+#include "ProcessTree.hpp"
+#include "ThreadHandles.hpp"
+#include "ThreadSampler.hpp"
+#include "ThreadSource.hpp"
+#include "utils/ThreadPool.hpp"
+
+// Thread with its name column, fetched on first access and memoized.
+// A single object is not thread-safe; distinct objects may be filled concurrently.
 struct ThreadNameInfo {
 	ThreadInfo info;
-	std::string Name;
+
+	ThreadNameInfo() = default;
+	ThreadNameInfo(const ThreadInfo &info, std::shared_ptr<ThreadSource> source);
+
+	const std::string &Name() const;
+
+protected:
+	std::shared_ptr<ThreadSource> m_source;
+
+private:
+	mutable std::optional<std::string> m_name;
 };
 
-// Define a struct to hold thread address info for output
-struct ThreadAddrInfo {
-	ThreadInfo info;
-	std::string Name;
-	std::string StartAddress;
+// Thread with name and start address columns, both fetched on first access.
+// The start address is symbolized unless it was set explicitly beforehand.
+struct ThreadAddrInfo : ThreadNameInfo {
+	using ThreadNameInfo::ThreadNameInfo;
+
+	// CPU usage and context switch rate, when the threads were sampled.
+	std::optional<ThreadActivity> activity;
+
+	/**
+	 * @brief Raw start address (Win32 over native), queried on first access.
+	 */
+	PVOID Address() const;
+
+	const std::string &StartAddress() const;
+	void SetStartAddress(std::string startAddress);
+
+private:
+	mutable std::optional<PVOID> m_address;
+	mutable std::optional<std::string> m_startAddress;
+};
+
+// How a target list selects processes, beyond PIDs and image names.
+struct TargetOptions {
+	TargetScope Scope = TargetScope::Self;
+	// Regex the command line must match, case-insensitively; empty matches any.
+	std::string CommandLine;
 };
 
 namespace ProcessUtils {
@@ -28,19 +68,83 @@ namespace ProcessUtils {
 	ResultVoid EnableDebugPrivilege(HANDLE hProcess);
 
 	/**
-	* @brief Gets names for all threads in a process (lightweight, no symbol resolution).
+	* @brief Gets all threads in a process from the kernel snapshot. Names are
+	*        fetched only when read (see PrefetchNames).
 	*/
 	Result<std::vector<ThreadNameInfo>, Error> GetThreadNames(DWORD pid);
 
+	/**
+	* @brief Same as above, reusing handles from the table.
+	*/
+	Result<std::vector<ThreadNameInfo>, Error>
+	GetThreadNames(DWORD pid, const std::shared_ptr<ThreadHandles> &handles);
+
+	/**
+	 * @brief Gets all threads in a process from the kernel snapshot. Name and start
+	 *        address are fetched only when read; nothing else touches the threads.
+	 */
+	Result<std::vector<ThreadAddrInfo>, Error>
+	GetThreads(DWORD pid, const std::shared_ptr<ThreadHandles> &handles);
+
 	/**
 	 * @brief Gets start addresses for all threads in a process.
+	 *        Names are prefetched; symbols are resolved when read.
 	 */
 	Result<std::vector<ThreadAddrInfo>, Error> GetThreadStartAddresses(DWORD pid);
 
 	/**
-	 * @brief Resolves a process name or PID string to a list of matching processes.
+	 * @brief Gets start addresses for the threads whose raw start address passes the
+	 *        filter. Rejected threads are never named or symbolized.
+	 */
+	Result<std::vector<ThreadAddrInfo>, Error> GetThreadStartAddresses(
+		DWORD pid, const std::function<bool(PVOID)> &addressFilter
+	);
+
+	/**
+	 * @brief Same as above, reusing handles from the table.
+	 */
+	Result<std::vector<ThreadAddrInfo>, Error> GetThreadStartAddresses(
+		DWORD pid,
+		const std::function<bool(PVOID)> &addressFilter,
+		const std::shared_ptr<ThreadHandles> &handles
+	);
+
+	/**
+	 * @brief Sets the start address column to module+offset (no symbol resolution,
+	 *        never blocks on the symbol store).
+	 */
+	void FormatModuleAddresses(DWORD pid, std::vector<ThreadAddrInfo> &threads);
+
+	/**
+	 * @brief Fetches the names of all threads in parallel, ahead of reading them.
+	 */
+	template <typename T> void PrefetchNames(const std::vector<T> &threads) {
+		ThreadPool::Shared().ParallelFor(threads.size(), [&](size_t i) {
+			threads[i].Name();
+		});
+	}
+
+	/**
+	 * @brief Picks the most meaningful start address of a thread (Win32 over native).
+	 */
+	inline PVOID BestStartAddress(const ThreadInfo &t) {
+		return t.Win32StartAddress ? t.Win32StartAddress : t.NativeStartAddress;
+	}
+
+	/**
+	 * @brief Resolves a target list (PIDs, names and name globs, comma-separated)
+	 *        to the matching processes, from a single snapshot. A command line
+	 *        pattern narrows the matches; with a tree scope their descendants are
+	 *        added, parents listed before their children.
+	 */
+	Result<std::vector<ProcessInfo>, Error>
+	GetTargetProcesses(std::string_view target, const TargetOptions &options = {});
+
+	/**
+	 * @brief Gets the command line of a process, cached per (PID, CreateTime) so a
+	 *        reused PID is read afresh.
 	 */
-	Result<std::vector<ProcessInfo>, Error> GetTargetProcesses(std::string_view target);
+	Result<std::wstring, Error> GetProcessCommandLine(DWORD pid, ULONGLONG createTime);
 
 	/**
 	 * @brief Gets the file description for the process from its executable version info.
@@ -57,11 +161,21 @@ namespace ProcessUtils {
 	 */
 	Result<std::monostate, Error> SuspendThread(DWORD tid);
 
+	/**
+	 * @brief Suspend a single thread through the shared handle table.
+	 */
+	Result<std::monostate, Error> SuspendThread(ThreadHandles &handles, DWORD tid);
+
 	/**
 	 * @brief Resume a single thread by its thread ID.
 	 */
 	Result<std::monostate, Error> ResumeThread(DWORD tid);
 
+	/**
+	 * @brief Resume a single thread through the shared handle table.
+	 */
+	Result<std::monostate, Error> ResumeThread(ThreadHandles &handles, DWORD tid);
+
 	/**
 	 * @brief Gets the priority class for the specified process.
 	 */
@@ -72,6 +186,11 @@ namespace ProcessUtils {
 	 */
 	Result<int, Error> GetThreadPriorityLevel(DWORD tid);
 
+	/**
+	 * @brief Gets the priority level for the thread through the shared handle table.
+	 */
+	Result<int, Error> GetThreadPriorityLevel(ThreadHandles &handles, DWORD tid);
+
 	/**
 	 * @brief Sets the priority class for the specified process.
 	 */
@@ -82,4 +201,10 @@ namespace ProcessUtils {
 	 */
 	Result<std::monostate, Error> SetThreadPriorityLevel(DWORD tid, int priorityLevel);
 
+	/**
+	 * @brief Sets the priority level for the thread through the shared handle table.
+	 */
+	Result<std::monostate, Error>
+	SetThreadPriorityLevel(ThreadHandles &handles, DWORD tid, int priorityLevel);
+
 } // namespace ProcessUtils
@@ -0,0 +1,157 @@
+#include "Profiler.hpp"
+
+#include <format>
+#include <algorithm>
+#include <thread>
+#include <unordered_map>
+
+#include "WinError.hpp"
+#include "NtUtils.hpp"
+#include "ProcessUtils.hpp"
+#include "SymbolBatch.hpp"
+#include "Symbols.hpp"
+#include "ThreadHandles.hpp"
+#include "utils/ScopeExit.hpp"
+
+// How often the thread and module lists are refreshed to pick up new ones.
+static constexpr auto kThreadRefresh = std::chrono::seconds(1);
+
+// Suspend the thread, walk its stack and resume it; empty when any step fails.
+static std::vector<PVOID> CaptureStack(
+	ThreadHandles &handles, const Symbols::Session &session, DWORD tid, size_t maxFrames
+) {
+	auto hThread = handles.Get(tid, THREAD_GET_CONTEXT | THREAD_QUERY_INFORMATION);
+	if (!hThread) return {};
+
+	if (!ProcessUtils::SuspendThread(handles, tid)) return {};
+	SCOPE_EXIT(ProcessUtils::ResumeThread(handles, tid));
+
+	// SuspendThread is asynchronous; GetThreadContext waits until the thread
+	// has actually stopped, so the context and the stack are consistent.
+	CONTEXT context{};
+	context.ContextFlags = CONTEXT_FULL;
+	if (!GetThreadContext(hThread.value(), &context)) return {};
+
+	return session.WalkStack(hThread.value(), context, maxFrames);
+}
+
+Result<Profile, Error> Profiler::Run(DWORD pid, const ProfileOptions &options) {
+	using Clock = std::chrono::steady_clock;
+
+	// Suspending our own threads could stop the one holding a lock we need.
+	if (pid == GetCurrentProcessId()) {
+		return Error("Cannot profile the current process");
+	}
+
+	auto threadsResult = NtUtils::GetProcessThreads(pid, nullptr);
+	if (!threadsResult.has_value()) {
+		return threadsResult.error();
+	}
+
+	// Symbol names are resolved in Fold, after sampling; see Purpose::StackWalk.
+	Symbols::Session session(pid, Symbols::Purpose::StackWalk);
+	if (!session.IsValid()) {
+		return WinErr(
+			GetLastError(), std::format("Failed to open PID {} for stack walks", pid)
+		);
+	}
+
+	ThreadHandles handles(
+		THREAD_SUSPEND_RESUME | THREAD_GET_CONTEXT | THREAD_QUERY_INFORMATION
+	);
+	Profile profile{pid};
+	std::vector<StackTrie::Frame> stack;
+
+	const auto period = std::chrono::duration_cast<Clock::duration>(
+		std::chrono::duration<double>(1.0 / options.Hz)
+	);
+	const Clock::time_point start = Clock::now();
+	const Clock::time_point end = start + options.Duration;
+	Clock::time_point nextRefresh = start + kThreadRefresh;
+	Clock::time_point nextRound = start;
+
+	std::vector<ThreadInfo> threads = std::move(threadsResult.value());
+	while (nextRound < end) {
+		std::this_thread::sleep_until(nextRound);
+
+		if (Clock::now() >= nextRefresh) {
+			auto refreshed = NtUtils::GetProcessThreads(pid, nullptr);
+			if (!refreshed.has_value()) break; // The process has exited
+			threads = std::move(refreshed.value());
+			session.RefreshModules(); // Before any thread is suspended again
+			nextRefresh += kThreadRefresh;
+		}
+
+		for (const auto &t : threads) {
+			const auto frames = CaptureStack(handles, session, t.Tid, options.MaxFrames);
+			if (frames.empty()) {
+				++profile.Failures;
+				continue;
+			}
+
+			// Callers are recorded by return address, which may already belong to
+			// the next function; one byte back lands inside the call instruction.
+			stack.clear();
+			for (size_t i = frames.size(); i-- > 0;) {
+				const auto pc = reinterpret_cast<StackTrie::Frame>(frames[i]);
+				stack.push_back(i == 0 ? pc : pc - 1);
+			}
+			profile.Stacks.Add(stack);
+		}
+		++profile.Rounds;
+
+		// Skip rounds that are already late instead of sampling in a burst.
+		nextRound += period;
+		const Clock::time_point now = Clock::now();
+		if (nextRound < now) {
+			nextRound += ((now - nextRound) / period + 1) * period;
+		}
+	}
+
+	profile.Elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+		(std::min)(Clock::now(), end) - start
+	);
+	return profile;
+}
+
+// module!function+0xoff -> module!function; unresolved module+0xoff is kept as
+// is, since the offset is all that tells those frames apart.
+static std::string FunctionName(std::string name) {
+	if (name.find('!') != std::string::npos) {
+		const size_t offset = name.rfind("+0x");
+		if (offset != std::string::npos) name.erase(offset);
+	}
+	// ';' separates frames in the folded format.
+	std::replace(name.begin(), name.end(), ';', ':');
+	return name;
+}
+
+std::string
+Profiler::Fold(const Profile &profile, size_t symbolWorkers, size_t &symbolLookups) {
+	const auto frames = profile.Stacks.Frames();
+
+	SymbolBatch batch(symbolWorkers);
+	std::vector<size_t> slots;
+	slots.reserve(frames.size());
+	for (StackTrie::Frame frame : frames) {
+		slots.push_back(batch.Add(profile.Pid, reinterpret_cast<PVOID>(frame)));
+	}
+	batch.Resolve();
+	symbolLookups = batch.LookupCount();
+
+	// The trie holds program counters, so samples at different points of the same
+	// function are separate stacks. Give every function an id and merge by it.
+	std::vector<std::string> names;
+	std::unordered_map<std::string, StackTrie::Frame> ids;
+	std::unordered_map<StackTrie::Frame, StackTrie::Frame> functions;
+	for (size_t i = 0; i < frames.size(); ++i) {
+		auto [it, inserted] =
+			ids.try_emplace(FunctionName(batch.Get(slots[i])), names.size());
+		if (inserted) names.push_back(it->first);
+		functions.emplace(frames[i], it->second);
+	}
+
+	const StackTrie byFunction =
+		profile.Stacks.Map([&](StackTrie::Frame frame) { return functions.at(frame); });
+	return byFunction.Fold([&](StackTrie::Frame id) { return names[id]; });
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <Windows.h>
+
+#include "Result.hpp"
+#include "Error.hpp"
+#include "utils/StackTrie.hpp"
+
+struct ProfileOptions {
+	std::chrono::milliseconds Duration;
+	unsigned Hz;             // Sampling rounds per second, each round visits every thread
+	size_t MaxFrames = 128;
+};
+
+struct Profile {
+	DWORD Pid;
+	StackTrie Stacks;            // Program counters, outermost caller first
+	size_t Rounds = 0;           // Sampling rounds completed
+	size_t Failures = 0;         // Thread visits that produced no stack
+	std::chrono::milliseconds Elapsed{0};
+};
+
+namespace Profiler {
+
+	/**
+	 * @brief Sample the stacks of every thread of a process at a fixed rate.
+	 *        Each thread is suspended only while its context is captured and its
+	 *        stack walked, then resumed. Ends early if the process exits.
+	 */
+	Result<Profile, Error> Run(DWORD pid, const ProfileOptions &options);
+
+	/**
+	 * @brief Symbolize the profile and render it as folded stacks, one line per
+	 *        distinct stack. Frames are merged by function, offsets are dropped.
+	 * @param symbolWorkers Number of --symbol-worker processes to use (0 = in-process).
+	 * @param symbolLookups Receives the number of addresses that went through dbghelp.
+	 */
+	std::string Fold(const Profile &profile, size_t symbolWorkers, size_t &symbolLookups);
+
+} // namespace Profiler
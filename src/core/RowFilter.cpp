@@ -0,0 +1,177 @@
+#include "RowFilter.hpp"
+
+#include <array>
+#include <iterator>
+#include <optional>
+#include <string>
+
+#include "Convert.hpp"
+#include "utils/StringUtils.hpp"
+
+namespace {
+	enum ProcessColumn : size_t {
+		PName, PPid, PParent, PSession, PPrio, PMem, PSuspended, PDesc
+	};
+
+	constexpr FilterColumn kProcessColumns[] = {
+		{"name", false, true, true},
+		{"pid", true, false},
+		{"ppid", true, false},
+		{"session", true, true},
+		{"prio", true, true},
+		{"mem", true, false},
+		{"suspended", true, false},
+		{"desc", false, true},
+	};
+
+	enum ThreadColumn : size_t {
+		TTid, TPrio, TState, TReason, TName, TStart, TCpu, TCsw
+	};
+
+	constexpr FilterColumn kThreadColumns[] = {
+		{"tid", true, false},
+		{"prio", true, true},
+		{"state", true, true},
+		{"reason", true, true},
+		{"name", false, true},
+		{"start", false, true},
+		{"cpu", true, false},
+		{"csw", true, false},
+	};
+
+	// Text columns are converted on first use and kept for the rest of the row.
+	template <size_t N> class LazyRow : public FilterRow {
+	protected:
+		template <typename F> std::string_view Cached(size_t column, F compute) {
+			auto &slot = m_text[column];
+			if (!slot) slot = compute();
+			return slot.value();
+		}
+
+	private:
+		std::array<std::optional<std::string>, N> m_text;
+	};
+
+	class ProcessRow : public LazyRow<std::size(kProcessColumns)> {
+	public:
+		explicit ProcessRow(const ProcessInfo &proc) : m_proc(proc) {}
+
+		double Number(size_t column) override {
+			switch (column) {
+			case PPid: return m_proc.Pid;
+			case PParent: return m_proc.ParentPid;
+			case PSession: return m_proc.SessionId;
+			case PPrio: return m_proc.BasePriority;
+			case PMem: return static_cast<double>(m_proc.Memory);
+			case PSuspended: return m_proc.Suspended ? 1 : 0;
+			default: return 0;
+			}
+		}
+
+		std::string_view Text(size_t column) override {
+			if (column == PPrio) return Convert::ProcessPriorityToString(m_proc.BasePriority);
+
+			return Cached(column, [&]() -> std::string {
+				switch (column) {
+				case PName: // Only for ~; == and != go through WideText
+					return StringUtils::WstrToString(m_proc.Name);
+				case PSession: {
+					const auto session = Convert::SessionIdToString(m_proc.SessionId);
+					return StringUtils::WstrToString(session);
+				}
+				case PDesc:
+					return StringUtils::WstrToString(
+						ProcessUtils::GetProcessDescription(m_proc.Pid).value_or(L"")
+					);
+				default:
+					return {};
+				}
+			});
+		}
+
+		std::wstring_view WideText(size_t column) override {
+			return column == PName ? std::wstring_view(m_proc.Name) : std::wstring_view();
+		}
+
+	private:
+		const ProcessInfo &m_proc;
+	};
+
+	class ThreadRow : public FilterRow {
+	public:
+		explicit ThreadRow(const ThreadAddrInfo &thread) : m_thread(thread) {}
+
+		double Number(size_t column) override {
+			const ThreadInfo &info = m_thread.info;
+			const auto &activity = m_thread.activity;
+			switch (column) {
+			case TTid: return info.Tid;
+			case TPrio: return info.BasePriority;
+			case TState: return info.ThreadState;
+			case TReason: return info.WaitReason;
+			case TCpu: return activity ? activity->CpuPercent : 0;
+			case TCsw: return activity ? activity->ContextSwitchesPerSec : 0;
+			default: return 0;
+			}
+		}
+
+		// Every thread column is either memoized by ThreadAddrInfo or a constant
+		// table entry, so nothing needs caching here.
+		std::string_view Text(size_t column) override {
+			const ThreadInfo &info = m_thread.info;
+			switch (column) {
+			case TName: return m_thread.Name();
+			case TStart: return m_thread.StartAddress();
+			case TPrio: return Convert::ThreadPriorityToString(info.BasePriority);
+			case TState: return Convert::ThreadStateToString(info.ThreadState);
+			case TReason:
+				// Same as the table: only waiting threads have a wait reason.
+				if (info.ThreadState != 5) return {};
+				return Convert::WaitReasonToString(info.WaitReason);
+			default: return {};
+			}
+		}
+
+	private:
+		const ThreadAddrInfo &m_thread;
+	};
+} // namespace
+
+ProcessFilter::ProcessFilter(FilterProgram program) : m_program(std::move(program)) {}
+
+Result<ProcessFilter, Error> ProcessFilter::Compile(std::string_view expr) {
+	auto programResult = FilterProgram::Compile(expr, kProcessColumns);
+	if (!programResult) return programResult.error();
+	return ProcessFilter(std::move(programResult.value()));
+}
+
+bool ProcessFilter::Matches(const ProcessInfo &proc) const {
+	ProcessRow row(proc);
+	return m_program.Evaluate(row);
+}
+
+ThreadFilter::ThreadFilter(FilterProgram program) : m_program(std::move(program)) {}
+
+Result<ThreadFilter, Error> ThreadFilter::Compile(std::string_view expr, bool sampled) {
+	auto programResult = FilterProgram::Compile(expr, kThreadColumns);
+	if (!programResult) return programResult.error();
+
+	const FilterProgram &program = programResult.value();
+	if (!sampled && (program.References(TCpu) || program.References(TCsw))) {
+		return Error("Filtering on cpu or csw requires --sample");
+	}
+	return ThreadFilter(std::move(programResult.value()));
+}
+
+bool ThreadFilter::Matches(const ThreadAddrInfo &thread) const {
+	ThreadRow row(thread);
+	return m_program.Evaluate(row);
+}
+
+bool ThreadFilter::UsesName() const {
+	return m_program.References(TName);
+}
+
+bool ThreadFilter::UsesStart() const {
+	return m_program.References(TStart);
+}
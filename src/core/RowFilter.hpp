@@ -0,0 +1,58 @@
+#pragma once
+
+#include <string_view>
+
+#include "Result.hpp"
+#include "Error.hpp"
+#include "NtUtils.hpp"
+#include "ProcessUtils.hpp"
+#include "utils/FilterExpr.hpp"
+
+/**
+ * @brief --where filter over the process list.
+ *        Columns: name, pid, ppid, session, prio, mem, suspended, desc.
+ *        session and prio also compare by name ("services", "high"); the
+ *        session name and the description are only queried for rows whose
+ *        evaluation reaches them.
+ */
+class ProcessFilter {
+public:
+	static Result<ProcessFilter, Error> Compile(std::string_view expr);
+
+	bool Matches(const ProcessInfo &proc) const;
+
+private:
+	explicit ProcessFilter(FilterProgram program);
+
+	FilterProgram m_program;
+};
+
+/**
+ * @brief --where filter over thread tables.
+ *        Columns: tid, prio, state, reason, name, start, cpu, csw.
+ *        prio, state and reason also compare by name ("waiting", "WrQueue");
+ *        reason has no name unless the thread is waiting. cpu and csw need
+ *        sampled threads.
+ */
+class ThreadFilter {
+public:
+	static Result<ThreadFilter, Error> Compile(std::string_view expr, bool sampled);
+
+	bool Matches(const ThreadAddrInfo &thread) const;
+
+	/**
+	 * @brief True when the filter reads thread names, which are worth prefetching.
+	 */
+	bool UsesName() const;
+
+	/**
+	 * @brief True when the filter reads start addresses, which symbolizes every
+	 *        thread it is evaluated on.
+	 */
+	bool UsesStart() const;
+
+private:
+	explicit ThreadFilter(FilterProgram program);
+
+	FilterProgram m_program;
+};
@@ -0,0 +1,103 @@
+#include "SymbolBatch.hpp"
+
+#include <format>
+#include <algorithm>
+#include <cwctype>
+
+#include "SymbolCache.hpp"
+#include "SymbolWorker.hpp"
+
+SymbolBatch::SymbolBatch(size_t workers) : m_workers(workers) {}
+
+const ModuleMap &SymbolBatch::ModulesOf(DWORD pid) {
+	auto it = m_modules.find(pid);
+	if (it == m_modules.end()) {
+		auto modules =
+			ModuleMap::ForProcess(pid).value_or(std::make_shared<const ModuleMap>());
+		it = m_modules.emplace(pid, std::move(modules)).first;
+	}
+	return *it->second;
+}
+
+size_t SymbolBatch::Add(DWORD pid, PVOID address) {
+	const size_t slot = m_slots.size();
+	m_slots.emplace_back();
+	if (!address) return slot;
+
+	const ULONG_PTR addr = reinterpret_cast<ULONG_PTR>(address);
+	const ModuleEntry *module = ModulesOf(pid).Find(addr);
+	if (!module) {
+		m_slots[slot] = std::format("0x{:x}", addr);
+		return slot;
+	}
+
+	const ULONG_PTR rva = addr - module->Base;
+	if (auto cached = SymbolCache::Shared().Find(module->Path, rva)) {
+		m_slots[slot] = std::move(cached.value());
+		return slot;
+	}
+
+	std::wstring path = module->Path;
+	std::transform(path.begin(), path.end(), path.begin(), ::towlower);
+
+	auto [it, inserted] = m_pendingIndex.try_emplace({path, rva}, m_pending.size());
+	if (inserted) {
+		m_pending.push_back(
+			{module->Path, rva, std::format("{}+0x{:x}", module->Name, rva), {}}
+		);
+		// The first process seen with this module offset resolves it for everyone.
+		m_requests[pid].push_back({address, it->second});
+	}
+	m_pending[it->second].Slots.push_back(slot);
+	return slot;
+}
+
+void SymbolBatch::Resolve() {
+	std::vector<Symbols::ResolveRequest> requests;
+	std::vector<const std::vector<std::pair<PVOID, size_t>> *> owners;
+	for (const auto &[pid, entries] : m_requests) {
+		Symbols::ResolveRequest request{pid, {}};
+		for (const auto &[address, pendingIdx] : entries) {
+			request.Addresses.push_back(address);
+		}
+		requests.push_back(std::move(request));
+		owners.push_back(&entries);
+	}
+
+	std::vector<std::vector<std::string>> symbols(requests.size());
+	if (m_workers > 0) {
+		SymbolWorker::Pool pool(m_workers, SymbolWorker::LaunchProcessWorker);
+		auto results = pool.ResolveAll(requests);
+		for (size_t i = 0; i < results.size(); ++i) {
+			if (results[i].has_value()) symbols[i] = std::move(results[i].value());
+		}
+	} else {
+		for (size_t i = 0; i < requests.size(); ++i) {
+			Symbols::Session session(requests[i].Pid);
+			if (!session.IsValid()) continue;
+			for (PVOID address : requests[i].Addresses) {
+				symbols[i].push_back(session.FormatAddress(address));
+			}
+		}
+	}
+
+	for (size_t i = 0; i < requests.size(); ++i) {
+		const auto &entries = *owners[i];
+		m_lookups += entries.size();
+
+		for (size_t j = 0; j < entries.size(); ++j) {
+			Pending &pending = m_pending[entries[j].second];
+			const bool resolved = j < symbols[i].size() && !symbols[i][j].empty();
+			const std::string &symbol = resolved ? symbols[i][j] : pending.Fallback;
+
+			if (resolved) SymbolCache::Shared().Insert(pending.ModulePath, pending.Rva, symbol);
+			for (size_t slot : pending.Slots) {
+				m_slots[slot] = symbol;
+			}
+		}
+	}
+
+	m_pending.clear();
+	m_pendingIndex.clear();
+	m_requests.clear();
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <Windows.h>
+
+#include "ModuleMap.hpp"
+
+/**
+ * @brief Collects (pid, address) pairs and resolves them in one go through the
+ *        shared SymbolCache. Each distinct module offset is symbolized only once,
+ *        no matter how many threads or processes it appears in.
+ */
+class SymbolBatch {
+public:
+	/**
+	 * @param workers Number of --symbol-worker processes to use (0 = in-process).
+	 */
+	explicit SymbolBatch(size_t workers = 0);
+
+	/**
+	 * @brief Queue an address; returns the slot to read the symbol from after Resolve().
+	 */
+	size_t Add(DWORD pid, PVOID address);
+
+	/**
+	 * @brief Resolve all queued addresses that are not already cached.
+	 */
+	void Resolve();
+
+	const std::string &Get(size_t slot) const { return m_slots[slot]; }
+
+	/**
+	 * @brief Number of distinct addresses that actually went through dbghelp.
+	 */
+	size_t LookupCount() const { return m_lookups; }
+
+private:
+	struct Pending {
+		std::wstring ModulePath;
+		ULONG_PTR Rva;
+		std::string Fallback; // module+0xoff, used if resolution fails
+		std::vector<size_t> Slots;
+	};
+
+	const ModuleMap &ModulesOf(DWORD pid);
+
+	size_t m_workers;
+	size_t m_lookups = 0;
+	std::unordered_map<DWORD, std::shared_ptr<const ModuleMap>> m_modules;
+	std::vector<std::string> m_slots;
+	std::vector<Pending> m_pending;
+	std::map<std::pair<std::wstring, ULONG_PTR>, size_t> m_pendingIndex;
+	// Representative (pid, address) per pending entry, grouped by process.
+	std::map<DWORD, std::vector<std::pair<PVOID, size_t>>> m_requests;
+};
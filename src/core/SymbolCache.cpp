@@ -0,0 +1,44 @@
+#include "SymbolCache.hpp"
+
+#include <algorithm>
+#include <cwctype>
+
+SymbolCache &SymbolCache::Shared() {
+	static SymbolCache instance;
+	return instance;
+}
+
+size_t SymbolCache::KeyHash::operator()(const Key &key) const noexcept {
+	size_t h = std::hash<std::wstring>{}(key.ModulePath);
+	return h ^ (std::hash<ULONG_PTR>{}(key.Rva) + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2));
+}
+
+SymbolCache::Key SymbolCache::MakeKey(const std::wstring &modulePath, ULONG_PTR rva) {
+	Key key{modulePath, rva};
+	std::transform(
+		key.ModulePath.begin(), key.ModulePath.end(), key.ModulePath.begin(), ::towlower
+	);
+	return key;
+}
+
+std::optional<std::string>
+SymbolCache::Find(const std::wstring &modulePath, ULONG_PTR rva) const {
+	const Key key = MakeKey(modulePath, rva);
+
+	std::lock_guard lock(m_mutex);
+	auto it = m_symbols.find(key);
+	if (it == m_symbols.end()) return std::nullopt;
+	return it->second;
+}
+
+void SymbolCache::Insert(const std::wstring &modulePath, ULONG_PTR rva, std::string symbol) {
+	Key key = MakeKey(modulePath, rva);
+
+	std::lock_guard lock(m_mutex);
+	m_symbols.insert_or_assign(std::move(key), std::move(symbol));
+}
+
+size_t SymbolCache::Size() const {
+	std::lock_guard lock(m_mutex);
+	return m_symbols.size();
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <Windows.h>
+
+/**
+ * @brief Process-independent cache of resolved symbols, keyed by module image
+ *        path and offset into the module. The same DLL function started in many
+ *        processes is resolved only once. Thread-safe.
+ */
+class SymbolCache {
+public:
+	static SymbolCache &Shared();
+
+	std::optional<std::string> Find(const std::wstring &modulePath, ULONG_PTR rva) const;
+	void Insert(const std::wstring &modulePath, ULONG_PTR rva, std::string symbol);
+
+	size_t Size() const;
+
+private:
+	struct Key {
+		std::wstring ModulePath; // Lowercased
+		ULONG_PTR Rva;
+
+		bool operator==(const Key &) const = default;
+	};
+
+	struct KeyHash {
+		size_t operator()(const Key &key) const noexcept;
+	};
+
+	static Key MakeKey(const std::wstring &modulePath, ULONG_PTR rva);
+
+	mutable std::mutex m_mutex;
+	std::unordered_map<Key, std::string, KeyHash> m_symbols;
+};
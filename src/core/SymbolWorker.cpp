@@ -0,0 +1,351 @@
+#include "SymbolWorker.hpp"
+
+#include <format>
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <numeric>
+#include <thread>
+
+#if defined(_WIN32)
+#include "WinError.hpp"
+#include "ProcessUtils.hpp"
+#endif
+
+std::string SymbolWorker::EncodeRequest(const Symbols::ResolveRequest &request) {
+	std::string line = std::format("{} {}", request.Pid, request.Addresses.size());
+	for (PVOID address : request.Addresses) {
+		line += std::format(" {:x}", reinterpret_cast<ULONG_PTR>(address));
+	}
+	line += '\n';
+	return line;
+}
+
+static bool NextToken(std::string_view &line, std::string_view &token) {
+	size_t start = line.find_first_not_of(' ');
+	if (start == std::string_view::npos) return false;
+	size_t end = line.find(' ', start);
+	if (end == std::string_view::npos) end = line.size();
+	token = line.substr(start, end - start);
+	line.remove_prefix(end);
+	return true;
+}
+
+template <typename T> static bool ParseToken(std::string_view token, T &out, int base) {
+	auto [ptr, ec] = std::from_chars(token.data(), token.data() + token.size(), out, base);
+	return ec == std::errc{} && ptr == token.data() + token.size();
+}
+
+std::optional<Symbols::ResolveRequest> SymbolWorker::DecodeRequest(std::string_view line) {
+	std::string_view token;
+	Symbols::ResolveRequest request{};
+	size_t count = 0;
+
+	if (!NextToken(line, token) || !ParseToken(token, request.Pid, 10)) {
+		return std::nullopt;
+	}
+	if (!NextToken(line, token) || !ParseToken(token, count, 10)) {
+		return std::nullopt;
+	}
+
+	request.Addresses.reserve(count);
+	for (size_t i = 0; i < count; ++i) {
+		ULONG_PTR address = 0;
+		if (!NextToken(line, token) || !ParseToken(token, address, 16)) {
+			return std::nullopt;
+		}
+		request.Addresses.push_back(reinterpret_cast<PVOID>(address));
+	}
+
+	if (NextToken(line, token)) return std::nullopt; // Trailing garbage
+	return request;
+}
+
+std::string SymbolWorker::EncodeResponse(const std::vector<std::string> &symbols) {
+	std::string block = std::format("{}\n", symbols.size());
+	for (const auto &symbol : symbols) {
+		block += symbol;
+		block += '\n';
+	}
+	return block;
+}
+
+Result<std::vector<std::string>, Error> SymbolWorker::DecodeResponse(
+	const Symbols::ResolveRequest &request,
+	const std::function<bool(std::string &line)> &readLine
+) {
+	std::string line;
+	size_t count = 0;
+	if (!readLine(line) || !ParseToken(line, count, 10)) {
+		return Error(
+			std::format("Symbol worker returned no result for PID {}", request.Pid)
+		);
+	}
+
+	if (count != request.Addresses.size()) {
+		return Error(
+			std::format(
+				"Symbol worker returned {} symbols for {} addresses of PID {}",
+				count,
+				request.Addresses.size(),
+				request.Pid
+			)
+		);
+	}
+
+	std::vector<std::string> symbols(count);
+	for (auto &symbol : symbols) {
+		if (!readLine(symbol)) {
+			return Error(
+				std::format("Symbol worker died while resolving PID {}", request.Pid)
+			);
+		}
+	}
+	return symbols;
+}
+
+#if defined(_WIN32)
+namespace {
+	// Buffered line reader over a pipe HANDLE. Tolerates "\r\n" line endings.
+	class LineReader {
+	public:
+		explicit LineReader(HANDLE hRead) : m_hRead(hRead) {}
+
+		bool ReadLine(std::string &line) {
+			while (true) {
+				size_t pos = m_buffer.find('\n', m_offset);
+				if (pos != std::string::npos) {
+					line.assign(m_buffer, m_offset, pos - m_offset);
+					if (!line.empty() && line.back() == '\r') line.pop_back();
+					m_offset = pos + 1;
+					return true;
+				}
+
+				m_buffer.erase(0, m_offset);
+				m_offset = 0;
+
+				char chunk[64 * 1024];
+				DWORD bytesRead = 0;
+				if (!ReadFile(m_hRead, chunk, sizeof(chunk), &bytesRead, nullptr) ||
+					bytesRead == 0) {
+					return false;
+				}
+				m_buffer.append(chunk, bytesRead);
+			}
+		}
+
+	private:
+		HANDLE m_hRead;
+		std::string m_buffer;
+		size_t m_offset = 0;
+	};
+
+	bool WriteAll(HANDLE hWrite, std::string_view data) {
+		while (!data.empty()) {
+			DWORD written = 0;
+			if (!WriteFile(
+					hWrite, data.data(), static_cast<DWORD>(data.size()), &written, nullptr
+				)) {
+				return false;
+			}
+			data.remove_prefix(written);
+		}
+		return true;
+	}
+
+	class PipeChannel : public SymbolWorker::Channel {
+	public:
+		PipeChannel(HANDLE hProcess, HANDLE hWrite, HANDLE hRead)
+			: m_hProcess(hProcess), m_hWrite(hWrite), m_hRead(hRead), m_reader(hRead) {}
+
+		~PipeChannel() override {
+			CloseHandle(m_hWrite); // EOF on stdin makes the worker exit
+			if (WaitForSingleObject(m_hProcess, 1000) != WAIT_OBJECT_0) {
+				TerminateProcess(m_hProcess, 1);
+			}
+			CloseHandle(m_hRead);
+			CloseHandle(m_hProcess);
+		}
+
+		Result<std::vector<std::string>, Error>
+		Resolve(const Symbols::ResolveRequest &request) override {
+			if (!WriteAll(m_hWrite, SymbolWorker::EncodeRequest(request))) {
+				return WinErr(
+					GetLastError(),
+					std::format("Failed to send batch for PID {} to symbol worker", request.Pid)
+				);
+			}
+
+			return SymbolWorker::DecodeResponse(request, [this](std::string &line) {
+				return m_reader.ReadLine(line);
+			});
+		}
+
+	private:
+		HANDLE m_hProcess;
+		HANDLE m_hWrite;
+		HANDLE m_hRead;
+		LineReader m_reader;
+	};
+} // namespace
+
+Result<std::unique_ptr<SymbolWorker::Channel>, Error> SymbolWorker::LaunchProcessWorker() {
+	wchar_t exePath[MAX_PATH];
+	DWORD len = GetModuleFileNameW(nullptr, exePath, MAX_PATH);
+	if (len == 0 || len == MAX_PATH) {
+		return WinErr(GetLastError(), "Failed to get path of the current executable");
+	}
+
+	SECURITY_ATTRIBUTES sa{sizeof(sa), nullptr, TRUE};
+	HANDLE hChildStdinRead, hChildStdinWrite;
+	HANDLE hChildStdoutRead, hChildStdoutWrite;
+
+	if (!CreatePipe(&hChildStdinRead, &hChildStdinWrite, &sa, 0)) {
+		return WinErr(GetLastError(), "Failed to create symbol worker stdin pipe");
+	}
+	if (!CreatePipe(&hChildStdoutRead, &hChildStdoutWrite, &sa, 0)) {
+		DWORD err = GetLastError();
+		CloseHandle(hChildStdinRead);
+		CloseHandle(hChildStdinWrite);
+		return WinErr(err, "Failed to create symbol worker stdout pipe");
+	}
+
+	// Parent ends must not leak into the child.
+	SetHandleInformation(hChildStdinWrite, HANDLE_FLAG_INHERIT, 0);
+	SetHandleInformation(hChildStdoutRead, HANDLE_FLAG_INHERIT, 0);
+
+	// Workers are launched concurrently, so restrict inheritance to this worker's
+	// pipe ends; otherwise siblings would hold each other's pipes open.
+	HANDLE inherited[] = {hChildStdinRead, hChildStdoutWrite};
+	SIZE_T attrSize = 0;
+	InitializeProcThreadAttributeList(nullptr, 1, 0, &attrSize);
+	std::vector<BYTE> attrBuffer(attrSize);
+	auto attrs = reinterpret_cast<LPPROC_THREAD_ATTRIBUTE_LIST>(attrBuffer.data());
+	InitializeProcThreadAttributeList(attrs, 1, 0, &attrSize);
+	UpdateProcThreadAttribute(
+		attrs,
+		0,
+		PROC_THREAD_ATTRIBUTE_HANDLE_LIST,
+		inherited,
+		sizeof(inherited),
+		nullptr,
+		nullptr
+	);
+
+	STARTUPINFOEXW si{};
+	si.StartupInfo.cb = sizeof(si);
+	si.StartupInfo.dwFlags = STARTF_USESTDHANDLES;
+	si.StartupInfo.hStdInput = hChildStdinRead;
+	si.StartupInfo.hStdOutput = hChildStdoutWrite;
+	si.StartupInfo.hStdError = nullptr;
+	si.lpAttributeList = attrs;
+
+	std::wstring cmdLine = std::format(L"\"{}\" --symbol-worker", exePath);
+	PROCESS_INFORMATION pi{};
+	BOOL created = CreateProcessW(
+		exePath,
+		cmdLine.data(),
+		nullptr,
+		nullptr,
+		TRUE,
+		EXTENDED_STARTUPINFO_PRESENT | CREATE_NO_WINDOW,
+		nullptr,
+		nullptr,
+		&si.StartupInfo,
+		&pi
+	);
+	DWORD err = GetLastError();
+
+	DeleteProcThreadAttributeList(attrs);
+	CloseHandle(hChildStdinRead);
+	CloseHandle(hChildStdoutWrite);
+
+	if (!created) {
+		CloseHandle(hChildStdinWrite);
+		CloseHandle(hChildStdoutRead);
+		return WinErr(err, "Failed to launch symbol worker process");
+	}
+
+	CloseHandle(pi.hThread);
+	return std::unique_ptr<Channel>(
+		std::make_unique<PipeChannel>(pi.hProcess, hChildStdinWrite, hChildStdoutRead)
+	);
+}
+#endif
+
+SymbolWorker::Pool::Pool(size_t workers, ChannelFactory factory)
+	: m_workers((std::max)(workers, size_t{1})), m_factory(std::move(factory)) {}
+
+std::vector<Result<std::vector<std::string>, Error>>
+SymbolWorker::Pool::ResolveAll(const std::vector<Symbols::ResolveRequest> &requests) {
+	std::vector<Result<std::vector<std::string>, Error>> results(
+		requests.size(), Error("Batch was not processed by any symbol worker")
+	);
+
+	// Largest batches first, so a big process doesn't become the straggler.
+	std::vector<size_t> order(requests.size());
+	std::iota(order.begin(), order.end(), size_t{0});
+	std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+		return requests[a].Addresses.size() > requests[b].Addresses.size();
+	});
+
+	std::atomic<size_t> next = 0;
+	auto dispatch = [&]() {
+		auto channelResult = m_factory();
+		if (!channelResult) return;
+		std::unique_ptr<Channel> channel = std::move(channelResult.value());
+
+		for (size_t i = next++; i < order.size(); i = next++) {
+			const size_t idx = order[i];
+			results[idx] = channel->Resolve(requests[idx]);
+
+			// A failed exchange leaves the pipe in an unknown state; start over.
+			if (!results[idx].has_value()) {
+				channelResult = m_factory();
+				if (!channelResult) return;
+				channel = std::move(channelResult.value());
+			}
+		}
+	};
+
+	const size_t threadCount = (std::min)(m_workers, requests.size());
+	std::vector<std::thread> threads;
+	threads.reserve(threadCount);
+	for (size_t i = 0; i < threadCount; ++i) {
+		threads.emplace_back(dispatch);
+	}
+	for (auto &t : threads) {
+		t.join();
+	}
+
+	return results;
+}
+
+#if defined(_WIN32)
+int SymbolWorker::Serve() {
+	ProcessUtils::EnableDebugPrivilege(GetCurrentProcess());
+
+	HANDLE hStdin = GetStdHandle(STD_INPUT_HANDLE);
+	HANDLE hStdout = GetStdHandle(STD_OUTPUT_HANDLE);
+
+	LineReader reader(hStdin);
+	std::string line;
+
+	while (reader.ReadLine(line)) {
+		auto request = DecodeRequest(line);
+		if (!request) return 1;
+
+		std::vector<std::string> symbols;
+		symbols.reserve(request->Addresses.size());
+
+		Symbols::Session session(request->Pid);
+		for (PVOID address : request->Addresses) {
+			symbols.push_back(session.FormatAddress(address));
+		}
+
+		if (!WriteAll(hStdout, EncodeResponse(symbols))) return 1;
+	}
+
+	return 0;
+}
+#endif
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <Windows.h>
+
+#include "Result.hpp"
+#include "Error.hpp"
+#include "Symbols.hpp"
+
+/**
+ * Out-of-process symbolization. dbghelp is single-threaded per process, so
+ * resolution is scaled out by running this executable in the hidden
+ * --symbol-worker mode, one dbghelp instance per worker process.
+ *
+ * Wire protocol (one request at a time per worker, '\n' terminated lines):
+ *   request : "<pid> <count> <hex addr>...<hex addr>"
+ *   response: "<count>" followed by <count> lines, one symbol per address
+ */
+namespace SymbolWorker {
+
+	/**
+	 * @brief Encode a batch as a single request line.
+	 */
+	std::string EncodeRequest(const Symbols::ResolveRequest &request);
+
+	/**
+	 * @brief Decode a request line (without the trailing newline).
+	 */
+	std::optional<Symbols::ResolveRequest> DecodeRequest(std::string_view line);
+
+	/**
+	 * @brief Encode the symbols for a batch as a response block.
+	 */
+	std::string EncodeResponse(const std::vector<std::string> &symbols);
+
+	/**
+	 * @brief Read the response block for a batch, one line per call of readLine
+	 *        (which returns false once the worker's output has ended).
+	 */
+	Result<std::vector<std::string>, Error> DecodeResponse(
+		const Symbols::ResolveRequest &request,
+		const std::function<bool(std::string &line)> &readLine
+	);
+
+	/**
+	 * @brief One connection to a worker. Implementations need not be thread-safe;
+	 *        the pool drives each channel from a single thread.
+	 */
+	class Channel {
+	public:
+		virtual ~Channel() = default;
+		virtual Result<std::vector<std::string>, Error>
+		Resolve(const Symbols::ResolveRequest &request) = 0;
+	};
+
+	using ChannelFactory = std::function<Result<std::unique_ptr<Channel>, Error>()>;
+
+	/**
+	 * @brief Launch this executable in --symbol-worker mode connected over pipes.
+	 */
+	Result<std::unique_ptr<Channel>, Error> LaunchProcessWorker();
+
+	/**
+	 * @brief Fans batches out over a fixed number of channels.
+	 */
+	class Pool {
+	public:
+		Pool(size_t workers, ChannelFactory factory);
+
+		/**
+		 * @brief Resolve all batches; results are returned in request order.
+		 */
+		std::vector<Result<std::vector<std::string>, Error>>
+		ResolveAll(const std::vector<Symbols::ResolveRequest> &requests);
+
+	private:
+		size_t m_workers;
+		ChannelFactory m_factory;
+	};
+
+	/**
+	 * @brief Entry point of the hidden --symbol-worker mode (serves stdin/stdout).
+	 */
+	int Serve();
+
+} // namespace SymbolWorker
@@ -0,0 +1,198 @@
+#include "Symbols.hpp"
+
+#include <format>
+#include <condition_variable>
+#include <mutex>
+#include <atomic>
+#include <DbgHelp.h>
+
+// dbghelp polls this during deferred symbol loads, symbol server downloads
+// included; returning TRUE abandons the load.
+static BOOL CALLBACK
+CancelCallback(HANDLE /*hProcess*/, ULONG action, ULONG64 /*data*/, ULONG64 context) {
+	if (action != CBA_DEFERRED_SYMBOL_LOAD_CANCEL) return FALSE;
+	return reinterpret_cast<const std::atomic<bool> *>(context)->load() ? TRUE : FALSE;
+}
+
+Symbols::Session::Session(DWORD pid, Purpose purpose, const std::atomic<bool> *cancel) {
+	m_modules = ModuleMap::ForProcess(pid).value_or(std::make_shared<const ModuleMap>());
+
+	m_hProcess = OpenProcess(PROCESS_QUERY_INFORMATION | PROCESS_VM_READ, FALSE, pid);
+	if (!m_hProcess) return;
+
+	if (purpose == Purpose::StackWalk) {
+		// Unwinding only needs the images. Without deferred loads SymInitialize
+		// loads every module now; the empty search path and ignoring the PDB path
+		// recorded in the image keep it from looking for symbols anywhere.
+		SymSetOptions(SYMOPT_IGNORE_CVREC | SYMOPT_NO_PROMPTS);
+		SymInitialize(m_hProcess, "", TRUE);
+		return;
+	}
+
+	SymSetOptions(SYMOPT_UNDNAME | SYMOPT_DEFERRED_LOADS);
+	char symbolPath[MAX_PATH];
+	if (GetEnvironmentVariableA("_NT_SYMBOL_PATH", symbolPath, MAX_PATH) == 0) {
+		SymInitialize(
+			m_hProcess, "srv*C:\\Symbols*https://msdl.microsoft.com/download/symbols", TRUE
+		);
+	} else {
+		SymInitialize(m_hProcess, NULL, TRUE);
+	}
+
+	if (cancel) {
+		const auto context = reinterpret_cast<ULONG64>(cancel);
+		SymRegisterCallback64(m_hProcess, CancelCallback, context);
+	}
+}
+
+Symbols::Session::~Session() {
+	if (m_hProcess) {
+		SymCleanup(m_hProcess);
+		CloseHandle(m_hProcess);
+	}
+}
+
+// Format a thread or function address into a readable string (e.g. module!function).
+std::string Symbols::Session::FormatAddress(PVOID address) const {
+	if (!address) return "";
+
+	DWORD64 addr64 = reinterpret_cast<DWORD64>(address);
+	char buffer[sizeof(SYMBOL_INFO) + MAX_SYM_NAME * sizeof(CHAR)];
+	PSYMBOL_INFO pSymbol = reinterpret_cast<PSYMBOL_INFO>(buffer);
+	pSymbol->SizeOfStruct = sizeof(SYMBOL_INFO);
+	pSymbol->MaxNameLen = MAX_SYM_NAME;
+
+	DWORD64 displacement = 0;
+
+	const ModuleEntry *module = m_modules->Find(static_cast<ULONG_PTR>(addr64));
+	bool hasModule = module != nullptr;
+	std::string baseName = hasModule ? module->Name : "Unknown";
+
+	if (SymFromAddr(m_hProcess, addr64, &displacement, pSymbol)) {
+		if (hasModule) {
+			if (displacement > 0) {
+				return std::format("{}!{}+0x{:x}", baseName, pSymbol->Name, displacement);
+			} else {
+				return std::format("{}!{}", baseName, pSymbol->Name);
+			}
+		} else {
+			if (displacement > 0) {
+				return std::format("{}+0x{:x}", pSymbol->Name, displacement);
+			} else {
+				return std::format("{}", pSymbol->Name);
+			}
+		}
+	} else {
+		if (hasModule) {
+			return std::format("{}+0x{:x}", baseName, addr64 - module->Base);
+		} else {
+			return std::format("0x{:x}", addr64);
+		}
+	}
+}
+
+std::vector<PVOID> Symbols::Session::WalkStack(
+	HANDLE hThread, const CONTEXT &context, size_t maxFrames
+) const {
+	std::vector<PVOID> frames;
+	if (!m_hProcess) return frames;
+
+	// StackWalk64 updates the context as it unwinds, so it works on a copy.
+	CONTEXT ctx = context;
+	STACKFRAME64 frame{};
+#if defined(_M_X64)
+	const DWORD machine = IMAGE_FILE_MACHINE_AMD64;
+	frame.AddrPC.Offset = ctx.Rip;
+	frame.AddrFrame.Offset = ctx.Rbp;
+	frame.AddrStack.Offset = ctx.Rsp;
+#elif defined(_M_ARM64)
+	const DWORD machine = IMAGE_FILE_MACHINE_ARM64;
+	frame.AddrPC.Offset = ctx.Pc;
+	frame.AddrFrame.Offset = ctx.Fp;
+	frame.AddrStack.Offset = ctx.Sp;
+#else
+	const DWORD machine = IMAGE_FILE_MACHINE_I386;
+	frame.AddrPC.Offset = ctx.Eip;
+	frame.AddrFrame.Offset = ctx.Ebp;
+	frame.AddrStack.Offset = ctx.Esp;
+#endif
+	frame.AddrPC.Mode = AddrModeFlat;
+	frame.AddrFrame.Mode = AddrModeFlat;
+	frame.AddrStack.Mode = AddrModeFlat;
+
+	while (frames.size() < maxFrames) {
+		if (!StackWalk64(
+				machine, m_hProcess, hThread, &frame, &ctx, nullptr,
+				SymFunctionTableAccess64, SymGetModuleBase64, nullptr
+			)) {
+			break;
+		}
+		if (frame.AddrPC.Offset == 0) break;
+		frames.push_back(reinterpret_cast<PVOID>(frame.AddrPC.Offset));
+	}
+	return frames;
+}
+
+void Symbols::Session::RefreshModules() const {
+	if (m_hProcess) SymRefreshModuleList(m_hProcess);
+}
+
+struct Symbols::AsyncResolver::State {
+	std::vector<ResolveRequest> requests;
+	std::vector<std::vector<std::optional<std::string>>> results;
+	mutable std::mutex mutex;
+	std::condition_variable cv;
+	std::atomic<bool> cancelled = false;
+	size_t completed = 0; // Requests resolved so far, in order
+};
+
+Symbols::AsyncResolver::AsyncResolver(std::vector<ResolveRequest> requests)
+	: m_state(std::make_shared<State>()) {
+	m_state->requests = std::move(requests);
+	for (const auto &req : m_state->requests) {
+		m_state->results.emplace_back(req.Addresses.size());
+	}
+
+	m_worker = std::thread([state = m_state]() {
+		for (size_t i = 0; i < state->requests.size(); ++i) {
+			if (state->cancelled) break;
+
+			const auto &req = state->requests[i];
+			Session session(req.Pid, &state->cancelled);
+			for (size_t j = 0; session.IsValid() && j < req.Addresses.size(); ++j) {
+				if (state->cancelled) break;
+
+				std::string symbol = session.FormatAddress(req.Addresses[j]);
+				std::lock_guard lock(state->mutex);
+				state->results[i][j] = std::move(symbol);
+			}
+			if (state->cancelled) break;
+
+			std::lock_guard lock(state->mutex);
+			state->completed = i + 1;
+			state->cv.notify_all();
+		}
+	});
+}
+
+Symbols::AsyncResolver::~AsyncResolver() {
+	// The session callback makes a lookup blocked on the symbol server give up,
+	// so the join only waits for the lookup in flight to unwind.
+	m_state->cancelled = true;
+	m_worker.join();
+}
+
+bool Symbols::AsyncResolver::WaitFor(
+	size_t request, std::chrono::steady_clock::time_point deadline
+) {
+	std::unique_lock lock(m_state->mutex);
+	return m_state->cv.wait_until(lock, deadline, [this, request]() {
+		return m_state->completed > request;
+	});
+}
+
+std::vector<std::optional<std::string>>
+Symbols::AsyncResolver::Results(size_t request) const {
+	std::lock_guard lock(m_state->mutex);
+	return m_state->results.at(request);
+}
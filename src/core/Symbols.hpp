@@ -0,0 +1,111 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+#include <Windows.h>
+
+#include "ModuleMap.hpp"
+
+namespace Symbols {
+
+	/**
+	 * @brief What a session is used for, which decides how it loads modules.
+	 */
+	enum class Purpose {
+		Names,     // Symbol names: modules load on first use, PDBs may be downloaded
+		StackWalk, // Unwind data only: modules load up front, from local files only
+	};
+
+	/**
+	 * @brief dbghelp symbol session bound to a single process.
+	 *        dbghelp is single-threaded, so a session must only be used from one thread.
+	 */
+	class Session {
+	public:
+		/**
+		 * @param cancel When set, symbol loads in progress (e.g. symbol server
+		 *        downloads) are abandoned as soon as it becomes true.
+		 */
+		explicit Session(DWORD pid, const std::atomic<bool> *cancel = nullptr)
+			: Session(pid, Purpose::Names, cancel) {}
+
+		/**
+		 * @param purpose StackWalk sessions never load a module during WalkStack,
+		 *        where the walked thread is suspended: a symbol server download
+		 *        there could freeze the target for seconds, possibly holding its
+		 *        loader or heap lock. Names are then resolved by a Names session.
+		 */
+		Session(DWORD pid, Purpose purpose, const std::atomic<bool> *cancel = nullptr);
+		~Session();
+
+		Session(const Session &) = delete;
+		Session &operator=(const Session &) = delete;
+
+		bool IsValid() const { return m_hProcess != nullptr; }
+
+		/**
+		 * @brief Format an address as module!symbol+0xoff (falls back to module+0xoff).
+		 *        Module lookup goes through the cached ModuleMap, not dbghelp.
+		 */
+		std::string FormatAddress(PVOID address) const;
+
+		/**
+		 * @brief Walk the stack of a suspended thread of this process, starting from
+		 *        its captured context. Returns program counters, leaf first.
+		 */
+		std::vector<PVOID>
+		WalkStack(HANDLE hThread, const CONTEXT &context, size_t maxFrames) const;
+
+		/**
+		 * @brief Load the modules the process has loaded since the session was
+		 *        created. Call it while none of the threads is suspended.
+		 */
+		void RefreshModules() const;
+
+	private:
+		HANDLE m_hProcess = nullptr;
+		std::shared_ptr<const ModuleMap> m_modules;
+	};
+
+	struct ResolveRequest {
+		DWORD Pid;
+		std::vector<PVOID> Addresses;
+	};
+
+	/**
+	 * @brief Resolves symbols for a set of requests on a background thread, one
+	 *        request after another. Results become visible as they arrive; the
+	 *        caller decides how long to wait. Destruction cancels the lookups and
+	 *        waits for the thread, so dbghelp is never left running behind it.
+	 */
+	class AsyncResolver {
+	public:
+		explicit AsyncResolver(std::vector<ResolveRequest> requests);
+		~AsyncResolver();
+
+		AsyncResolver(const AsyncResolver &) = delete;
+		AsyncResolver &operator=(const AsyncResolver &) = delete;
+
+		/**
+		 * @brief Wait until the request is resolved or the deadline passes.
+		 * @return true if every address of the request was resolved in time.
+		 */
+		bool WaitFor(size_t request, std::chrono::steady_clock::time_point deadline);
+
+		/**
+		 * @brief Snapshot of the resolved symbols for a request (nullopt = still pending).
+		 */
+		std::vector<std::optional<std::string>> Results(size_t request) const;
+
+	private:
+		struct State;
+		std::shared_ptr<State> m_state;
+		std::thread m_worker;
+	};
+
+} // namespace Symbols
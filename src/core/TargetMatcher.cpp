@@ -0,0 +1,81 @@
+#include "TargetMatcher.hpp"
+
+#include <format>
+#include <algorithm>
+
+#include "utils/CaseFold.hpp"
+#include "utils/StringUtils.hpp"
+
+Result<TargetMatcher, Error> TargetMatcher::Compile(std::string_view targets) {
+	if (targets.empty()) {
+		return Error("Process name or PID cannot be empty.");
+	}
+
+	TargetMatcher matcher;
+	size_t start = 0;
+	while (start <= targets.size()) {
+		size_t end = targets.find(',', start);
+		if (end == std::string_view::npos) end = targets.size();
+
+		std::string_view entry = targets.substr(start, end - start);
+		while (!entry.empty() && entry.front() == ' ') entry.remove_prefix(1);
+		while (!entry.empty() && entry.back() == ' ') entry.remove_suffix(1);
+		if (entry.empty()) {
+			return Error(std::format("Empty entry in target list: \"{}\"", targets));
+		}
+
+		if (auto pid = StringUtils::TryParseInt(entry)) {
+			matcher.m_pids.insert(static_cast<DWORD>(pid.value()));
+		} else {
+			std::wstring name(entry.begin(), entry.end());
+			const size_t wildcard = name.find_last_of(L"*?");
+			if (wildcard == std::wstring::npos) {
+				matcher.m_names.insert(std::move(name));
+			} else {
+				std::wstring suffix = name.substr(wildcard + 1);
+				matcher.m_globs.push_back({std::move(name), std::move(suffix)});
+			}
+		}
+		start = end + 1;
+	}
+	return matcher;
+}
+
+bool TargetMatcher::Matches(DWORD pid, std::wstring_view name) const {
+	if (m_pids.contains(pid)) return true;
+	if (m_names.empty() && m_globs.empty()) return false;
+
+	if (m_names.contains(name)) return true;
+
+	return std::any_of(m_globs.begin(), m_globs.end(), [name](const Glob &glob) {
+		return CaseFold::EndsWith(name, glob.Suffix) && GlobMatch(glob.Pattern, name);
+	});
+}
+
+static bool SameUnit(wchar_t a, wchar_t b) {
+	return a == b || CaseFold::Equals(std::wstring_view(&a, 1), std::wstring_view(&b, 1));
+}
+
+// Wildcard match where '*' spans any run and '?' any one character, ignoring
+// case. On a mismatch only the most recent '*' is retried, which keeps it O(n * m).
+bool TargetMatcher::GlobMatch(std::wstring_view pattern, std::wstring_view text) {
+	size_t p = 0, t = 0;
+	size_t starP = std::wstring_view::npos, starT = 0;
+
+	while (t < text.size()) {
+		if (p < pattern.size() && pattern[p] == L'*') {
+			starP = p++;
+			starT = t;
+		} else if (p < pattern.size() && (pattern[p] == L'?' || SameUnit(pattern[p], text[t]))) {
+			++p;
+			++t;
+		} else if (starP != std::wstring_view::npos) {
+			p = starP + 1;
+			t = ++starT;
+		} else {
+			return false;
+		}
+	}
+	while (p < pattern.size() && pattern[p] == L'*') ++p;
+	return p == pattern.size();
+}
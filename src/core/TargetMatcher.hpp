@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+#include <Windows.h>
+
+#include "Result.hpp"
+#include "Error.hpp"
+#include "utils/CaseFold.hpp"
+
+/**
+ * @brief Compiled process target list, e.g. "chrome.exe,1234,node*.exe".
+ *        Each comma-separated entry is a PID, an image name or an image name
+ *        glob with '*' and '?'. Names compare case-insensitively. All entries
+ *        are checked together, so a snapshot is scanned once for the whole list.
+ */
+class TargetMatcher {
+public:
+	/**
+	 * @brief Parse a target list; fails on empty entries.
+	 */
+	static Result<TargetMatcher, Error> Compile(std::string_view targets);
+
+	bool Matches(DWORD pid, std::wstring_view name) const;
+
+private:
+	struct Glob {
+		std::wstring Pattern;
+		std::wstring Suffix; // Literal text after the last wildcard, checked first
+	};
+
+	static bool GlobMatch(std::wstring_view pattern, std::wstring_view text);
+
+	std::unordered_set<DWORD> m_pids;
+	std::unordered_set<std::wstring, CaseFold::Hasher, CaseFold::EqualTo> m_names;
+	std::vector<Glob> m_globs;
+};
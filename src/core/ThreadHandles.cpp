@@ -0,0 +1,27 @@
+#include "ThreadHandles.hpp"
+
+ThreadHandles::ThreadHandles(DWORD access) : m_access(access) {}
+
+Result<HANDLE, Error> ThreadHandles::Get(DWORD tid, DWORD access) {
+	{
+		std::lock_guard lock(m_mutex);
+		auto it = m_handles.find(tid);
+		if (it != m_handles.end() && (it->second.Access & access) == access) {
+			return it->second.Handle.get();
+		}
+	}
+
+	auto handle = HandleCache::Shared().Thread(tid, access, m_access);
+	if (!handle) return handle.error();
+
+	// Pin it, so an eviction from the shared cache can't close it mid-command.
+	std::lock_guard lock(m_mutex);
+	Pinned &pinned = m_handles[tid];
+	if (pinned.Handle != handle.value()) {
+		if (pinned.Handle) m_replaced.push_back(std::move(pinned.Handle));
+		pinned.Handle = std::move(handle.value());
+		pinned.Access = 0;
+	}
+	pinned.Access |= access;
+	return pinned.Handle.get();
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <Windows.h>
+
+#include "Result.hpp"
+#include "Error.hpp"
+#include "HandleCache.hpp"
+
+/**
+ * @brief Per-command view of thread handles. Each thread is opened once with the
+ *        union of the rights the command needs, and that handle is shared by every
+ *        query and action on the thread. If the union is denied, only the rights
+ *        the call asks for are requested. Handles come from HandleCache and are
+ *        pinned for the lifetime of the table, so the shared cache is only
+ *        consulted on first use or when a call needs rights the pinned handle
+ *        wasn't opened for. Thread-safe.
+ */
+class ThreadHandles {
+public:
+	explicit ThreadHandles(DWORD access);
+
+	ThreadHandles(const ThreadHandles &) = delete;
+	ThreadHandles &operator=(const ThreadHandles &) = delete;
+
+	/**
+	 * @brief Get a handle to the thread with at least the requested rights.
+	 *        The handle stays owned by the table and must not be closed.
+	 */
+	Result<HANDLE, Error> Get(DWORD tid, DWORD access);
+
+private:
+	struct Pinned {
+		SharedHandle Handle;
+		DWORD Access = 0; // Rights the handle was handed out for
+	};
+
+	DWORD m_access;
+	std::mutex m_mutex;
+	std::unordered_map<DWORD, Pinned> m_handles;
+	// Handles replaced by an upgrade; another caller may still be using them.
+	std::vector<SharedHandle> m_replaced;
+};
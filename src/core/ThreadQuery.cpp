@@ -0,0 +1,161 @@
+#include "ThreadQuery.hpp"
+
+#include <format>
+#include <algorithm>
+#include <cctype>
+#include <functional>
+
+#include "Convert.hpp"
+#include "ModuleMap.hpp"
+#include "utils/PerfectHash.hpp"
+#include "utils/StringUtils.hpp"
+#include "utils/ThreadPool.hpp"
+
+std::optional<PriorityFilter> PriorityFilter::Parse(std::string_view value) {
+	PriorityFilter filter;
+	if (auto level = StringUtils::TryParseInt(value)) {
+		filter.Level = static_cast<LONG>(level.value());
+		return filter;
+	}
+
+	if (!Convert::ParseThreadPriority(value).has_value()) return std::nullopt;
+	filter.Normalized = StringUtils::Normalize(value);
+	return filter;
+}
+
+bool PriorityFilter::Matches(LONG basePriority) const {
+	if (Level) return basePriority == Level.value();
+	// Both sides come from constant tables or were normalized once; no allocation.
+	return PerfectHash::Equals(Convert::ThreadPriorityToString(basePriority), Normalized);
+}
+
+// Returns the module name when the pattern is anchored on a literal module,
+// e.g. "^mydll\.dll!" -> "mydll.dll". Such a pattern can only match threads
+// starting inside that module, so they can be picked by address range first.
+static std::optional<std::string> GetLiteralModulePrefix(std::string_view pattern) {
+	if (pattern.empty() || pattern.front() != '^') return std::nullopt;
+
+	// An alternation anywhere could match outside the module.
+	for (size_t i = 0; i < pattern.size(); ++i) {
+		if (pattern[i] == '\\') {
+			++i;
+		} else if (pattern[i] == '|') {
+			return std::nullopt;
+		}
+	}
+
+	std::string module;
+	for (size_t i = 1; i < pattern.size(); ++i) {
+		const char c = pattern[i];
+		if (c == '!') return module.empty() ? std::nullopt : std::optional(module);
+
+		if (c == '\\') {
+			if (i + 1 >= pattern.size()) return std::nullopt;
+			const char escaped = pattern[++i];
+			if (std::isalnum(static_cast<unsigned char>(escaped))) return std::nullopt;
+			module += escaped;
+		} else if (std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '-' ||
+				   c == ' ') {
+			module += c;
+		} else {
+			return std::nullopt; // Metacharacter, not a literal module name
+		}
+	}
+	return std::nullopt;
+}
+
+ThreadQueryPlan::ThreadQueryPlan(ThreadQuery query) : m_query(std::move(query)) {}
+
+Result<ThreadQueryPlan, Error> ThreadQueryPlan::Compile(ThreadQuery query) {
+	ThreadQueryPlan plan(std::move(query));
+	if (!plan.m_query.AddressPattern) return plan;
+
+	const std::string &pattern = plan.m_query.AddressPattern.value();
+	plan.m_dfa = DfaRegex::Compile(pattern, true);
+	if (!plan.m_dfa) {
+		try {
+			plan.m_regex = std::regex(pattern, std::regex_constants::icase);
+		} catch (const std::regex_error &) {
+			return Error(std::format("Invalid regex pattern: {}", pattern));
+		}
+	}
+	plan.m_literalModule = GetLiteralModulePrefix(pattern);
+	return plan;
+}
+
+Result<ThreadSelection, Error>
+ThreadQueryPlan::Select(DWORD pid, const std::shared_ptr<ThreadHandles> &handles) const {
+	auto threadsResult = ProcessUtils::GetThreads(pid, handles);
+	if (!threadsResult.has_value()) {
+		return threadsResult.error();
+	}
+
+	// Stage 1: snapshot predicates, no syscalls.
+	ThreadSelection selection;
+	std::vector<ThreadAddrInfo> otherPriority;
+	for (auto &t : threadsResult.value()) {
+		if (m_query.Tid && t.info.Tid != m_query.Tid.value()) continue;
+
+		if (m_query.Priority && !m_query.Priority->Matches(t.info.BasePriority)) {
+			otherPriority.push_back(std::move(t));
+		} else {
+			selection.Threads.push_back(std::move(t));
+		}
+	}
+
+	Narrow(pid, selection.Threads);
+
+	// Only on failure: tell "no such thread" apart from "thread has another priority".
+	if (selection.Threads.empty() && !otherPriority.empty()) {
+		Narrow(pid, otherPriority);
+		selection.PriorityExcluded = !otherPriority.empty();
+	}
+
+	return selection;
+}
+
+void ThreadQueryPlan::Narrow(DWORD pid, std::vector<ThreadAddrInfo> &threads) const {
+	auto keep = [&threads](auto pred) {
+		auto rejected = std::remove_if(threads.begin(), threads.end(), std::not_fn(pred));
+		threads.erase(rejected, threads.end());
+	};
+
+	// Stage 2: thread name.
+	if (m_query.Name && !threads.empty()) {
+		ProcessUtils::PrefetchNames(threads);
+		keep([this](const ThreadAddrInfo &t) {
+			return t.Name() == m_query.Name.value();
+		});
+	}
+
+	if (!m_query.AddressPattern || threads.empty()) return;
+
+	// Stage 3a: raw start address against the anchored module's ranges.
+	if (m_literalModule) {
+		auto modulesResult = ModuleMap::ForProcess(pid);
+		if (modulesResult) {
+			const auto &modules = modulesResult.value();
+			const auto ranges = modules->FindByName(m_literalModule.value());
+
+			ThreadPool::Shared().ParallelFor(threads.size(), [&](size_t i) {
+				threads[i].Address();
+			});
+			keep([&ranges](const ThreadAddrInfo &t) {
+				const auto addr = reinterpret_cast<ULONG_PTR>(t.Address());
+				return std::any_of(ranges.begin(), ranges.end(), [addr](auto *m) {
+					return addr - m->Base < m->Size;
+				});
+			});
+		}
+	}
+
+	// Stage 3b: symbolized start address.
+	keep([this](const ThreadAddrInfo &t) {
+		return MatchesAddress(t.StartAddress());
+	});
+}
+
+bool ThreadQueryPlan::MatchesAddress(const std::string &address) const {
+	if (m_dfa) return m_dfa->Search(address);
+	return std::regex_search(address, m_regex.value());
+}
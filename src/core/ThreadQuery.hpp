@@ -0,0 +1,83 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <regex>
+#include <string>
+#include <vector>
+#include <Windows.h>
+
+#include "Result.hpp"
+#include "Error.hpp"
+#include "ProcessUtils.hpp"
+#include "ThreadHandles.hpp"
+#include "utils/DfaRegex.hpp"
+
+/**
+ * @brief Thread base priority filter, either a numeric level or a priority name.
+ */
+struct PriorityFilter {
+	std::optional<LONG> Level;
+	std::string Normalized; // Normalized priority name, used when Level is empty
+
+	/**
+	 * @brief Parse a -withpriority value; nullopt when it's neither a number nor a name.
+	 */
+	static std::optional<PriorityFilter> Parse(std::string_view value);
+
+	bool Matches(LONG basePriority) const;
+};
+
+/**
+ * @brief Thread selection predicates. Unset predicates select every thread.
+ */
+struct ThreadQuery {
+	std::optional<DWORD> Tid;
+	std::optional<std::string> Name;
+	std::optional<std::string> AddressPattern; // Regex over module!symbol+0xoff
+	std::optional<PriorityFilter> Priority;
+};
+
+struct ThreadSelection {
+	std::vector<ThreadAddrInfo> Threads;
+	// Set when nothing was selected, but some thread matched all predicates
+	// except the priority filter.
+	bool PriorityExcluded = false;
+};
+
+/**
+ * @brief Compiled ThreadQuery. Predicates run cheapest first and each stage only
+ *        sees the survivors of the previous one:
+ *          1. TID and priority, straight from the kernel snapshot;
+ *          2. name, one query per thread;
+ *          3. start address: module range for patterns anchored on a literal
+ *             module, then the regex over the symbolized address.
+ *        The address pattern runs on DfaRegex; std::regex is only used for the
+ *        constructs DfaRegex doesn't support.
+ */
+class ThreadQueryPlan {
+public:
+	/**
+	 * @brief Validate the query and compile its address pattern.
+	 */
+	static Result<ThreadQueryPlan, Error> Compile(ThreadQuery query);
+
+	/**
+	 * @brief Select the threads of a process, reusing handles from the table.
+	 */
+	Result<ThreadSelection, Error>
+	Select(DWORD pid, const std::shared_ptr<ThreadHandles> &handles) const;
+
+private:
+	explicit ThreadQueryPlan(ThreadQuery query);
+
+	// Runs the name and start address stages in place.
+	void Narrow(DWORD pid, std::vector<ThreadAddrInfo> &threads) const;
+
+	bool MatchesAddress(const std::string &address) const;
+
+	ThreadQuery m_query;
+	std::optional<DfaRegex> m_dfa;
+	std::optional<std::regex> m_regex; // Fallback when m_dfa is empty
+	std::optional<std::string> m_literalModule;
+};
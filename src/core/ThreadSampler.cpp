@@ -0,0 +1,67 @@
+#include "ThreadSampler.hpp"
+
+#include <algorithm>
+#include <thread>
+
+namespace {
+	struct Counters {
+		ULONGLONG CpuTime; // Kernel + user, 100ns units
+		ULONG ContextSwitches;
+	};
+
+	Counters CountersOf(const ThreadInfo &t) {
+		return {t.KernelTime + t.UserTime, t.ContextSwitches};
+	}
+} // namespace
+
+size_t ThreadKeyHash::operator()(const ThreadKey &key) const noexcept {
+	size_t h = std::hash<ULONGLONG>{}(key.CreateTime);
+	return h ^ (std::hash<DWORD>{}(key.Tid) + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2));
+}
+
+Result<ThreadSample, Error> ThreadSampler::Sample(std::chrono::milliseconds interval) {
+	using Clock = std::chrono::steady_clock;
+
+	auto firstResult = NtUtils::GetAllProcessThreads(false);
+	if (!firstResult.has_value()) {
+		return firstResult.error();
+	}
+	const Clock::time_point firstTime = Clock::now();
+
+	std::unordered_map<ThreadKey, Counters, ThreadKeyHash> before;
+	for (const auto &entry : firstResult.value()) {
+		for (const auto &t : entry.Threads) {
+			before[ThreadKey::Of(t)] = CountersOf(t);
+		}
+	}
+
+	std::this_thread::sleep_for(interval - (Clock::now() - firstTime));
+
+	auto secondResult = NtUtils::GetAllProcessThreads(false);
+	if (!secondResult.has_value()) {
+		return secondResult.error();
+	}
+	const Clock::time_point secondTime = Clock::now();
+
+	const auto elapsed = std::chrono::duration<double>(secondTime - firstTime).count();
+	const DWORD cpus =
+		(std::max)(GetActiveProcessorCount(ALL_PROCESSOR_GROUPS), DWORD{1});
+	// CPU time is in 100ns units; the whole machine offers elapsed * cpus of it.
+	const double capacity = elapsed * 1e7 * cpus;
+
+	ThreadSample sample{std::move(secondResult.value()), {}};
+	for (const auto &entry : sample.Processes) {
+		for (const auto &t : entry.Threads) {
+			const Counters now = CountersOf(t);
+			Counters base{0, 0}; // Started within the interval
+			auto it = before.find(ThreadKey::Of(t));
+			if (it != before.end()) base = it->second;
+
+			sample.Activity[ThreadKey::Of(t)] = {
+				capacity > 0 ? (now.CpuTime - base.CpuTime) * 100.0 / capacity : 0.0,
+				elapsed > 0 ? (now.ContextSwitches - base.ContextSwitches) / elapsed : 0.0
+			};
+		}
+	}
+	return sample;
+}
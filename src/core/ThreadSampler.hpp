@@ -0,0 +1,48 @@
+#pragma once
+
+#include <chrono>
+#include <unordered_map>
+#include <vector>
+#include <Windows.h>
+
+#include "Result.hpp"
+#include "Error.hpp"
+#include "NtUtils.hpp"
+
+struct ThreadActivity {
+	double CpuPercent;            // Share of total CPU time (all cores) over the interval
+	double ContextSwitchesPerSec;
+};
+
+// A TID alone may be reused between snapshots; with the creation time it can't.
+struct ThreadKey {
+	DWORD Tid;
+	ULONGLONG CreateTime;
+
+	static ThreadKey Of(const ThreadInfo &t) { return {t.Tid, t.CreateTime}; }
+
+	bool operator==(const ThreadKey &) const = default;
+};
+
+struct ThreadKeyHash {
+	size_t operator()(const ThreadKey &key) const noexcept;
+};
+
+using ThreadActivityMap =
+	std::unordered_map<ThreadKey, ThreadActivity, ThreadKeyHash>;
+
+struct ThreadSample {
+	std::vector<ProcessThreads> Processes; // Second snapshot
+	ThreadActivityMap Activity;            // Covers every thread above
+};
+
+namespace ThreadSampler {
+
+	/**
+	 * @brief Snapshot all threads twice, interval apart, and compute each thread's
+	 *        CPU usage and context switch rate in between. Threads that exited
+	 *        before the second snapshot are left out.
+	 */
+	Result<ThreadSample, Error> Sample(std::chrono::milliseconds interval);
+
+} // namespace ThreadSampler
@@ -0,0 +1,69 @@
+#include "ThreadSource.hpp"
+
+#include <format>
+
+#include "WinError.hpp"
+#include "utils/StringUtils.hpp"
+
+typedef HRESULT(WINAPI *GetThreadDescription_t)(
+	HANDLE hThread, PWSTR *ppszThreadDescription
+);
+
+ThreadSource::ThreadSource(DWORD pid, std::shared_ptr<ThreadHandles> handles)
+	: m_pid(pid), m_handles(std::move(handles)) {}
+
+Result<std::string, Error> ThreadSource::QueryName(DWORD tid) {
+	// Resolved once; called concurrently from the thread pool.
+	static const auto pGetThreadDescription = [] {
+		auto fn = reinterpret_cast<GetThreadDescription_t>(
+			GetProcAddress(GetModuleHandleW(L"kernelbase.dll"), "GetThreadDescription")
+		);
+		if (!fn) {
+			fn = reinterpret_cast<GetThreadDescription_t>(
+				GetProcAddress(GetModuleHandleW(L"kernel32.dll"), "GetThreadDescription")
+			);
+		}
+		return fn;
+	}();
+
+	if (!pGetThreadDescription) {
+		return Error(
+			"GetThreadDescription symbol not found in kernelbase.dll or "
+			"kernel32.dll"
+		);
+	}
+
+	auto hThread = m_handles->Get(tid, THREAD_QUERY_LIMITED_INFORMATION);
+	if (!hThread) return hThread.error();
+
+	PWSTR pszDesc = nullptr;
+	HRESULT hr = pGetThreadDescription(hThread.value(), &pszDesc);
+	std::string name = "";
+	if (SUCCEEDED(hr)) {
+		if (pszDesc) {
+			name = StringUtils::WstrToString(pszDesc);
+			LocalFree(pszDesc);
+		}
+	} else {
+		return WinErr(hr, std::format("GetThreadDescription failed for TID {}", tid));
+	}
+	return name;
+}
+
+PVOID ThreadSource::QueryStartAddress(const ThreadInfo &info) {
+	if (info.Win32StartAddress) return info.Win32StartAddress;
+
+	auto hThread = m_handles->Get(info.Tid, THREAD_QUERY_INFORMATION);
+	if (hThread) {
+		if (PVOID address = NtUtils::GetThreadStartAddress(hThread.value())) {
+			return address;
+		}
+	}
+	return info.NativeStartAddress;
+}
+
+std::string ThreadSource::Symbolize(PVOID address) {
+	std::lock_guard lock(m_symbolMutex);
+	if (!m_session) m_session = std::make_unique<Symbols::Session>(m_pid);
+	return m_session->FormatAddress(address);
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <Windows.h>
+
+#include "Result.hpp"
+#include "Error.hpp"
+#include "NtUtils.hpp"
+#include "Symbols.hpp"
+#include "ThreadHandles.hpp"
+
+/**
+ * @brief Per-process backend for the lazy thread columns (name, start address).
+ *        Shares the command's thread handles and opens a dbghelp session only when
+ *        the first start address is symbolized. Thread-safe.
+ */
+class ThreadSource {
+public:
+	ThreadSource(DWORD pid, std::shared_ptr<ThreadHandles> handles);
+
+	DWORD Pid() const { return m_pid; }
+
+	/**
+	 * @brief Fetch the thread description (GetThreadDescription).
+	 */
+	Result<std::string, Error> QueryName(DWORD tid);
+
+	/**
+	 * @brief Win32 start address when the snapshot lacks it and the thread can be
+	 *        queried, otherwise the native start address.
+	 */
+	PVOID QueryStartAddress(const ThreadInfo &info);
+
+	/**
+	 * @brief Format an address as module!symbol+0xoff through the process session.
+	 */
+	std::string Symbolize(PVOID address);
+
+private:
+	DWORD m_pid;
+	std::shared_ptr<ThreadHandles> m_handles;
+	std::mutex m_symbolMutex; // dbghelp is single-threaded
+	std::unique_ptr<Symbols::Session> m_session;
+};
@@ -0,0 +1,239 @@
+#include "ThreadStats.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include <unordered_map>
+
+#include "Convert.hpp"
+#include "NtUtils.hpp"
+#include "ProcessUtils.hpp"
+#include "SymbolBatch.hpp"
+#include "ThreadHandles.hpp"
+#include "ThreadSource.hpp"
+#include "utils/ThreadPool.hpp"
+
+Result<StartAddressReport, Error> ThreadStats::GroupByStartAddress(size_t symbolWorkers) {
+	auto snapshotResult = NtUtils::GetAllProcessThreads(true);
+	if (!snapshotResult) return snapshotResult.error();
+
+	const auto &snapshot = snapshotResult.value();
+
+	// Visit the busiest processes first so they become the representatives that
+	// resolve shared module offsets, which keeps the number of dbghelp sessions low.
+	std::vector<size_t> order(snapshot.size());
+	std::iota(order.begin(), order.end(), size_t{0});
+	std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+		return snapshot[a].Threads.size() > snapshot[b].Threads.size();
+	});
+
+	struct ThreadRef {
+		size_t ProcessIdx;
+		size_t Slot;
+	};
+
+	SymbolBatch batch(symbolWorkers);
+	std::vector<ThreadRef> refs;
+	StartAddressReport report;
+
+	for (size_t procIdx : order) {
+		const auto &[proc, threads] = snapshot[procIdx];
+		if (proc.Pid == 0) continue; // Idle "threads" are per-CPU placeholders
+
+		++report.TotalProcesses;
+		for (const auto &t : threads) {
+			refs.push_back({procIdx, batch.Add(proc.Pid, ProcessUtils::BestStartAddress(t))});
+		}
+	}
+
+	batch.Resolve();
+	report.TotalThreads = refs.size();
+	report.SymbolLookups = batch.LookupCount();
+
+	std::unordered_map<std::string, size_t> groupIndex;
+	std::vector<size_t> lastProcess; // Per group, to count distinct processes
+	std::unordered_map<unsigned long long, size_t> processGroupIndex;
+
+	for (const auto &ref : refs) {
+		const std::string &symbol = batch.Get(ref.Slot);
+		const std::string &key = symbol.empty() ? "<unknown>" : symbol;
+
+		auto [it, inserted] = groupIndex.try_emplace(key, report.Groups.size());
+		if (inserted) {
+			report.Groups.push_back({key, 0, 0});
+			lastProcess.push_back(SIZE_MAX);
+		}
+
+		const size_t groupIdx = it->second;
+		auto &group = report.Groups[groupIdx];
+		++group.Threads;
+
+		// Threads are visited process by process, so a change means a new process.
+		if (lastProcess[groupIdx] != ref.ProcessIdx) {
+			lastProcess[groupIdx] = ref.ProcessIdx;
+			++group.Processes;
+		}
+
+		const unsigned long long pgKey =
+			(static_cast<unsigned long long>(ref.ProcessIdx) << 32) | groupIdx;
+		auto [pgIt, pgInserted] =
+			processGroupIndex.try_emplace(pgKey, report.ProcessGroups.size());
+		if (pgInserted) {
+			const auto &proc = snapshot[ref.ProcessIdx].Process;
+			report.ProcessGroups.push_back({proc.Pid, proc.Name, key, 0});
+		}
+		++report.ProcessGroups[pgIt->second].Threads;
+	}
+
+	std::stable_sort(
+		report.Groups.begin(),
+		report.Groups.end(),
+		[](const StartAddressGroup &a, const StartAddressGroup &b) {
+			return a.Threads > b.Threads;
+		}
+	);
+	std::stable_sort(
+		report.ProcessGroups.begin(),
+		report.ProcessGroups.end(),
+		[](const ProcessStartGroup &a, const ProcessStartGroup &b) {
+			return a.Threads > b.Threads;
+		}
+	);
+
+	return report;
+}
+
+Result<HotThreadReport, Error> ThreadStats::TopByCpu(
+	std::chrono::milliseconds interval, size_t top, size_t symbolWorkers
+) {
+	auto sampleResult = ThreadSampler::Sample(interval);
+	if (!sampleResult) return sampleResult.error();
+
+	const ThreadSample &sample = sampleResult.value();
+
+	struct Candidate {
+		const ThreadActivity *Activity;
+		const ProcessInfo *Process;
+		const ThreadInfo *Thread;
+	};
+
+	// Min-heap of the busiest threads seen so far; the least busy winner is on top.
+	auto busier = [](const Candidate &a, const Candidate &b) {
+		if (a.Activity->CpuPercent != b.Activity->CpuPercent) {
+			return a.Activity->CpuPercent > b.Activity->CpuPercent;
+		}
+		return a.Activity->ContextSwitchesPerSec > b.Activity->ContextSwitchesPerSec;
+	};
+
+	HotThreadReport report;
+	report.Interval = interval;
+
+	std::vector<Candidate> heap;
+	heap.reserve(top + 1);
+	for (const auto &[proc, threads] : sample.Processes) {
+		if (proc.Pid == 0) continue; // Idle "threads" are per-CPU placeholders
+
+		for (const auto &t : threads) {
+			++report.TotalThreads;
+			const ThreadActivity &activity = sample.Activity.at(ThreadKey::Of(t));
+			const Candidate candidate{&activity, &proc, &t};
+
+			if (heap.size() < top) {
+				heap.push_back(candidate);
+				std::push_heap(heap.begin(), heap.end(), busier);
+			} else if (top > 0 && busier(candidate, heap.front())) {
+				std::pop_heap(heap.begin(), heap.end(), busier);
+				heap.back() = candidate;
+				std::push_heap(heap.begin(), heap.end(), busier);
+			}
+		}
+	}
+	std::sort_heap(heap.begin(), heap.end(), busier); // Busiest first
+
+	// Name the winners and find their Win32 start addresses, one source per process.
+	auto handles = std::make_shared<ThreadHandles>(THREAD_QUERY_INFORMATION);
+	std::unordered_map<DWORD, std::shared_ptr<ThreadSource>> sources;
+	for (const auto &c : heap) {
+		auto &source = sources[c.Process->Pid];
+		if (!source) source = std::make_shared<ThreadSource>(c.Process->Pid, handles);
+	}
+
+	std::vector<PVOID> addresses(heap.size());
+	report.Threads.resize(heap.size());
+	ThreadPool::Shared().ParallelFor(heap.size(), [&](size_t i) {
+		const Candidate &c = heap[i];
+		ThreadSource &source = *sources.at(c.Process->Pid);
+
+		HotThread &hot = report.Threads[i];
+		hot.Pid = c.Process->Pid;
+		hot.ProcessName = c.Process->Name;
+		hot.Tid = c.Thread->Tid;
+		hot.Name = source.QueryName(c.Thread->Tid).value_or("");
+		hot.Activity = *c.Activity;
+		addresses[i] = source.QueryStartAddress(*c.Thread);
+	});
+
+	SymbolBatch batch(symbolWorkers);
+	std::vector<size_t> slots;
+	slots.reserve(heap.size());
+	for (size_t i = 0; i < heap.size(); ++i) {
+		slots.push_back(batch.Add(report.Threads[i].Pid, addresses[i]));
+	}
+	batch.Resolve();
+	report.SymbolLookups = batch.LookupCount();
+
+	for (size_t i = 0; i < heap.size(); ++i) {
+		report.Threads[i].StartAddress = batch.Get(slots[i]);
+	}
+	return report;
+}
+
+size_t ThreadStateCounts::BucketOf(ULONG threadState, ULONG waitReason) {
+	constexpr ULONG kWaiting = 5;
+	if (threadState != kWaiting) {
+		return threadState < kStates ? threadState : kUnknown;
+	}
+	return waitReason < kWaitReasons ? kStates + waitReason : kUnknown;
+}
+
+std::string ThreadStateCounts::BucketName(size_t bucket) {
+	if (bucket < kStates) {
+		return std::string(Convert::ThreadStateToString(static_cast<ULONG>(bucket)));
+	}
+	if (bucket < kUnknown) {
+		const auto waitReason = static_cast<ULONG>(bucket - kStates);
+		return std::string("Waiting: ").append(Convert::WaitReasonToString(waitReason));
+	}
+	return "Unknown";
+}
+
+Result<ThreadStateReport, Error> ThreadStats::GroupByState() {
+	auto snapshotResult = NtUtils::GetAllProcessThreads(false);
+	if (!snapshotResult) return snapshotResult.error();
+
+	ThreadStateReport report;
+	for (const auto &[proc, threads] : snapshotResult.value()) {
+		if (proc.Pid == 0) continue; // Idle "threads" are per-CPU placeholders
+
+		report.Processes.push_back({proc.Pid, proc.Name, threads.size(), {}});
+		ProcessStateCounts &counts = report.Processes.back();
+		for (const auto &t : threads) {
+			const size_t bucket =
+				ThreadStateCounts::BucketOf(t.ThreadState, t.WaitReason);
+			++counts.States.Counts[bucket];
+			++report.Total.Counts[bucket];
+		}
+		report.TotalThreads += threads.size();
+	}
+
+	std::stable_sort(
+		report.Processes.begin(),
+		report.Processes.end(),
+		[](const ProcessStateCounts &a, const ProcessStateCounts &b) {
+			return a.Threads > b.Threads;
+		}
+	);
+
+	return report;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <Windows.h>
+
+#include "Result.hpp"
+#include "Error.hpp"
+#include "ThreadSampler.hpp"
+
+struct StartAddressGroup {
+	std::string StartAddress;
+	size_t Threads;
+	size_t Processes;
+};
+
+struct ProcessStartGroup {
+	DWORD Pid;
+	std::wstring ProcessName;
+	std::string StartAddress;
+	size_t Threads;
+};
+
+struct StartAddressReport {
+	std::vector<StartAddressGroup> Groups;        // Sorted by thread count, descending
+	std::vector<ProcessStartGroup> ProcessGroups; // Sorted by thread count, descending
+	size_t TotalThreads = 0;
+	size_t TotalProcesses = 0;
+	size_t SymbolLookups = 0;
+};
+
+struct HotThread {
+	DWORD Pid;
+	std::wstring ProcessName;
+	DWORD Tid;
+	std::string Name;
+	std::string StartAddress;
+	ThreadActivity Activity;
+};
+
+struct HotThreadReport {
+	std::vector<HotThread> Threads; // Sorted by CPU, descending
+	std::chrono::milliseconds Interval;
+	size_t TotalThreads = 0;
+	size_t SymbolLookups = 0;
+};
+
+/**
+ * @brief Thread counts per (state, wait reason), one flat counter per bucket.
+ *        Waiting threads are counted by wait reason, all others by state.
+ */
+struct ThreadStateCounts {
+	static constexpr size_t kStates = 10;      // KTHREAD_STATE 0..9
+	static constexpr size_t kWaitReasons = 43; // KWAIT_REASON 0..42
+	static constexpr size_t kUnknown = kStates + kWaitReasons;
+	static constexpr size_t kBuckets = kUnknown + 1;
+
+	std::array<uint32_t, kBuckets> Counts{};
+
+	static size_t BucketOf(ULONG threadState, ULONG waitReason);
+	static std::string BucketName(size_t bucket);
+};
+
+struct ProcessStateCounts {
+	DWORD Pid;
+	std::wstring ProcessName;
+	size_t Threads;
+	ThreadStateCounts States;
+};
+
+struct ThreadStateReport {
+	ThreadStateCounts Total;
+	std::vector<ProcessStateCounts> Processes; // Sorted by thread count, descending
+	size_t TotalThreads = 0;
+};
+
+namespace ThreadStats {
+
+	/**
+	 * @brief Count every thread on the system by symbolized start address, overall
+	 *        and per process. Each distinct module offset is resolved only once.
+	 */
+	Result<StartAddressReport, Error> GroupByStartAddress(size_t symbolWorkers);
+
+	/**
+	 * @brief Sample every thread on the system over the interval and rank the top
+	 *        threads by CPU usage. Only the winners are named and symbolized.
+	 */
+	Result<HotThreadReport, Error>
+	TopByCpu(std::chrono::milliseconds interval, size_t top, size_t symbolWorkers);
+
+	/**
+	 * @brief Count every thread on the system by state and wait reason, overall
+	 *        and per process, in one pass over a single snapshot.
+	 */
+	Result<ThreadStateReport, Error> GroupByState();
+
+} // namespace ThreadStats
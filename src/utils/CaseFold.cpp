@@ -0,0 +1,152 @@
+#include "CaseFold.hpp"
+
+#include <cstdint>
+#include <cwctype>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#endif
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define CASEFOLD_SSE2
+#elif defined(_M_ARM64) || defined(__aarch64__)
+#include <arm_neon.h>
+#define CASEFOLD_NEON
+#endif
+
+namespace {
+	constexpr uint32_t FoldAscii(uint32_t u) { return (u - 'A' < 26) ? u + 0x20 : u; }
+
+	// The one case mapping behind Equals and Hash for non-ASCII units: the
+	// invariant uppercase on Windows, towupper elsewhere.
+	uint32_t UpperUnit(uint32_t u) {
+		if (u <= 0x7f) return (u - 'a' < 26) ? u - 0x20 : u;
+#if defined(_WIN32)
+		WCHAR in = static_cast<WCHAR>(u), out = in;
+		LCMapStringEx(
+			LOCALE_NAME_INVARIANT, LCMAP_UPPERCASE, &in, 1, &out, 1, nullptr, nullptr, 0
+		);
+		return out;
+#else
+		return static_cast<uint32_t>(std::towupper(static_cast<wint_t>(u)));
+#endif
+	}
+
+	// Equality from the first non-ASCII unit on.
+	template <typename Char> bool EqualsSlow(const Char *a, const Char *b, size_t n) {
+		for (size_t i = 0; i < n; ++i) {
+			const auto ca = static_cast<uint32_t>(a[i]);
+			const auto cb = static_cast<uint32_t>(b[i]);
+			if (ca != cb && UpperUnit(ca) != UpperUnit(cb)) return false;
+		}
+		return true;
+	}
+
+#if defined(CASEFOLD_SSE2)
+	// Lowercases ASCII letters in 8 units; nonAscii collects units above 0x7f.
+	inline __m128i FoldBlock(__m128i v, __m128i &nonAscii) {
+		nonAscii = _mm_or_si128(nonAscii, _mm_andnot_si128(_mm_set1_epi16(0x7f), v));
+		// Units above 0x7f fail the signed range check either way: they are
+		// either negative or caught by nonAscii before the result is used.
+		const __m128i upper = _mm_and_si128(
+			_mm_cmpgt_epi16(v, _mm_set1_epi16('A' - 1)),
+			_mm_cmplt_epi16(v, _mm_set1_epi16('Z' + 1))
+		);
+		return _mm_or_si128(v, _mm_and_si128(upper, _mm_set1_epi16(0x20)));
+	}
+#elif defined(CASEFOLD_NEON)
+	inline uint16x8_t FoldBlock(uint16x8_t v, uint16x8_t &nonAscii) {
+		nonAscii = vorrq_u16(nonAscii, vcgtq_u16(v, vdupq_n_u16(0x7f)));
+		const uint16x8_t upper =
+			vandq_u16(vcgeq_u16(v, vdupq_n_u16('A')), vcleq_u16(v, vdupq_n_u16('Z')));
+		return vorrq_u16(v, vandq_u16(upper, vdupq_n_u16(0x20)));
+	}
+#endif
+
+	// Number of leading units that are ASCII in both strings and equal ignoring
+	// case, in whole 8-unit blocks. Stops at the first block that differs or
+	// holds a non-ASCII unit; returns SIZE_MAX if a block differs in ASCII.
+	template <typename Char>
+	size_t VectorPrefix(const Char *a, const Char *b, size_t n) {
+		size_t i = 0;
+		if constexpr (sizeof(Char) == 2) {
+#if defined(CASEFOLD_SSE2)
+			for (; i + 8 <= n; i += 8) {
+				__m128i nonAscii = _mm_setzero_si128();
+				const __m128i va = FoldBlock(
+					_mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i)), nonAscii
+				);
+				const __m128i vb = FoldBlock(
+					_mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i)), nonAscii
+				);
+				const __m128i ascii = _mm_cmpeq_epi16(nonAscii, _mm_setzero_si128());
+				if (_mm_movemask_epi8(ascii) != 0xffff) break;
+				if (_mm_movemask_epi8(_mm_cmpeq_epi16(va, vb)) != 0xffff) return SIZE_MAX;
+			}
+#elif defined(CASEFOLD_NEON)
+			for (; i + 8 <= n; i += 8) {
+				const auto *ua = reinterpret_cast<const uint16_t *>(a + i);
+				const auto *ub = reinterpret_cast<const uint16_t *>(b + i);
+				uint16x8_t nonAscii = vdupq_n_u16(0);
+				const uint16x8_t va = FoldBlock(vld1q_u16(ua), nonAscii);
+				const uint16x8_t vb = FoldBlock(vld1q_u16(ub), nonAscii);
+				if (vmaxvq_u16(nonAscii) != 0) break;
+				if (vminvq_u16(vceqq_u16(va, vb)) == 0) return SIZE_MAX;
+			}
+#endif
+		}
+		return i;
+	}
+
+	template <typename Char>
+	bool EqualsImpl(std::basic_string_view<Char> a, std::basic_string_view<Char> b) {
+		if (a.size() != b.size()) return false;
+
+		const size_t n = a.size();
+		size_t i = VectorPrefix(a.data(), b.data(), n);
+		if (i == SIZE_MAX) return false;
+
+		for (; i < n; ++i) {
+			const auto ca = static_cast<uint32_t>(a[i]);
+			const auto cb = static_cast<uint32_t>(b[i]);
+			if ((ca | cb) > 0x7f) return EqualsSlow(a.data() + i, b.data() + i, n - i);
+			if (FoldAscii(ca) != FoldAscii(cb)) return false;
+		}
+		return true;
+	}
+} // namespace
+
+bool CaseFold::Equals(std::wstring_view a, std::wstring_view b) {
+	return EqualsImpl(a, b);
+}
+
+bool CaseFold::Equals(std::u16string_view a, std::u16string_view b) {
+	return EqualsImpl(a, b);
+}
+
+bool CaseFold::Equals(std::string_view a, std::string_view b) {
+	if (a.size() != b.size()) return false;
+	for (size_t i = 0; i < a.size(); ++i) {
+		if (FoldAscii(static_cast<unsigned char>(a[i])) !=
+			FoldAscii(static_cast<unsigned char>(b[i]))) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool CaseFold::EndsWith(std::wstring_view text, std::wstring_view suffix) {
+	return text.size() >= suffix.size() &&
+		   Equals(text.substr(text.size() - suffix.size()), suffix);
+}
+
+size_t CaseFold::Hash(std::wstring_view str) {
+	// FNV-1a over uppercased units, the same mapping Equals falls back on.
+	uint64_t hash = 0xcbf29ce484222325ull;
+	for (wchar_t c : str) {
+		hash ^= UpperUnit(static_cast<uint32_t>(c));
+		hash *= 0x100000001b3ull;
+	}
+	return static_cast<size_t>(hash);
+}
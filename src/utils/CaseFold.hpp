@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+/**
+ * @brief Allocation-free case-insensitive string comparison and hashing.
+ *        ASCII runs are compared 8 UTF-16 units at a time (SSE2 or NEON); from
+ *        the first non-ASCII unit on, units are uppercased one by one (invariant
+ *        locale on Windows, towupper elsewhere).
+ */
+namespace CaseFold {
+
+	bool Equals(std::wstring_view a, std::wstring_view b);
+	bool Equals(std::u16string_view a, std::u16string_view b);
+
+	/**
+	 * @brief ASCII-only case-insensitive equality for narrow strings.
+	 */
+	bool Equals(std::string_view a, std::string_view b);
+
+	/**
+	 * @brief True when text ends with suffix, ignoring case.
+	 */
+	bool EndsWith(std::wstring_view text, std::wstring_view suffix);
+
+	/**
+	 * @brief Hash consistent with Equals: strings that compare equal hash equal.
+	 */
+	size_t Hash(std::wstring_view str);
+
+	// Transparent functors for unordered containers keyed case-insensitively.
+	struct Hasher {
+		using is_transparent = void;
+		size_t operator()(std::wstring_view str) const noexcept { return Hash(str); }
+	};
+
+	struct EqualTo {
+		using is_transparent = void;
+		bool operator()(std::wstring_view a, std::wstring_view b) const noexcept {
+			return Equals(a, b);
+		}
+	};
+
+} // namespace CaseFold
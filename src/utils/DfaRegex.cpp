@@ -0,0 +1,552 @@
+#include "DfaRegex.hpp"
+
+#include <algorithm>
+#include <cctype>
+
+// Upper bounds that keep compilation and the DFA cache small. Patterns that need
+// more NFA states are left to std::regex; a full DFA cache is simply rebuilt.
+static constexpr size_t kMaxNfaStates = 10000;
+static constexpr size_t kMaxDfaStates = 2048;
+static constexpr int kMaxRepeat = 1000;
+
+namespace {
+	using ByteSet = std::bitset<256>;
+
+	struct Node {
+		enum Kind { Set, Concat, Alt, Repeat, Begin, End } Type;
+		ByteSet Chars{};              // Set
+		std::vector<Node> Children{}; // Concat, Alt, Repeat (one child)
+		int Min = 0;
+		int Max = -1;                 // Repeat, -1 = unbounded
+	};
+
+	ByteSet RangeSet(unsigned char first, unsigned char last) {
+		ByteSet set;
+		for (unsigned c = first; c <= last; ++c) set.set(c);
+		return set;
+	}
+
+	ByteSet DigitSet() { return RangeSet('0', '9'); }
+
+	ByteSet WordSet() {
+		return RangeSet('a', 'z') | RangeSet('A', 'Z') | DigitSet() | RangeSet('_', '_');
+	}
+
+	ByteSet SpaceSet() {
+		ByteSet set;
+		for (char c : {' ', '\t', '\n', '\r', '\f', '\v'}) set.set(static_cast<unsigned char>(c));
+		return set;
+	}
+
+	void FoldCase(ByteSet &set) {
+		for (unsigned c = 'a'; c <= 'z'; ++c) {
+			const unsigned upper = c - 'a' + 'A';
+			if (set[c] || set[upper]) {
+				set.set(c);
+				set.set(upper);
+			}
+		}
+	}
+
+	int FirstOf(const ByteSet &set) {
+		for (int c = 0; c < 256; ++c) {
+			if (set[c]) return c;
+		}
+		return -1;
+	}
+
+	int HexValue(char c) {
+		if (c >= '0' && c <= '9') return c - '0';
+		if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+		if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+		return -1;
+	}
+} // namespace
+
+// Recursive descent parser producing the AST; any unsupported or malformed
+// construct fails the whole parse.
+class DfaRegex::Parser {
+public:
+	Parser(std::string_view pattern, bool ignoreCase)
+		: m_pattern(pattern), m_ignoreCase(ignoreCase) {}
+
+	std::optional<Node> Parse() {
+		auto node = ParseAlt();
+		if (!node || m_pos != m_pattern.size()) return std::nullopt;
+		return node;
+	}
+
+private:
+	bool AtEnd() const { return m_pos >= m_pattern.size(); }
+	char Peek() const { return m_pattern[m_pos]; }
+
+	Node MakeSet(ByteSet set) const {
+		if (m_ignoreCase) FoldCase(set);
+		return {Node::Set, set};
+	}
+
+	std::optional<Node> ParseAlt() {
+		Node alt{Node::Alt};
+		while (true) {
+			auto branch = ParseConcat();
+			if (!branch) return std::nullopt;
+			alt.Children.push_back(std::move(branch.value()));
+
+			if (AtEnd() || Peek() != '|') break;
+			++m_pos;
+		}
+
+		if (alt.Children.size() == 1) return std::move(alt.Children.front());
+		return alt;
+	}
+
+	std::optional<Node> ParseConcat() {
+		Node concat{Node::Concat};
+		while (!AtEnd() && Peek() != '|' && Peek() != ')') {
+			auto item = ParseRepeat();
+			if (!item) return std::nullopt;
+			concat.Children.push_back(std::move(item.value()));
+		}
+		return concat;
+	}
+
+	std::optional<Node> ParseRepeat() {
+		auto atom = ParseAtom();
+		if (!atom) return std::nullopt;
+
+		while (!AtEnd()) {
+			int min = 0, max = -1;
+			const char c = Peek();
+			if (c == '*') {
+				++m_pos;
+			} else if (c == '+') {
+				min = 1;
+				++m_pos;
+			} else if (c == '?') {
+				max = 1;
+				++m_pos;
+			} else if (c == '{') {
+				if (!ParseBounds(min, max)) return std::nullopt;
+			} else {
+				break;
+			}
+			// Lazy quantifiers change what is captured, not whether text matches.
+			if (!AtEnd() && Peek() == '?') ++m_pos;
+
+			if (atom->Type == Node::Begin || atom->Type == Node::End) return std::nullopt;
+			Node repeat{Node::Repeat};
+			repeat.Min = min;
+			repeat.Max = max;
+			repeat.Children.push_back(std::move(atom.value()));
+			atom = std::move(repeat);
+		}
+		return atom;
+	}
+
+	bool ParseBounds(int &min, int &max) {
+		++m_pos; // '{'
+		auto number = [this](int &value) {
+			const size_t start = m_pos;
+			value = 0;
+			while (!AtEnd() && std::isdigit(static_cast<unsigned char>(Peek()))) {
+				value = value * 10 + (Peek() - '0');
+				if (value > kMaxRepeat) return false;
+				++m_pos;
+			}
+			return m_pos > start;
+		};
+
+		if (!number(min)) return false;
+		max = min;
+		if (!AtEnd() && Peek() == ',') {
+			++m_pos;
+			max = -1;
+			if (!AtEnd() && Peek() != '}' && !number(max)) return false;
+		}
+		if (AtEnd() || Peek() != '}') return false;
+		++m_pos;
+		return max < 0 || max >= min;
+	}
+
+	std::optional<Node> ParseAtom() {
+		const char c = m_pattern[m_pos++];
+		switch (c) {
+		case '(': {
+			if (!AtEnd() && Peek() == '?') {
+				if (m_pattern.substr(m_pos, 2) != "?:") return std::nullopt; // Lookaround
+				m_pos += 2;
+			}
+			auto inner = ParseAlt();
+			if (!inner || AtEnd() || Peek() != ')') return std::nullopt;
+			++m_pos;
+			return inner;
+		}
+		case '[':
+			return ParseClass();
+		case '.': {
+			ByteSet any;
+			any.set();
+			any.reset('\n');
+			any.reset('\r');
+			return Node{Node::Set, any};
+		}
+		case '^':
+			return Node{Node::Begin};
+		case '$':
+			return Node{Node::End};
+		case '\\': {
+			ByteSet set;
+			if (!ParseEscape(set)) return std::nullopt;
+			return MakeSet(set);
+		}
+		case '*':
+		case '+':
+		case '?':
+		case '{':
+		case '}':
+		case ']':
+		case ')':
+			return std::nullopt; // Nothing to repeat, or unbalanced
+		default: {
+			ByteSet set;
+			set.set(static_cast<unsigned char>(c));
+			return MakeSet(set);
+		}
+		}
+	}
+
+	// Parses the escape after a backslash into set.
+	bool ParseEscape(ByteSet &set) {
+		if (AtEnd()) return false;
+		const char c = m_pattern[m_pos++];
+		switch (c) {
+		case 'd': set |= DigitSet(); return true;
+		case 'D': set |= ~DigitSet(); return true;
+		case 'w': set |= WordSet(); return true;
+		case 'W': set |= ~WordSet(); return true;
+		case 's': set |= SpaceSet(); return true;
+		case 'S': set |= ~SpaceSet(); return true;
+		case 'n': set.set('\n'); return true;
+		case 'r': set.set('\r'); return true;
+		case 't': set.set('\t'); return true;
+		case 'f': set.set('\f'); return true;
+		case 'v': set.set('\v'); return true;
+		case 'x': {
+			if (m_pos + 2 > m_pattern.size()) return false;
+			const int high = HexValue(m_pattern[m_pos]);
+			const int low = HexValue(m_pattern[m_pos + 1]);
+			if (high < 0 || low < 0) return false;
+			m_pos += 2;
+			set.set(static_cast<unsigned char>(high * 16 + low));
+			return true;
+		}
+		default:
+			// Backreferences, \b, \c, \u and friends are not supported.
+			if (std::isalnum(static_cast<unsigned char>(c))) return false;
+			set.set(static_cast<unsigned char>(c));
+			return true;
+		}
+	}
+
+	std::optional<Node> ParseClass() {
+		bool negate = false;
+		if (!AtEnd() && Peek() == '^') {
+			negate = true;
+			++m_pos;
+		}
+		// "[]" and "[^]" are ECMAScript oddities; leave them to std::regex.
+		if (AtEnd() || Peek() == ']') return std::nullopt;
+
+		ByteSet set;
+		while (!AtEnd() && Peek() != ']') {
+			if (m_pattern.substr(m_pos, 2) == "[:") return std::nullopt; // POSIX class
+
+			// A single character, or a class escape that can't start a range.
+			ByteSet item;
+			int first = -1;
+			if (Peek() == '\\') {
+				++m_pos;
+				if (!ParseEscape(item)) return std::nullopt;
+				if (item.count() == 1) first = static_cast<int>(FirstOf(item));
+			} else {
+				first = static_cast<unsigned char>(m_pattern[m_pos++]);
+				item.set(first);
+			}
+
+			const bool range = first >= 0 && m_pos + 1 < m_pattern.size() &&
+							   Peek() == '-' && m_pattern[m_pos + 1] != ']';
+			if (!range) {
+				set |= item;
+				continue;
+			}
+
+			++m_pos; // '-'
+			int last;
+			if (Peek() == '\\') {
+				++m_pos;
+				ByteSet end;
+				if (!ParseEscape(end) || end.count() != 1) return std::nullopt;
+				last = static_cast<int>(FirstOf(end));
+			} else {
+				last = static_cast<unsigned char>(m_pattern[m_pos++]);
+			}
+			if (last < first) return std::nullopt;
+			set |= RangeSet(static_cast<unsigned char>(first), static_cast<unsigned char>(last));
+		}
+		if (AtEnd()) return std::nullopt;
+		++m_pos; // ']'
+
+		if (m_ignoreCase) FoldCase(set);
+		if (negate) set.flip();
+		return Node{Node::Set, set};
+	}
+
+	std::string_view m_pattern;
+	size_t m_pos = 0;
+	bool m_ignoreCase;
+};
+
+// Thompson construction. Each node is emitted in front of the state that follows
+// it, so fragments never need patching.
+class DfaRegex::Builder {
+public:
+	explicit Builder(DfaRegex &regex) : m_regex(regex) {}
+
+	std::optional<uint32_t> Build(const Node &root) {
+		const uint32_t match = Add({NfaState::Match});
+		return Emit(root, match);
+	}
+
+private:
+	uint32_t Add(NfaState state) {
+		m_regex.m_nfa.push_back(state);
+		return static_cast<uint32_t>(m_regex.m_nfa.size() - 1);
+	}
+
+	std::optional<uint32_t> Emit(const Node &node, uint32_t next) {
+		if (m_regex.m_nfa.size() > kMaxNfaStates) return std::nullopt;
+
+		switch (node.Type) {
+		case Node::Set: {
+			m_regex.m_sets.push_back(node.Chars);
+			NfaState state{NfaState::Byte, next};
+			state.Set = static_cast<uint32_t>(m_regex.m_sets.size() - 1);
+			return Add(state);
+		}
+		case Node::Begin:
+			return Add({NfaState::Begin, next});
+		case Node::End:
+			return Add({NfaState::End, next});
+		case Node::Concat: {
+			uint32_t start = next;
+			for (auto it = node.Children.rbegin(); it != node.Children.rend(); ++it) {
+				auto emitted = Emit(*it, start);
+				if (!emitted) return std::nullopt;
+				start = emitted.value();
+			}
+			return start;
+		}
+		case Node::Alt: {
+			auto start = Emit(node.Children.back(), next);
+			for (size_t i = node.Children.size() - 1; start && i-- > 0;) {
+				auto branch = Emit(node.Children[i], next);
+				if (!branch) return std::nullopt;
+				start = Add({NfaState::Split, branch.value(), start.value()});
+			}
+			return start;
+		}
+		case Node::Repeat: {
+			const Node &child = node.Children.front();
+			std::optional<uint32_t> start = next;
+			if (node.Max < 0) {
+				// Loop: split into one more iteration or on to next.
+				const uint32_t loop = Add({NfaState::Split});
+				auto body = Emit(child, loop);
+				if (!body) return std::nullopt;
+				m_regex.m_nfa[loop].Out = body.value();
+				m_regex.m_nfa[loop].Out1 = next;
+				start = loop;
+			} else {
+				// Optional copies; skipping one skips the rest.
+				for (int i = node.Min; start && i < node.Max; ++i) {
+					auto body = Emit(child, start.value());
+					if (!body) return std::nullopt;
+					start = Add({NfaState::Split, body.value(), next});
+				}
+			}
+			for (int i = 0; start && i < node.Min; ++i) {
+				start = Emit(child, start.value());
+			}
+			return start;
+		}
+		}
+		return std::nullopt;
+	}
+
+	DfaRegex &m_regex;
+};
+
+DfaRegex::DfaRegex() : m_shared(std::make_unique<Shared>()) {}
+
+std::optional<DfaRegex> DfaRegex::Compile(std::string_view pattern, bool ignoreCase) {
+	auto root = Parser(pattern, ignoreCase).Parse();
+	if (!root) return std::nullopt;
+
+	DfaRegex regex;
+	auto start = Builder(regex).Build(root.value());
+	if (!start) return std::nullopt;
+	regex.m_start = start.value();
+
+	// With nothing to restart from past position 0, an empty state can't recover.
+	bool match;
+	regex.m_anchored = regex.Closure({regex.m_start}, false, false, match).empty();
+	regex.m_shared->Current = regex.NewCache();
+	return regex;
+}
+
+std::vector<uint32_t> DfaRegex::Closure(
+	std::vector<uint32_t> seeds, bool atStart, bool atEnd, bool &match
+) const {
+	std::vector<uint32_t> states;
+	std::vector<bool> seen(m_nfa.size());
+	match = false;
+
+	while (!seeds.empty()) {
+		const uint32_t id = seeds.back();
+		seeds.pop_back();
+		if (seen[id]) continue;
+		seen[id] = true;
+
+		const NfaState &state = m_nfa[id];
+		switch (state.Type) {
+		case NfaState::Byte:
+			states.push_back(id);
+			break;
+		case NfaState::Split:
+			seeds.push_back(state.Out1);
+			seeds.push_back(state.Out);
+			break;
+		case NfaState::Begin:
+			if (atStart) seeds.push_back(state.Out);
+			break;
+		case NfaState::End:
+			// Kept pending until the end of the text is known.
+			if (atEnd) {
+				seeds.push_back(state.Out);
+			} else {
+				states.push_back(id);
+			}
+			break;
+		case NfaState::Match:
+			// Part of the set, so matching and non-matching states never share a key.
+			states.push_back(id);
+			match = true;
+			break;
+		}
+	}
+
+	std::sort(states.begin(), states.end());
+	return states;
+}
+
+std::shared_ptr<DfaRegex::Cache> DfaRegex::NewCache() const {
+	auto cache = std::make_shared<Cache>();
+	cache->States.resize(kMaxDfaStates);
+
+	// The start state sees '^' satisfied, so it's kept out of the index where a
+	// later position could reuse it.
+	auto start = std::make_unique<DfaState>();
+	start->Nfa = Closure({m_start}, true, false, start->Match);
+	for (auto &next : start->Next) {
+		next.store(-1, std::memory_order_relaxed);
+	}
+	cache->States[kStart] = std::move(start);
+	cache->Count = 1;
+	return cache;
+}
+
+int32_t DfaRegex::Intern(Cache &cache, std::vector<uint32_t> nfa, bool match) {
+	auto it = cache.Index.find(nfa);
+	if (it != cache.Index.end()) return it->second;
+
+	auto state = std::make_unique<DfaState>();
+	state->Nfa = nfa;
+	state->Match = match;
+	for (auto &next : state->Next) {
+		next.store(-1, std::memory_order_relaxed);
+	}
+
+	const auto id = static_cast<int32_t>(cache.Count++);
+	cache.States[id] = std::move(state);
+	cache.Index.emplace(std::move(nfa), id);
+	return id;
+}
+
+int32_t DfaRegex::Step(std::shared_ptr<Cache> &cache, int32_t state, uint8_t byte) const {
+	std::lock_guard lock(m_shared->Mutex);
+
+	// Another search may have built the transition while this one waited.
+	DfaState &from = *cache->States[state];
+	const int32_t built = from.Next[byte].load(std::memory_order_acquire);
+	if (built >= 0) return built;
+
+	// Every position may start a match, so the start state is folded into each
+	// step; for patterns anchored with '^' it contributes nothing.
+	std::vector<uint32_t> seeds{m_start};
+	for (uint32_t id : from.Nfa) {
+		const NfaState &nfa = m_nfa[id];
+		if (nfa.Type == NfaState::Byte && m_sets[nfa.Set][byte]) seeds.push_back(nfa.Out);
+	}
+	bool match;
+	auto next = Closure(std::move(seeds), false, false, match);
+
+	std::shared_ptr<Cache> current = m_shared->Current.load();
+	if (current->Count >= kMaxDfaStates) {
+		// Start over rather than grow without bound.
+		current = NewCache();
+		m_shared->Current.store(current);
+	}
+	if (current != cache) {
+		// The search carries on in the newer cache; its state can't link into it.
+		cache = std::move(current);
+		return Intern(*cache, std::move(next), match);
+	}
+
+	const int32_t id = Intern(*cache, std::move(next), match);
+	from.Next[byte].store(id, std::memory_order_release);
+	return id;
+}
+
+bool DfaRegex::MatchesAtEnd(DfaState &state, bool atStart) const {
+	// Racing searches compute the same answer, so no lock is needed to cache it.
+	int8_t known = state.MatchAtEnd.load(std::memory_order_relaxed);
+	if (known < 0) {
+		std::vector<uint32_t> seeds;
+		for (uint32_t id : state.Nfa) {
+			if (m_nfa[id].Type == NfaState::End) seeds.push_back(m_nfa[id].Out);
+		}
+		bool match;
+		Closure(std::move(seeds), atStart, true, match);
+		known = match ? 1 : 0;
+		state.MatchAtEnd.store(known, std::memory_order_relaxed);
+	}
+	return known == 1;
+}
+
+bool DfaRegex::Search(std::string_view text) const {
+	std::shared_ptr<Cache> cache = m_shared->Current.load();
+
+	int32_t state = kStart;
+	for (char c : text) {
+		DfaState &dfa = *cache->States[state];
+		if (dfa.Match) return true;
+		if (m_anchored && dfa.Nfa.empty()) return false;
+
+		const auto byte = static_cast<uint8_t>(c);
+		const int32_t next = dfa.Next[byte].load(std::memory_order_acquire);
+		state = next >= 0 ? next : Step(cache, state, byte);
+	}
+
+	DfaState &dfa = *cache->States[state];
+	return dfa.Match || MatchesAtEnd(dfa, state == kStart);
+}
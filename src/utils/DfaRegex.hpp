@@ -0,0 +1,92 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bitset>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Linear-time regex search over bytes: the pattern is compiled into a
+ *        Thompson NFA, which is run as a DFA built lazily, one state per new set
+ *        of NFA states. Every input byte is a table lookup once the states are hot,
+ *        and no pattern can make a search backtrack.
+ *
+ *        Supports the ECMAScript subset used for address filters: literals, '.',
+ *        classes ([a-z], [^...], \d \w \s and negations), groups, '|', '^', '$'
+ *        and the * + ? {m,n} quantifiers (lazy forms match the same strings).
+ *        Backreferences, lookarounds and word boundaries are rejected, so callers
+ *        can fall back to std::regex for those. Search() is thread-safe: built
+ *        states are read without locking, and a lock is only taken to build one.
+ */
+class DfaRegex {
+public:
+	/**
+	 * @brief Compile a pattern; nullopt when it's invalid or outside the subset.
+	 */
+	static std::optional<DfaRegex> Compile(std::string_view pattern, bool ignoreCase);
+
+	/**
+	 * @brief True when the pattern matches anywhere in text (like std::regex_search).
+	 */
+	bool Search(std::string_view text) const;
+
+private:
+	using ByteSet = std::bitset<256>;
+
+	struct NfaState {
+		enum Kind : uint8_t { Byte, Split, Begin, End, Match } Type;
+		uint32_t Out = 0;
+		uint32_t Out1 = 0;     // Second branch of a Split
+		uint32_t Set = 0;      // Index into m_sets for Byte states
+	};
+
+	// Nfa and Match are fixed at creation; the atomics are filled in as searches
+	// reach them.
+	struct DfaState {
+		std::vector<uint32_t> Nfa; // Byte, End and Match states, sorted
+		bool Match = false;
+		std::atomic<int8_t> MatchAtEnd = -1;        // -1 until first needed
+		std::array<std::atomic<int32_t>, 256> Next; // -1 until built
+	};
+
+	// One generation of the lazily built DFA. States never move once added, and a
+	// transition is published only after its target state is complete.
+	struct Cache {
+		std::vector<std::unique_ptr<DfaState>> States; // kMaxDfaStates slots
+		size_t Count = 0;                               // Guarded by Shared::Mutex
+		std::map<std::vector<uint32_t>, int32_t> Index; // Guarded by Shared::Mutex
+	};
+
+	// Shared by all searches. A full cache is replaced rather than cleared; searches
+	// still walking the old one keep it alive.
+	struct Shared {
+		std::mutex Mutex; // Taken only to build a missing state
+		std::atomic<std::shared_ptr<Cache>> Current;
+	};
+
+	static constexpr int32_t kStart = 0; // Start state of every cache
+
+	class Parser;
+	class Builder;
+
+	DfaRegex();
+
+	std::vector<uint32_t> Closure(std::vector<uint32_t> seeds, bool atStart, bool atEnd,
+								  bool &match) const;
+	std::shared_ptr<Cache> NewCache() const;
+	static int32_t Intern(Cache &cache, std::vector<uint32_t> nfa, bool match);
+	int32_t Step(std::shared_ptr<Cache> &cache, int32_t state, uint8_t byte) const;
+	bool MatchesAtEnd(DfaState &state, bool atStart) const;
+
+	std::vector<NfaState> m_nfa;
+	std::vector<ByteSet> m_sets;
+	uint32_t m_start = 0;
+	bool m_anchored = false; // Every match starts at position 0
+	std::unique_ptr<Shared> m_shared;
+};
@@ -0,0 +1,315 @@
+#include "FilterExpr.hpp"
+
+#include <format>
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <optional>
+
+#include "CaseFold.hpp"
+#include "StringUtils.hpp"
+
+namespace {
+	bool IsWordChar(char c) {
+		return !std::isspace(static_cast<unsigned char>(c)) &&
+			   std::string_view("()!=<>~&|\"'").find(c) == std::string_view::npos;
+	}
+
+	char FoldText(char c) {
+		if (c == ' ') return '_';
+		return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+	}
+
+	bool TextEquals(std::string_view a, std::string_view b) {
+		if (a.size() != b.size()) return false;
+		return std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+			return FoldText(x) == FoldText(y);
+		});
+	}
+
+	// Parses "12", "1.5", "500MB", "2g" (binary units); nullopt for anything else.
+	std::optional<double> ParseNumber(std::string_view word) {
+		double value = 0;
+		auto [end, ec] = std::from_chars(word.data(), word.data() + word.size(), value);
+		if (ec != std::errc() || end == word.data()) return std::nullopt;
+
+		std::string unit(end, word.data() + word.size());
+		std::transform(unit.begin(), unit.end(), unit.begin(), [](unsigned char c) {
+			return static_cast<char>(std::tolower(c));
+		});
+		if (unit.empty() || unit == "b") return value;
+		if (unit == "k" || unit == "kb") return value * 1024;
+		if (unit == "m" || unit == "mb") return value * 1024 * 1024;
+		if (unit == "g" || unit == "gb") return value * 1024 * 1024 * 1024;
+		return std::nullopt;
+	}
+} // namespace
+
+// Recursive descent over the expression, emitting code as it goes. Every
+// subexpression leaves its result in the accumulator; && and || jump over the
+// right-hand side once the left-hand side decides the outcome.
+class FilterProgram::Compiler {
+public:
+	Compiler(
+		std::string_view expr, std::span<const FilterColumn> columns, FilterProgram &out
+	)
+		: m_expr(expr), m_columns(columns), m_out(out) {}
+
+	std::optional<std::string> Run() {
+		Or();
+		if (!m_error && Skip() < m_expr.size()) Fail("unexpected input");
+		return m_error;
+	}
+
+private:
+	size_t Skip() {
+		while (m_pos < m_expr.size() &&
+			   std::isspace(static_cast<unsigned char>(m_expr[m_pos]))) {
+			++m_pos;
+		}
+		return m_pos;
+	}
+
+	bool Accept(std::string_view token) {
+		if (m_expr.substr(Skip(), token.size()) != token) return false;
+		m_pos += token.size();
+		return true;
+	}
+
+	void Fail(std::string_view what) {
+		if (!m_error) {
+			m_error = std::format("{} at position {} in \"{}\"", what, m_pos + 1, m_expr);
+		}
+	}
+
+	uint32_t Emit(Instr instr) {
+		m_out.m_code.push_back(instr);
+		return static_cast<uint32_t>(m_out.m_code.size() - 1);
+	}
+
+	void Patch(const std::vector<uint32_t> &jumps) {
+		for (uint32_t at : jumps) {
+			m_out.m_code[at].Operand = static_cast<uint32_t>(m_out.m_code.size());
+		}
+	}
+
+	void Or() {
+		std::vector<uint32_t> jumps;
+		And();
+		while (!m_error && Accept("||")) {
+			jumps.push_back(Emit({Op::JumpIfTrue}));
+			And();
+		}
+		Patch(jumps);
+	}
+
+	void And() {
+		std::vector<uint32_t> jumps;
+		Unary();
+		while (!m_error && Accept("&&")) {
+			jumps.push_back(Emit({Op::JumpIfFalse}));
+			Unary();
+		}
+		Patch(jumps);
+	}
+
+	void Unary() {
+		if (Accept("!")) {
+			if (m_expr.substr(m_pos, 1) == "=") return Fail("expected a column");
+			Unary();
+			Emit({Op::Not});
+			return;
+		}
+		if (Accept("(")) {
+			Or();
+			if (!m_error && !Accept(")")) Fail("expected ')'");
+			return;
+		}
+		Comparison();
+	}
+
+	std::string_view Word() {
+		const size_t start = Skip();
+		while (m_pos < m_expr.size() && IsWordChar(m_expr[m_pos])) ++m_pos;
+		return m_expr.substr(start, m_pos - start);
+	}
+
+	// A quoted string or a bare word; nullopt when neither is there.
+	std::optional<std::string> Value() {
+		const size_t start = Skip();
+		if (start < m_expr.size() && (m_expr[start] == '"' || m_expr[start] == '\'')) {
+			const size_t close = m_expr.find(m_expr[start], start + 1);
+			if (close == std::string_view::npos) {
+				Fail("unterminated string");
+				return std::nullopt;
+			}
+			m_pos = close + 1;
+			return std::string(m_expr.substr(start + 1, close - start - 1));
+		}
+		std::string_view word = Word();
+		if (word.empty()) return std::nullopt;
+		return std::string(word);
+	}
+
+	void Comparison() {
+		const size_t columnPos = Skip();
+		const std::string_view name = Word();
+		if (name.empty()) return Fail("expected a column");
+
+		auto it = std::find_if(m_columns.begin(), m_columns.end(), [name](const auto &c) {
+			return TextEquals(c.Name, name);
+		});
+		if (it == m_columns.end()) {
+			std::string known;
+			for (const auto &c : m_columns) {
+				known += known.empty() ? "" : ", ";
+				known += c.Name;
+			}
+			m_pos = columnPos;
+			return Fail(std::format("unknown column '{}' (columns: {})", name, known));
+		}
+		const FilterColumn &column = *it;
+		const auto index = static_cast<uint16_t>(it - m_columns.begin());
+
+		Cmp cmp;
+		bool regex = false;
+		if (Accept("==") || Accept("=")) {
+			cmp = Cmp::Eq;
+		} else if (Accept("!=")) {
+			cmp = Cmp::Ne;
+		} else if (Accept("<=")) {
+			cmp = Cmp::Le;
+		} else if (Accept(">=")) {
+			cmp = Cmp::Ge;
+		} else if (Accept("<")) {
+			cmp = Cmp::Lt;
+		} else if (Accept(">")) {
+			cmp = Cmp::Gt;
+		} else if (Accept("~")) {
+			cmp = Cmp::Eq;
+			regex = true;
+		} else {
+			// Bare column: true when non-zero.
+			if (!column.Numeric) {
+				return Fail(std::format("'{}' needs a comparison", name));
+			}
+			Emit({Op::Truthy, Cmp::Eq, index});
+			return;
+		}
+
+		const size_t valuePos = Skip();
+		auto value = Value();
+		if (m_error) return;
+		if (!value) return Fail("expected a value");
+
+		if (regex) {
+			if (!column.Textual) {
+				return Fail(std::format("'{}' is not a text column", name));
+			}
+			auto compiled = DfaRegex::Compile(value.value(), true);
+			if (!compiled) {
+				m_pos = valuePos;
+				return Fail("unsupported or invalid regex");
+			}
+			m_out.m_regexes.push_back(std::move(compiled.value()));
+			const auto slot = static_cast<uint32_t>(m_out.m_regexes.size() - 1);
+			Emit({Op::Match, cmp, index, slot});
+			return;
+		}
+
+		// Numbers go to the numeric side of a column when it has one; words and
+		// quoted strings to the text side.
+		const auto number = column.Numeric ? ParseNumber(value.value()) : std::nullopt;
+		if (number) {
+			m_out.m_numbers.push_back(number.value());
+			const auto slot = static_cast<uint32_t>(m_out.m_numbers.size() - 1);
+			Emit({Op::CmpNumber, cmp, index, slot});
+			return;
+		}
+
+		if (!column.Textual || (cmp != Cmp::Eq && cmp != Cmp::Ne)) {
+			m_pos = valuePos;
+			if (!column.Textual) return Fail(std::format("'{}' needs a number", name));
+			return Fail(std::format("'{}' only supports ==, != and ~ with text", name));
+		}
+		if (column.Wide) {
+			m_out.m_wideTexts.push_back(StringUtils::ArgToWstring(value.value()));
+			const auto slot = static_cast<uint32_t>(m_out.m_wideTexts.size() - 1);
+			Emit({Op::CmpWide, cmp, index, slot});
+			return;
+		}
+		m_out.m_texts.push_back(std::move(value.value()));
+		const auto slot = static_cast<uint32_t>(m_out.m_texts.size() - 1);
+		Emit({Op::CmpText, cmp, index, slot});
+	}
+
+	std::string_view m_expr;
+	std::span<const FilterColumn> m_columns;
+	FilterProgram &m_out;
+	size_t m_pos = 0;
+	std::optional<std::string> m_error;
+};
+
+Result<FilterProgram, Error>
+FilterProgram::Compile(std::string_view expr, std::span<const FilterColumn> columns) {
+	FilterProgram program;
+	if (auto error = Compiler(expr, columns, program).Run()) {
+		return Error(std::format("Invalid filter: {}", error.value()));
+	}
+	return program;
+}
+
+bool FilterProgram::Evaluate(FilterRow &row) const {
+	bool acc = false;
+	for (size_t pc = 0; pc < m_code.size(); ++pc) {
+		const Instr &in = m_code[pc];
+		switch (in.Code) {
+		case Op::CmpNumber: {
+			const double lhs = row.Number(in.Column);
+			const double rhs = m_numbers[in.Operand];
+			switch (in.Compare) {
+			case Cmp::Eq: acc = lhs == rhs; break;
+			case Cmp::Ne: acc = lhs != rhs; break;
+			case Cmp::Lt: acc = lhs < rhs; break;
+			case Cmp::Le: acc = lhs <= rhs; break;
+			case Cmp::Gt: acc = lhs > rhs; break;
+			case Cmp::Ge: acc = lhs >= rhs; break;
+			}
+			break;
+		}
+		case Op::CmpText:
+			acc = TextEquals(row.Text(in.Column), m_texts[in.Operand]);
+			if (in.Compare == Cmp::Ne) acc = !acc;
+			break;
+		case Op::CmpWide:
+			acc = CaseFold::Equals(row.WideText(in.Column), m_wideTexts[in.Operand]);
+			if (in.Compare == Cmp::Ne) acc = !acc;
+			break;
+		case Op::Match:
+			acc = m_regexes[in.Operand].Search(row.Text(in.Column));
+			break;
+		case Op::Truthy:
+			acc = row.Number(in.Column) != 0;
+			break;
+		case Op::Not:
+			acc = !acc;
+			break;
+		case Op::JumpIfFalse:
+			if (!acc) pc = in.Operand - 1;
+			break;
+		case Op::JumpIfTrue:
+			if (acc) pc = in.Operand - 1;
+			break;
+		}
+	}
+	return acc;
+}
+
+bool FilterProgram::References(size_t column) const {
+	return std::any_of(m_code.begin(), m_code.end(), [column](const Instr &in) {
+		const bool reads = in.Code == Op::CmpNumber || in.Code == Op::CmpText ||
+						   in.Code == Op::CmpWide || in.Code == Op::Match ||
+						   in.Code == Op::Truthy;
+		return reads && in.Column == column;
+	});
+}
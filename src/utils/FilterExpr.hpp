@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Result.hpp"
+#include "Error.hpp"
+#include "DfaRegex.hpp"
+
+struct FilterColumn {
+	std::string_view Name;
+	bool Numeric;      // Compared against numbers (sizes like 500MB allowed)
+	bool Textual;      // Compared against words and quoted strings
+	bool Wide = false; // == and != read FilterRow::WideText, compared with CaseFold
+};
+
+/**
+ * @brief One row as seen by a filter. Columns are requested by index into the
+ *        schema, and only when the program reaches them, so expensive columns
+ *        can be computed on demand. Returned text must outlive the evaluation.
+ */
+class FilterRow {
+public:
+	virtual ~FilterRow() = default;
+	virtual double Number(size_t column) = 0;
+	virtual std::string_view Text(size_t column) = 0;
+	virtual std::wstring_view WideText(size_t /*column*/) { return {}; }
+};
+
+/**
+ * @brief Filter expression compiled to bytecode, e.g.
+ *          mem > 500MB && (prio == high || name ~ "^svc") && !suspended
+ *        Comparisons: == != < <= > >= and ~ (regex). A bare column is true when
+ *        non-zero. Text compares case-insensitively, with ' ' and '_' alike, so
+ *        "below_normal" matches "Below normal"; Wide columns compare the native
+ *        UTF-16 text with CaseFold instead, so non-ASCII letters ignore case too
+ *        and rows need no conversion. && and || short-circuit, so
+ *        columns behind a failed test are never fetched.
+ */
+class FilterProgram {
+public:
+	/**
+	 * @brief Compile an expression against a column schema. Errors point at the
+	 *        offending position.
+	 */
+	static Result<FilterProgram, Error>
+	Compile(std::string_view expr, std::span<const FilterColumn> columns);
+
+	bool Evaluate(FilterRow &row) const;
+
+	/**
+	 * @brief True when the program reads the column, so callers can prefetch it.
+	 */
+	bool References(size_t column) const;
+
+private:
+	enum class Op : uint8_t {
+		CmpNumber,   // acc = Number(Column) <Cmp> m_numbers[Operand]
+		CmpText,     // acc = Text(Column) <Cmp> m_texts[Operand]
+		CmpWide,     // acc = WideText(Column) <Cmp> m_wideTexts[Operand]
+		Match,       // acc = m_regexes[Operand] matches Text(Column)
+		Truthy,      // acc = Number(Column) != 0
+		Not,         // acc = !acc
+		JumpIfFalse, // if (!acc) pc = Operand
+		JumpIfTrue,  // if (acc) pc = Operand
+	};
+
+	enum class Cmp : uint8_t { Eq, Ne, Lt, Le, Gt, Ge };
+
+	struct Instr {
+		Op Code;
+		Cmp Compare = Cmp::Eq;
+		uint16_t Column = 0;
+		uint32_t Operand = 0;
+	};
+
+	class Compiler;
+
+	std::vector<Instr> m_code;
+	std::vector<double> m_numbers;
+	std::vector<std::string> m_texts;
+	std::vector<std::wstring> m_wideTexts;
+	std::vector<DfaRegex> m_regexes;
+};
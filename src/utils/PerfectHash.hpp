@@ -0,0 +1,119 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+/**
+ * @brief Compile-time perfect hashing for small keyword tables, e.g. priority
+ *        names. Keys are matched the way StringUtils::Normalize compares them
+ *        (ASCII case-insensitive, whitespace equal to '_'), but the input is
+ *        folded while hashing, so a lookup never allocates.
+ */
+namespace PerfectHash {
+	constexpr char Fold(char c) {
+		if (c >= 'A' && c <= 'Z') return static_cast<char>(c - 'A' + 'a');
+		if (c == ' ' || (c >= '\t' && c <= '\r')) return '_';
+		return c;
+	}
+
+	/**
+	 * @brief True when both strings are equal after folding.
+	 */
+	constexpr bool Equals(std::string_view a, std::string_view b) {
+		if (a.size() != b.size()) return false;
+		for (size_t i = 0; i < a.size(); ++i) {
+			if (Fold(a[i]) != Fold(b[i])) return false;
+		}
+		return true;
+	}
+
+	template <typename T> struct Entry {
+		std::string_view Key;
+		T Value;
+	};
+
+	template <typename T, size_t N> class Map {
+	public:
+		// Twice as many slots as keys, rounded up to a power of two, so a seed
+		// that separates every key is found after a few tries.
+		static constexpr size_t Slots = std::bit_ceil(N * 2);
+
+		consteval explicit Map(const Entry<T> (&entries)[N]) {
+			static_assert(N > 0 && N < Empty, "Key count out of range");
+			for (size_t i = 0; i < N; ++i) {
+				for (char c : entries[i].Key) {
+					if (Fold(c) != c) throw "Keys must be lowercase, with '_' for spaces";
+				}
+				m_entries[i] = entries[i];
+				m_maxLength = (std::max)(m_maxLength, entries[i].Key.size());
+			}
+
+			for (uint32_t seed = 1; seed < 100000; ++seed) {
+				if (TrySeed(seed)) return;
+			}
+			throw "No perfect hash seed found for these keys";
+		}
+
+		/**
+		 * @brief Value for the key equal to text after folding; one hash, one compare.
+		 */
+		constexpr std::optional<T> Find(std::string_view text) const {
+			if (text.empty() || text.size() > m_maxLength) return std::nullopt;
+
+			const uint8_t index = m_slots[Slot(text, m_seed)];
+			if (index == Empty) return std::nullopt;
+
+			// Keys are stored folded, so only the input needs folding.
+			const std::string_view key = m_entries[index].Key;
+			if (text.size() != key.size()) return std::nullopt;
+			for (size_t i = 0; i < key.size(); ++i) {
+				if (Fold(text[i]) != key[i]) return std::nullopt;
+			}
+			return m_entries[index].Value;
+		}
+
+	private:
+		static constexpr uint8_t Empty = 0xFF;
+
+		// Hashes only the length and the first, middle and last characters, so the
+		// cost doesn't grow with the input; the full compare in Find() settles it.
+		// Keys that agree on all four can't be separated and fail to compile.
+		static constexpr size_t Slot(std::string_view text, uint32_t seed) {
+			uint32_t hash = (2166136261u ^ (seed * 0x9E3779B9u)) + text.size();
+			for (char c : {text.front(), text[text.size() / 2], text.back()}) {
+				hash = (hash ^ static_cast<uint8_t>(Fold(c))) * 16777619u;
+			}
+			hash ^= hash >> 15;
+			return hash & (Slots - 1);
+		}
+
+		constexpr bool TrySeed(uint32_t seed) {
+			m_slots.fill(Empty);
+			for (size_t i = 0; i < N; ++i) {
+				const size_t slot = Slot(m_entries[i].Key, seed);
+				if (m_slots[slot] != Empty) return false;
+				m_slots[slot] = static_cast<uint8_t>(i);
+			}
+			m_seed = seed;
+			return true;
+		}
+
+		std::array<Entry<T>, N> m_entries{};
+		std::array<uint8_t, Slots> m_slots{};
+		size_t m_maxLength = 0;
+		uint32_t m_seed = 0;
+	};
+
+	/**
+	 * @brief Build a table at compile time: PerfectHash::Make<int>({{"idle", 1}, ...}).
+	 */
+	template <typename T, size_t N>
+	consteval Map<T, N> Make(const Entry<T> (&entries)[N]) {
+		return Map<T, N>(entries);
+	}
+} // namespace PerfectHash
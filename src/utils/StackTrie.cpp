@@ -0,0 +1,136 @@
+#include "StackTrie.hpp"
+
+#include <unordered_set>
+
+StackTrie::StackTrie() {
+	m_nodes.push_back({0}); // Root, holds no frame
+}
+
+size_t StackTrie::EdgeHash::operator()(const std::pair<uint32_t, Frame> &edge
+) const noexcept {
+	size_t h = std::hash<Frame>{}(edge.second);
+	return h ^ (edge.first + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2));
+}
+
+uint64_t StackTrie::HashStack(std::span<const Frame> stack) {
+	uint64_t h = stack.size();
+	for (Frame frame : stack) {
+		h = (h ^ frame) * 0x9e3779b97f4a7c15ull;
+		h ^= h >> 29;
+	}
+	return h;
+}
+
+uint32_t StackTrie::Child(uint32_t parent, Frame frame) {
+	auto [it, inserted] =
+		m_edges.try_emplace({parent, frame}, static_cast<uint32_t>(m_nodes.size()));
+	if (inserted) {
+		Node node{frame, parent};
+		node.NextSibling = m_nodes[parent].FirstChild;
+		m_nodes[parent].FirstChild = it->second;
+		m_nodes.push_back(node);
+	}
+	return it->second;
+}
+
+bool StackTrie::EndsAt(uint32_t node, std::span<const Frame> stack) const {
+	for (size_t i = stack.size(); i-- > 0; node = m_nodes[node].Parent) {
+		if (node == kRoot || m_nodes[node].Value != stack[i]) return false;
+	}
+	return node == kRoot;
+}
+
+void StackTrie::Add(std::span<const Frame> stack, uint64_t count) {
+	if (stack.empty() || count == 0) return;
+
+	// Samples mostly repeat stacks seen before. Find the node by a hash of the
+	// whole stack and confirm it through the parent links, rather than looking up
+	// one edge per frame; a collision just falls back to the walk.
+	const uint64_t hash = HashStack(stack);
+	auto [it, inserted] = m_stacks.try_emplace(hash, kRoot);
+	uint32_t node = it->second;
+	if (inserted || !EndsAt(node, stack)) {
+		node = kRoot;
+		for (Frame frame : stack) {
+			node = Child(node, frame);
+		}
+		it->second = node;
+	}
+	m_nodes[node].Self += count;
+	m_total += count;
+}
+
+std::vector<StackTrie::Frame> StackTrie::Frames() const {
+	std::unordered_set<Frame> seen;
+	std::vector<Frame> frames;
+	for (size_t i = 1; i < m_nodes.size(); ++i) {
+		if (seen.insert(m_nodes[i].Value).second) frames.push_back(m_nodes[i].Value);
+	}
+	return frames;
+}
+
+void StackTrie::ForEachStack(
+	const std::function<void(std::span<const Frame>, uint64_t)> &visit
+) const {
+	// Iterative depth-first walk; path holds the frames from the root down.
+	std::vector<Frame> path;
+	std::vector<uint32_t> pending; // Next sibling to visit at each depth
+
+	uint32_t node = m_nodes[kRoot].FirstChild;
+	while (node != kNone) {
+		path.push_back(m_nodes[node].Value);
+		if (m_nodes[node].Self > 0) visit(path, m_nodes[node].Self);
+
+		if (m_nodes[node].FirstChild != kNone) {
+			pending.push_back(m_nodes[node].NextSibling);
+			node = m_nodes[node].FirstChild;
+			continue;
+		}
+
+		// Leaf: climb until a level still has a sibling left.
+		path.pop_back();
+		node = m_nodes[node].NextSibling;
+		while (node == kNone && !pending.empty()) {
+			node = pending.back();
+			pending.pop_back();
+			path.pop_back();
+		}
+	}
+}
+
+StackTrie StackTrie::Map(const std::function<Frame(Frame)> &map) const {
+	std::unordered_map<Frame, Frame> mapped;
+	for (Frame frame : Frames()) {
+		mapped.emplace(frame, map(frame));
+	}
+
+	StackTrie result;
+	std::vector<Frame> stack;
+	ForEachStack([&](std::span<const Frame> frames, uint64_t count) {
+		stack.clear();
+		for (Frame frame : frames) {
+			stack.push_back(mapped[frame]);
+		}
+		result.Add(stack, count);
+	});
+	return result;
+}
+
+std::string StackTrie::Fold(const std::function<std::string(Frame)> &name) const {
+	std::unordered_map<Frame, std::string> names;
+	for (Frame frame : Frames()) {
+		names.emplace(frame, name(frame));
+	}
+
+	std::string folded;
+	ForEachStack([&](std::span<const Frame> stack, uint64_t count) {
+		for (size_t i = 0; i < stack.size(); ++i) {
+			if (i > 0) folded += ';';
+			folded += names[stack[i]];
+		}
+		folded += ' ';
+		folded += std::to_string(count);
+		folded += '\n';
+	});
+	return folded;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Call stacks aggregated into a prefix tree of frames with sample counts.
+ *        Stacks sharing a caller chain share nodes, so memory grows with distinct
+ *        call paths, not with samples. Frames are opaque 64-bit values (addresses);
+ *        names are only needed when folding. Not thread-safe.
+ */
+class StackTrie {
+public:
+	using Frame = uint64_t;
+
+	StackTrie();
+
+	/**
+	 * @brief Count a stack, ordered from the outermost caller to the leaf.
+	 */
+	void Add(std::span<const Frame> stack, uint64_t count = 1);
+
+	uint64_t TotalSamples() const { return m_total; }
+	size_t NodeCount() const { return m_nodes.size() - 1; }
+
+	/**
+	 * @brief Distinct frames in the trie, to resolve their names in one batch.
+	 */
+	std::vector<Frame> Frames() const;
+
+	/**
+	 * @brief Call visit(stack, count) for every stack that ended in a leaf sample,
+	 *        depth first. The span is only valid during the call.
+	 */
+	void ForEachStack(const std::function<void(std::span<const Frame>, uint64_t)> &visit
+	) const;
+
+	/**
+	 * @brief Copy of the trie with every frame replaced by map(frame). Stacks that
+	 *        become equal are merged and their counts added, e.g. to aggregate
+	 *        program counters by the function they belong to.
+	 */
+	StackTrie Map(const std::function<Frame(Frame)> &map) const;
+
+	/**
+	 * @brief Render folded stacks ("root;caller;leaf count" per line), the input
+	 *        format of flame graph tools.
+	 */
+	std::string Fold(const std::function<std::string(Frame)> &name) const;
+
+private:
+	static constexpr uint32_t kRoot = 0;
+	static constexpr uint32_t kNone = UINT32_MAX;
+
+	struct Node {
+		Frame Value;
+		uint32_t Parent = kRoot;
+		uint32_t FirstChild = kNone;
+		uint32_t NextSibling = kNone;
+		uint64_t Self = 0; // Samples whose leaf is this node
+	};
+
+	struct EdgeHash {
+		size_t operator()(const std::pair<uint32_t, Frame> &edge) const noexcept;
+	};
+
+	static uint64_t HashStack(std::span<const Frame> stack);
+
+	uint32_t Child(uint32_t parent, Frame frame);
+	bool EndsAt(uint32_t node, std::span<const Frame> stack) const;
+
+	std::vector<Node> m_nodes;
+	std::unordered_map<std::pair<uint32_t, Frame>, uint32_t, EdgeHash> m_edges;
+	std::unordered_map<uint64_t, uint32_t> m_stacks; // Stack hash -> last node
+	uint64_t m_total = 0;
+};
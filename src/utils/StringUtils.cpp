@@ -36,6 +36,19 @@ std::string StringUtils::WstrToString(std::wstring_view wstr) {
 	return result;
 }
 
+std::wstring StringUtils::ArgToWstring(std::string_view str) {
+	std::wstring result;
+	if (str.empty()) return result;
+
+	const int size = static_cast<int>(str.size());
+	const int sizeNeeded = MultiByteToWideChar(CP_ACP, 0, str.data(), size, nullptr, 0);
+	if (sizeNeeded > 0) {
+		result.resize(sizeNeeded);
+		MultiByteToWideChar(CP_ACP, 0, str.data(), size, result.data(), sizeNeeded);
+	}
+	return result;
+}
+
 std::string StringUtils::ToLower(std::string_view str) {
 	std::string result(str);
 	std::transform(result.begin(), result.end(), result.begin(), [](unsigned char c) {
@@ -70,3 +83,21 @@ std::optional<long> StringUtils::TryParseInt(std::string_view str) {
 
 	return result;
 }
+
+std::optional<std::chrono::milliseconds>
+StringUtils::TryParseDuration(std::string_view str) {
+	long scale = 1000;
+	if (str.ends_with("ms")) {
+		scale = 1;
+		str.remove_suffix(2);
+	} else if (str.ends_with('s')) {
+		str.remove_suffix(1);
+	} else if (str.ends_with('m')) {
+		scale = 60 * 1000;
+		str.remove_suffix(1);
+	}
+
+	auto value = TryParseInt(str);
+	if (!value || value.value() < 0) return std::nullopt;
+	return std::chrono::milliseconds(static_cast<long long>(value.value()) * scale);
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <chrono>
 #include <optional>
 #include <string>
 
@@ -9,6 +10,12 @@ namespace StringUtils {
 	 */
 	std::string WstrToString(std::wstring_view wstr);
 
+	/**
+	 * @brief Convert a string in the active code page, the encoding command-line
+	 *        arguments arrive in, to UTF-16.
+	 */
+	std::wstring ArgToWstring(std::string_view str);
+
 	/**
 	 * @brief Converts a std::string to lowercase.
 	 */
@@ -23,4 +30,10 @@ namespace StringUtils {
 	 * @brief Tries to parse std::string to long.
 	 */
 	std::optional<long> TryParseInt(std::string_view str);
+
+	/**
+	 * @brief Tries to parse a duration like "500ms", "2s" or "1m".
+	 *        A bare number is taken as seconds.
+	 */
+	std::optional<std::chrono::milliseconds> TryParseDuration(std::string_view str);
 } // namespace StringUtils
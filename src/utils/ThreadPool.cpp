@@ -0,0 +1,152 @@
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <atomic>
+
+static thread_local bool t_insideLoop = false;
+static std::atomic<size_t> s_defaultConcurrency = 0;
+
+ThreadPool::ThreadPool(size_t concurrency) {
+	concurrency = (std::max)(concurrency, size_t{1});
+	m_slices = std::make_unique<Slice[]>(concurrency);
+
+	m_workers.reserve(concurrency - 1);
+	for (size_t i = 1; i < concurrency; ++i) {
+		m_workers.emplace_back(&ThreadPool::WorkerLoop, this, i);
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard lock(m_mutex);
+		m_stopping = true;
+	}
+	m_wake.notify_all();
+	for (auto &worker : m_workers) {
+		worker.join();
+	}
+}
+
+ThreadPool &ThreadPool::Shared() {
+	static ThreadPool instance([] {
+		const size_t requested = s_defaultConcurrency.load();
+		if (requested != 0) return requested;
+		return static_cast<size_t>((std::max)(std::thread::hardware_concurrency(), 1u));
+	}());
+	return instance;
+}
+
+void ThreadPool::SetDefaultConcurrency(size_t concurrency) {
+	s_defaultConcurrency = concurrency;
+}
+
+void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t)> &body) {
+	if (count == 0) return;
+
+	if (m_workers.empty() || count == 1 || t_insideLoop) {
+		for (size_t i = 0; i < count; ++i) {
+			body(i);
+		}
+		return;
+	}
+
+	std::lock_guard run(m_runMutex);
+
+	// Even split; stealing evens out whatever the split gets wrong.
+	const size_t participants = Concurrency();
+	for (size_t i = 0; i < participants; ++i) {
+		std::lock_guard lock(m_slices[i].Mutex);
+		m_slices[i].Begin = count * i / participants;
+		m_slices[i].End = count * (i + 1) / participants;
+	}
+
+	{
+		std::lock_guard lock(m_mutex);
+		m_body = &body;
+		m_active = m_workers.size();
+		++m_generation;
+	}
+	m_wake.notify_all();
+
+	Participate(0);
+
+	std::unique_lock lock(m_mutex);
+	m_done.wait(lock, [this] {
+		return m_active == 0;
+	});
+	m_body = nullptr;
+}
+
+void ThreadPool::WorkerLoop(size_t self) {
+	size_t seen = 0;
+	while (true) {
+		{
+			std::unique_lock lock(m_mutex);
+			m_wake.wait(lock, [&] {
+				return m_stopping || m_generation != seen;
+			});
+			if (m_stopping) return;
+			seen = m_generation;
+		}
+
+		Participate(self);
+
+		std::lock_guard lock(m_mutex);
+		if (--m_active == 0) m_done.notify_one();
+	}
+}
+
+void ThreadPool::Participate(size_t self) {
+	t_insideLoop = true;
+	size_t index;
+	while (Take(self, index)) {
+		(*m_body)(index);
+	}
+	t_insideLoop = false;
+}
+
+bool ThreadPool::Take(size_t self, size_t &index) {
+	Slice &own = m_slices[self];
+	{
+		std::lock_guard lock(own.Mutex);
+		if (own.Begin < own.End) {
+			index = own.Begin++;
+			return true;
+		}
+	}
+
+	const size_t participants = Concurrency();
+	while (true) {
+		// Pick the victim with the most work left.
+		size_t victim = participants;
+		size_t most = 0;
+		for (size_t i = 0; i < participants; ++i) {
+			if (i == self) continue;
+			std::lock_guard lock(m_slices[i].Mutex);
+			const size_t left = m_slices[i].End - m_slices[i].Begin;
+			if (left > most) {
+				most = left;
+				victim = i;
+			}
+		}
+		if (victim == participants) return false;
+
+		size_t begin, end;
+		{
+			std::lock_guard lock(m_slices[victim].Mutex);
+			Slice &slice = m_slices[victim];
+			if (slice.Begin >= slice.End) continue; // Drained meanwhile, look again
+
+			end = slice.End;
+			begin = slice.Begin + (slice.End - slice.Begin) / 2;
+			slice.End = begin;
+		}
+
+		// Begin == End - 1 only leaves one item: take it directly.
+		std::lock_guard lock(own.Mutex);
+		index = begin;
+		own.Begin = begin + 1;
+		own.End = end;
+		return true;
+	}
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Bounded pool of worker threads running index-parallel loops.
+ *        Each participant owns a slice of the index range and takes from its
+ *        front; a participant that runs dry steals the back half of the largest
+ *        remaining slice, so slow items (e.g. a blocked syscall) don't stall the loop.
+ */
+class ThreadPool {
+public:
+	/**
+	 * @param concurrency Total participants, including the calling thread.
+	 */
+	explicit ThreadPool(size_t concurrency);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool &) = delete;
+	ThreadPool &operator=(const ThreadPool &) = delete;
+
+	/**
+	 * @brief Run body(i) for every i in [0, count) and wait for all of them.
+	 *        Bodies run concurrently and should write to pre-sized per-index slots.
+	 *        A nested call from inside a body runs serially on the calling thread.
+	 */
+	void ParallelFor(size_t count, const std::function<void(size_t)> &body);
+
+	size_t Concurrency() const { return m_workers.size() + 1; }
+
+	/**
+	 * @brief Process-wide pool sized by SetDefaultConcurrency (core count by default).
+	 */
+	static ThreadPool &Shared();
+
+	/**
+	 * @brief Set the size of the shared pool; only effective before its first use.
+	 */
+	static void SetDefaultConcurrency(size_t concurrency);
+
+private:
+	struct Slice {
+		std::mutex Mutex;
+		size_t Begin = 0;
+		size_t End = 0;
+	};
+
+	void WorkerLoop(size_t self);
+	void Participate(size_t self);
+	bool Take(size_t self, size_t &index);
+
+	std::vector<std::thread> m_workers;
+	std::unique_ptr<Slice[]> m_slices;
+
+	std::mutex m_runMutex; // One loop at a time
+	std::mutex m_mutex;
+	std::condition_variable m_wake;
+	std::condition_variable m_done;
+	const std::function<void(size_t)> *m_body = nullptr;
+	size_t m_generation = 0;
+	size_t m_active = 0; // Workers still inside the current loop
+	bool m_stopping = false;
+};
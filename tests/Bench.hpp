@@ -0,0 +1,39 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <limits>
+
+/**
+ * @brief Timing helpers for the benchmark executables. Benchmarks are built with
+ *        the tests but not run by ctest; build with optimizations when timing.
+ */
+namespace Bench {
+
+	/**
+	 * @brief Run fn the given number of times and return the fastest run in ms.
+	 */
+	template <typename Fn> double BestOf(int runs, Fn &&fn) {
+		using Clock = std::chrono::steady_clock;
+		double best = (std::numeric_limits<double>::max)();
+		for (int i = 0; i < runs; ++i) {
+			const auto start = Clock::now();
+			fn();
+			const std::chrono::duration<double, std::milli> took = Clock::now() - start;
+			best = (std::min)(best, took.count());
+		}
+		return best;
+	}
+
+	inline void Row(const char *name, double baselineMs, double ms) {
+		std::printf(
+			"%-28s %10.2f ms %10.2f ms %8.1fx\n", name, baselineMs, ms, baselineMs / ms
+		);
+	}
+
+	inline void Header(const char *baseline, const char *candidate) {
+		std::printf("%-28s %13s %13s %9s\n", "", baseline, candidate, "speedup");
+	}
+
+} // namespace Bench
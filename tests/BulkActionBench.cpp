@@ -0,0 +1,89 @@
+#include "Bench.hpp"
+
+#include <thread>
+
+#include "core/BulkAction.hpp"
+
+// Stands in for OpenProcess plus TerminateProcess/NtSuspendProcess: a short
+// blocking call per target.
+static ResultVoid SimulatedAction(const ProcessInfo &) {
+	std::this_thread::sleep_for(std::chrono::microseconds(300));
+	return std::monostate{};
+}
+
+static ProcessInfo Process(DWORD pid, DWORD parentPid) {
+	ProcessInfo proc{};
+	proc.Pid = pid;
+	proc.ParentPid = parentPid;
+	proc.CreateTime = pid;
+	return proc;
+}
+
+static std::vector<ProcessInfo> FlatTargets(size_t count) {
+	std::vector<ProcessInfo> targets;
+	for (DWORD i = 0; i < count; ++i) {
+		targets.push_back(Process(1000 + i * 4, 4));
+	}
+	return targets;
+}
+
+// One root, 20 group processes under it and 14 workers under each group.
+static std::vector<ProcessInfo> TreeTargets() {
+	std::vector<ProcessInfo> targets{Process(100, 4)};
+	for (DWORD g = 0; g < 20; ++g) {
+		const DWORD group = 200 + g;
+		targets.push_back(Process(group, 100));
+		for (DWORD w = 0; w < 14; ++w) {
+			targets.push_back(Process(10000 + g * 100 + w, group));
+		}
+	}
+	return targets;
+}
+
+static void Compare(const char *name, const std::vector<ProcessInfo> &targets) {
+	using Clock = std::chrono::steady_clock;
+
+	// Baseline: the old handler loop, one target after another.
+	const double serialMs = Bench::BestOf(3, [&] {
+		for (const auto &proc : targets) {
+			SimulatedAction(proc);
+		}
+	});
+
+	for (size_t threads : {8, 16}) {
+		ThreadPool pool(threads);
+		double firstReportMs = 0;
+		size_t reported = 0;
+		const double parallelMs = Bench::BestOf(3, [&] {
+			const auto start = Clock::now();
+			reported = 0;
+			BulkAction::Run(
+				targets,
+				SimulatedAction,
+				[&](std::span<const BulkAction::Outcome> done) {
+					if (reported == 0) {
+						const std::chrono::duration<double, std::milli> took =
+							Clock::now() - start;
+						firstReportMs = took.count();
+					}
+					reported += done.size();
+				},
+				pool
+			);
+		});
+
+		char label[64];
+		std::snprintf(label, sizeof(label), "%s, %zu threads", name, threads);
+		Bench::Row(label, serialMs, parallelMs);
+		std::printf(
+			"%-28s first results after %.2f ms, %zu reported\n", "", firstReportMs, reported
+		);
+	}
+}
+
+int main() {
+	Bench::Header("serial", "BulkAction");
+	Compare("300 flat targets", FlatTargets(300));
+	Compare("301 tree targets", TreeTargets());
+	return 0;
+}
@@ -0,0 +1,156 @@
+#include "Check.hpp"
+
+#include <atomic>
+#include <map>
+#include <thread>
+
+#include "core/BulkAction.hpp"
+
+static ProcessInfo Process(DWORD pid, DWORD parentPid, ULONGLONG createTime = 1) {
+	ProcessInfo proc{};
+	proc.Name = L"p" + std::to_wstring(pid);
+	proc.Pid = pid;
+	proc.ParentPid = parentPid;
+	proc.CreateTime = createTime;
+	return proc;
+}
+
+// Every report call, with the PIDs it carried.
+struct Reports {
+	std::vector<std::vector<DWORD>> Batches;
+	std::vector<DWORD> Pids;
+	bool OffCallerThread = false;
+
+	BulkAction::Report Collect() {
+		const auto caller = std::this_thread::get_id();
+		return [this, caller](std::span<const BulkAction::Outcome> done) {
+			if (std::this_thread::get_id() != caller) OffCallerThread = true;
+			auto &batch = Batches.emplace_back();
+			for (const auto &[proc, result] : done) {
+				batch.push_back(proc.Pid);
+				Pids.push_back(proc.Pid);
+			}
+		};
+	}
+};
+
+static void FlatTargetsReportInTargetOrder() {
+	ThreadPool pool(4);
+	std::vector<ProcessInfo> targets;
+	std::vector<DWORD> expected;
+	for (DWORD pid = 1000; pid > 900; --pid) {
+		targets.push_back(Process(pid, 4));
+		expected.push_back(pid);
+	}
+
+	std::atomic<int> calls = 0;
+	Reports reports;
+	BulkAction::Run(
+		targets,
+		[&](const ProcessInfo &proc) -> ResultVoid {
+			++calls;
+			if (proc.Pid % 10 == 0) return Error("Access denied");
+			return std::monostate{};
+		},
+		reports.Collect(),
+		pool
+	);
+
+	CHECK(calls == 100);
+	CHECK(reports.Pids == expected);
+	CHECK(!reports.OffCallerThread);
+
+	// Results show up batch by batch, not all at the end.
+	CHECK(reports.Batches.size() > 1);
+	for (const auto &batch : reports.Batches) {
+		CHECK(!batch.empty() && batch.size() <= pool.Concurrency() * 8);
+	}
+}
+
+static void OutcomesStayWithTheirTarget() {
+	ThreadPool pool(3);
+	std::vector<ProcessInfo> targets;
+	for (DWORD pid = 1; pid <= 50; ++pid) {
+		targets.push_back(Process(pid * 4, 0));
+	}
+
+	size_t seen = 0;
+	BulkAction::Run(
+		targets,
+		[](const ProcessInfo &proc) -> ResultVoid {
+			if (proc.Pid % 8 == 0) return Error("Failed for " + std::to_string(proc.Pid));
+			return std::monostate{};
+		},
+		[&](std::span<const BulkAction::Outcome> done) {
+			for (const auto &[proc, result] : done) {
+				++seen;
+				if (proc.Pid % 8 == 0) {
+					CHECK(!result && result.error().message ==
+										 "Failed for " + std::to_string(proc.Pid));
+				} else {
+					CHECK(result.has_value());
+				}
+			}
+		},
+		pool
+	);
+	CHECK(seen == 50);
+}
+
+static void ParentsRunBeforeChildren() {
+	// 10 -> {20, 21}, 20 -> {30, 31}, 21 -> 32; 40 is unrelated; 50's parent 10
+	// was started after it, so 50 is a root despite the PID.
+	std::vector<ProcessInfo> targets = {
+		Process(32, 21, 5), Process(20, 10, 2), Process(40, 1, 1), Process(31, 20, 3),
+		Process(10, 1, 1),  Process(21, 10, 2), Process(30, 20, 4), Process(50, 10, 0),
+	};
+
+	ThreadPool pool(4);
+	std::mutex mutex;
+	std::map<DWORD, int> finished; // PID -> completion order
+	std::map<DWORD, bool> parentDone;
+	int order = 0;
+
+	Reports reports;
+	BulkAction::Run(
+		targets,
+		[&](const ProcessInfo &proc) -> ResultVoid {
+			std::lock_guard lock(mutex);
+			parentDone[proc.Pid] =
+				proc.ParentPid == 1 || proc.Pid == 50 || finished.count(proc.ParentPid);
+			finished[proc.Pid] = order++;
+			return std::monostate{};
+		},
+		reports.Collect(),
+		pool
+	);
+
+	CHECK(finished.size() == targets.size());
+	for (const auto &[pid, done] : parentDone) {
+		CHECK(done);
+	}
+
+	// Wave by wave, target order within each wave.
+	CHECK(reports.Pids == std::vector<DWORD>({40, 10, 50, 20, 21, 32, 31, 30}));
+	CHECK(reports.Batches.size() == 3);
+}
+
+static void NoTargets() {
+	ThreadPool pool(2);
+	bool reported = false;
+	BulkAction::Run(
+		{},
+		[](const ProcessInfo &) -> ResultVoid { return std::monostate{}; },
+		[&](std::span<const BulkAction::Outcome>) { reported = true; },
+		pool
+	);
+	CHECK(!reported);
+}
+
+int main() {
+	FlatTargetsReportInTargetOrder();
+	OutcomesStayWithTheirTarget();
+	ParentsRunBeforeChildren();
+	NoTargets();
+	return Check::Report();
+}
@@ -0,0 +1,73 @@
+#include "Bench.hpp"
+
+#include <cwctype>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "CaseFold.hpp"
+
+// Image names as a 10k-entry snapshot would list them, in mixed case.
+static std::vector<std::wstring> MakeSnapshot(size_t count) {
+	const wchar_t *names[] = {
+		L"svchost.exe",       L"RuntimeBroker.exe", L"chrome.exe",     L"conhost.exe",
+		L"explorer.exe",      L"MsMpEng.exe",       L"Code.exe",       L"node.exe",
+		L"dllhost.exe",       L"SearchHost.exe",    L"WmiPrvSE.exe",
+		L"\u00dcber-Tool.exe", // Non-ASCII, takes the per-unit path
+	};
+
+	std::mt19937 rng(3);
+	std::vector<std::wstring> snapshot;
+	snapshot.reserve(count);
+	for (size_t i = 0; i < count; ++i) {
+		std::wstring name = names[rng() % std::size(names)];
+		for (wchar_t &c : name) {
+			if (rng() % 4 == 0) c = static_cast<wchar_t>(std::towupper(c));
+		}
+		snapshot.push_back(std::move(name));
+	}
+	return snapshot;
+}
+
+// What target matching did before CaseFold: lowercase a copy, then compare.
+static std::wstring ToLower(std::wstring_view s) {
+	std::wstring out(s);
+	for (wchar_t &c : out) {
+		c = static_cast<wchar_t>(std::towlower(c));
+	}
+	return out;
+}
+
+int main() {
+	const auto snapshot = MakeSnapshot(10000);
+	const std::wstring target = L"SVCHOST.exe";
+	const int scans = 100;
+
+	size_t copyMatches = 0, foldMatches = 0;
+	const double copyMs = Bench::BestOf(3, [&] {
+		copyMatches = 0;
+		const std::wstring lowered = ToLower(target);
+		for (int scan = 0; scan < scans; ++scan) {
+			for (const auto &name : snapshot) {
+				copyMatches += ToLower(name) == lowered;
+			}
+		}
+	});
+	const double foldMs = Bench::BestOf(3, [&] {
+		foldMatches = 0;
+		for (int scan = 0; scan < scans; ++scan) {
+			for (const auto &name : snapshot) {
+				foldMatches += CaseFold::Equals(name, target);
+			}
+		}
+	});
+
+	std::printf("%zu names, %d scans for \"svchost.exe\"\n\n", snapshot.size(), scans);
+	Bench::Header("copy+towlower", "CaseFold");
+	Bench::Row("Equals", copyMs, foldMs);
+	if (copyMatches != foldMatches) {
+		std::printf("MISMATCH: %zu vs %zu matches\n", copyMatches, foldMatches);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdio>
+#include <string>
+
+/**
+ * @brief Minimal assertions for the test executables: a failed check is
+ *        reported with its location and the run continues, so one run lists
+ *        every failure. Each test's main() returns Check::Report().
+ */
+namespace Check {
+	inline int g_failures = 0;
+
+	inline void That(bool ok, const char *expr, const char *file, int line) {
+		if (ok) return;
+		std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expr);
+		++g_failures;
+	}
+
+	inline int Report() {
+		if (g_failures == 0) {
+			std::printf("All checks passed\n");
+			return 0;
+		}
+		std::fprintf(stderr, "%d check(s) failed\n", g_failures);
+		return 1;
+	}
+} // namespace Check
+
+#define CHECK(expr) Check::That(static_cast<bool>(expr), #expr, __FILE__, __LINE__)
@@ -0,0 +1,108 @@
+#include "Bench.hpp"
+
+#include <atomic>
+#include <format>
+#include <random>
+#include <regex>
+#include <string>
+#include <vector>
+
+#include "DfaRegex.hpp"
+#include "ThreadPool.hpp"
+
+// Start addresses as the thread listing prints them: module!symbol+0xoffset.
+static std::vector<std::string> MakeAddresses(size_t count) {
+	const char *modules[] = {
+		"ntdll.dll", "KERNEL32.DLL", "KERNELBASE.dll", "ucrtbase.dll", "ws2_32.dll",
+		"combase.dll", "chrome.dll", "app.exe", "mswsock.dll", "RPCRT4.dll",
+	};
+	const char *prefixes[] = {"Rtl", "Tpp", "Base", "Worker", "Io", "Nt", "Wait", ""};
+	const char *stems[] = {"Thread", "Start", "Loop", "Callback", "Dispatch", "Poll"};
+
+	std::mt19937 rng(1);
+	std::vector<std::string> addresses;
+	addresses.reserve(count);
+	for (size_t i = 0; i < count; ++i) {
+		addresses.push_back(
+			std::format(
+				"{}!{}{}{}+0x{:x}",
+				modules[rng() % std::size(modules)],
+				prefixes[rng() % std::size(prefixes)],
+				stems[rng() % std::size(stems)],
+				stems[rng() % std::size(stems)],
+				rng() % 0x4000
+			)
+		);
+	}
+	return addresses;
+}
+
+int main() {
+	const auto addresses = MakeAddresses(100000);
+	const char *patterns[] = {
+		"ntdll",
+		"kernel32!.*thread",
+		"^ntdll\\.dll!Tpp\\w+",
+		"(ws2_32|mswsock)\\.dll!",
+		"worker.*\\+0x[0-9a-f]{3}$",
+	};
+
+	ThreadPool pool(std::thread::hardware_concurrency());
+	std::printf("%zu addresses, %zu threads for the parallel column\n\n",
+				addresses.size(), pool.Concurrency());
+	std::printf(
+		"%-28s %13s %13s %9s %13s\n", "", "std::regex", "DfaRegex", "speedup", "parallel"
+	);
+
+	int status = 0;
+	for (const char *pattern : patterns) {
+		const std::regex regex(pattern, std::regex_constants::icase);
+		auto dfa = DfaRegex::Compile(pattern, true);
+		if (!dfa) {
+			std::printf("%-28s not supported by DfaRegex\n", pattern);
+			status = 1;
+			continue;
+		}
+
+		size_t stdMatches = 0, dfaMatches = 0;
+		const double stdMs = Bench::BestOf(3, [&] {
+			stdMatches = 0;
+			for (const auto &text : addresses) {
+				stdMatches += std::regex_search(text, regex);
+			}
+		});
+		const double dfaMs = Bench::BestOf(3, [&] {
+			dfaMatches = 0;
+			for (const auto &text : addresses) {
+				dfaMatches += dfa->Search(text);
+			}
+		});
+
+		// The same compiled pattern searched from every pool thread at once.
+		std::atomic<size_t> parallelMatches = 0;
+		const double parallelMs = Bench::BestOf(3, [&] {
+			parallelMatches = 0;
+			const size_t chunk = 1000;
+			pool.ParallelFor(addresses.size() / chunk, [&](size_t c) {
+				size_t found = 0;
+				for (size_t i = c * chunk; i < (c + 1) * chunk; ++i) {
+					found += dfa->Search(addresses[i]);
+				}
+				parallelMatches += found;
+			});
+		});
+
+		std::printf(
+			"%-28s %10.2f ms %10.2f ms %8.1fx %10.2f ms%s\n",
+			pattern,
+			stdMs,
+			dfaMs,
+			stdMs / dfaMs,
+			parallelMs,
+			stdMatches == dfaMatches && dfaMatches == parallelMatches ? ""
+																	  : "  MISMATCH"
+		);
+		if (stdMatches != dfaMatches || dfaMatches != parallelMatches) status = 1;
+	}
+	return status;
+}
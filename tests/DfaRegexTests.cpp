@@ -0,0 +1,110 @@
+#include "Check.hpp"
+
+#include <random>
+#include <regex>
+#include <thread>
+
+#include "DfaRegex.hpp"
+
+static bool Expected(const std::string &pattern, const std::string &text) {
+	return std::regex_search(text, std::regex(pattern, std::regex_constants::icase));
+}
+
+static void MatchesLikeStdRegex() {
+	const std::vector<std::string> patterns = {
+		"ntdll",
+		"^ntdll!",
+		"Thread$",
+		"^$",
+		"kernel32!.*thread",
+		"(ws2_32|mswsock)!\\w+",
+		"!Rtl[A-Z]\\w*\\+0x[0-9a-f]{2,4}$",
+		"a(b|c)*d",
+		"x{3}",
+		"[^!]+![^+]+\\+",
+		"\\d+",
+		"\\s",
+		"(a|)b?",
+	};
+	const std::vector<std::string> texts = {
+		"",
+		"ntdll.dll!RtlUserThreadStart+0x21",
+		"NTDLL.DLL!TppWorkerThread+0x4a3",
+		"kernel32.dll!BaseThreadInitThunk+0x14",
+		"ws2_32.dll!WSAPoll+0x1f0",
+		"mswsock.dll+0x1234",
+		"app.exe!main",
+		"abccbd",
+		"ad",
+		"xx",
+		"xxx",
+		"line\twith tab",
+		"0x7ff600001000",
+	};
+
+	for (const auto &pattern : patterns) {
+		auto dfa = DfaRegex::Compile(pattern, true);
+		CHECK(dfa.has_value());
+		if (!dfa) continue;
+		for (const auto &text : texts) {
+			if (dfa->Search(text) != Expected(pattern, text)) {
+				std::fprintf(stderr, "/%s/ on \"%s\"\n", pattern.c_str(), text.c_str());
+				CHECK(dfa->Search(text) == Expected(pattern, text));
+			}
+		}
+	}
+}
+
+static void RejectsUnsupportedPatterns() {
+	CHECK(!DfaRegex::Compile("(a)\\1", true));   // Backreference
+	CHECK(!DfaRegex::Compile("a(?=b)", true));   // Lookahead
+	CHECK(!DfaRegex::Compile("\\bword", true));  // Word boundary
+	CHECK(!DfaRegex::Compile("(unclosed", true));
+}
+
+static void ConcurrentSearchesAcrossCacheResets() {
+	// The n-th symbol from the end being 'a' needs 2^n DFA states, far more than
+	// the cache holds, so searches keep building states and replacing the cache
+	// while others are walking it.
+	const std::string pattern = "a[ab]{11}$";
+	auto dfa = DfaRegex::Compile(pattern, false);
+	CHECK(dfa.has_value());
+	if (!dfa) return;
+
+	std::mt19937 rng(7);
+	std::vector<std::string> texts(400);
+	std::vector<bool> expected(texts.size());
+	const std::regex reference(pattern);
+	for (size_t i = 0; i < texts.size(); ++i) {
+		texts[i].resize(20 + rng() % 40);
+		for (char &c : texts[i]) {
+			c = rng() % 2 ? 'a' : 'b';
+		}
+		expected[i] = std::regex_search(texts[i], reference);
+	}
+
+	std::vector<int> mismatches(8);
+	std::vector<std::thread> threads;
+	for (size_t t = 0; t < mismatches.size(); ++t) {
+		threads.emplace_back([&, t] {
+			for (size_t i = 0; i < texts.size(); ++i) {
+				const size_t at = (i + t * texts.size() / 8) % texts.size();
+				if (dfa->Search(texts[at]) != expected[at]) ++mismatches[t];
+			}
+		});
+	}
+	for (auto &thread : threads) {
+		thread.join();
+	}
+
+	for (int count : mismatches) {
+		CHECK(count == 0);
+	}
+}
+
+int main() {
+	MatchesLikeStdRegex();
+	RejectsUnsupportedPatterns();
+	ConcurrentSearchesAcrossCacheResets();
+	return Check::Report();
+}
@@ -0,0 +1,121 @@
+#include "Check.hpp"
+
+#include "core/ModuleMap.hpp"
+
+static ModuleEntry Module(ULONG_PTR base, ULONG_PTR size, std::string name) {
+	return {base, size, std::move(name), L""};
+}
+
+static void OverlappingModulesAreMadeDisjoint() {
+	// Unsorted, one empty module, one overlapping its predecessor.
+	ModuleMap map({
+		Module(0x3000, 0x100, "c.dll"),
+		Module(0x1000, 0x1000, "a.dll"),
+		Module(0x1800, 0x1000, "overlap.dll"),
+		Module(0x2000, 0x100, "b.dll"),
+		Module(0x5000, 0, "empty.dll"),
+	});
+
+	const auto &modules = map.Modules();
+	CHECK(modules.size() == 3);
+	CHECK(modules[0].Name == "a.dll");
+	CHECK(modules[1].Name == "b.dll");
+	CHECK(modules[2].Name == "c.dll");
+	CHECK(map.FindByName("overlap.dll").empty());
+	CHECK(map.FindByName("empty.dll").empty());
+
+	// The overlapping part still belongs to the earlier module.
+	CHECK(map.Find(0x1900) == &modules[0]);
+	CHECK(map.Find(0x5000) == nullptr);
+}
+
+static void AddressesAtModuleEdges() {
+	ModuleMap map({
+		Module(0x1000, 0x1000, "a.dll"),
+		Module(0x2000, 0x100, "b.dll"),
+		Module(0x4000, 0x100, "c.dll"),
+	});
+	const auto &modules = map.Modules();
+
+	CHECK(map.Find(0x0fff) == nullptr);
+	CHECK(map.Find(0x1000) == &modules[0]); // Base
+	CHECK(map.Find(0x1fff) == &modules[0]); // Last byte
+	CHECK(map.Find(0x2000) == &modules[1]); // End of a.dll is the base of b.dll
+	CHECK(map.Find(0x2100) == nullptr);     // End of b.dll, gap after it
+	CHECK(map.Find(0x40ff) == &modules[2]);
+	CHECK(map.Find(0x4100) == nullptr);
+	CHECK(map.Find(~ULONG_PTR{0}) == nullptr);
+	CHECK(ModuleMap().Find(0x1000) == nullptr);
+
+	CHECK(map.FormatAddress(0x1000) == "a.dll+0x0");
+	CHECK(map.FormatAddress(0x20ab) == "b.dll+0xab");
+	CHECK(map.FormatAddress(0x3000) == "0x3000");
+	CHECK(map.FormatAddress(0).empty());
+}
+
+static void FindByNameIgnoresCase() {
+	ModuleMap map({
+		Module(0x1000, 0x100, "ntdll.dll"),
+		Module(0x2000, 0x100, "KERNEL32.DLL"),
+		Module(0x3000, 0x100, "Kernel32.dll"),
+	});
+
+	CHECK(map.FindByName("NTDLL.DLL").size() == 1);
+	CHECK(map.FindByName("kernel32.dll").size() == 2);
+	CHECK(map.FindByName("ntdll").empty());
+	CHECK(map.FindByName("").empty());
+}
+
+static void CacheKeysOnCreateTime() {
+	int captures = 0;
+	ModuleMapCache cache([&captures](DWORD pid) -> Result<ModuleMap, Error> {
+		++captures;
+		return ModuleMap({Module(0x1000 * pid, 0x100, "app.exe")});
+	});
+
+	// Unknown creation time: captured every time, never cached.
+	auto first = cache.Get(4, 0);
+	auto second = cache.Get(4, 0);
+	CHECK(first.has_value() && second.has_value());
+	CHECK(captures == 2);
+	CHECK(first.value() != second.value());
+
+	auto cached = cache.Get(4, 100);
+	CHECK(captures == 3);
+	CHECK(cache.Get(4, 100).value() == cached.value());
+	CHECK(captures == 3);
+
+	// Same PID, new creation time: a different process, captured afresh.
+	auto reused = cache.Get(4, 200);
+	CHECK(captures == 4);
+	CHECK(reused.value() != cached.value());
+	CHECK(cache.Get(4, 200).value() == reused.value());
+	CHECK(captures == 4);
+
+	// The earlier process's map was dropped, not kept beside the new one.
+	cache.Get(4, 100);
+	CHECK(captures == 5);
+}
+
+static void CacheDoesNotKeepFailures() {
+	int captures = 0;
+	ModuleMapCache cache([&captures](DWORD pid) -> Result<ModuleMap, Error> {
+		++captures;
+		return Error("Access denied for PID " + std::to_string(pid));
+	});
+
+	auto result = cache.Get(8, 100);
+	CHECK(!result.has_value());
+	CHECK(result.error().message == "Access denied for PID 8");
+	CHECK(!cache.Get(8, 100).has_value());
+	CHECK(captures == 2);
+}
+
+int main() {
+	OverlappingModulesAreMadeDisjoint();
+	AddressesAtModuleEdges();
+	FindByNameIgnoresCase();
+	CacheKeysOnCreateTime();
+	CacheDoesNotKeepFailures();
+	return Check::Report();
+}
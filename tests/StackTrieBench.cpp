@@ -0,0 +1,99 @@
+#include "Bench.hpp"
+
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "StackTrie.hpp"
+
+using Frame = StackTrie::Frame;
+
+// A synthetic profile: distinct stacks grown from each other's prefixes, the way
+// real call paths share their outer frames, then sampled with a skew towards a
+// few hot paths.
+static std::vector<std::vector<Frame>> MakeSamples(size_t distinct, size_t samples) {
+	std::mt19937_64 rng(42);
+	std::vector<std::vector<Frame>> stacks{{0x7ff600001000}};
+	while (stacks.size() < distinct) {
+		std::vector<Frame> stack = stacks[rng() % stacks.size()];
+		stack.resize(rng() % (stack.size() + 1));
+		const size_t grow = 1 + rng() % 12;
+		for (size_t i = 0; i < grow && stack.size() < 64; ++i) {
+			stack.push_back(0x7ff600000000 + (rng() % 4096) * 0x10);
+		}
+		if (!stack.empty()) stacks.push_back(std::move(stack));
+	}
+
+	std::vector<std::vector<Frame>> drawn;
+	drawn.reserve(samples);
+	std::exponential_distribution<double> skew(8.0 / distinct);
+	while (drawn.size() < samples) {
+		const auto i = static_cast<size_t>(skew(rng));
+		if (i < stacks.size()) drawn.push_back(stacks[i]);
+	}
+	return drawn;
+}
+
+static std::string Name(Frame frame) {
+	return "mod.dll!fn_" + std::to_string(frame & 0xffff);
+}
+
+int main() {
+	const auto samples = MakeSamples(20000, 1000000);
+	size_t frames = 0;
+	for (const auto &stack : samples) {
+		frames += stack.size();
+	}
+	std::printf("%zu samples, %zu frames\n\n", samples.size(), frames);
+
+	// Baseline: one map entry per distinct stack, frames copied into every key.
+	std::map<std::vector<Frame>, uint64_t> naive;
+	const double naiveAdd = Bench::BestOf(3, [&] {
+		naive.clear();
+		for (const auto &stack : samples) {
+			++naive[stack];
+		}
+	});
+
+	StackTrie trie;
+	const double trieAdd = Bench::BestOf(3, [&] {
+		trie = StackTrie();
+		for (const auto &stack : samples) {
+			trie.Add(stack);
+		}
+	});
+
+	size_t naiveBytes = 0;
+	const double naiveFold = Bench::BestOf(3, [&] {
+		std::string folded;
+		for (const auto &[stack, count] : naive) {
+			for (size_t i = 0; i < stack.size(); ++i) {
+				if (i > 0) folded += ';';
+				folded += Name(stack[i]);
+			}
+			folded += ' ' + std::to_string(count) + '\n';
+		}
+		naiveBytes = folded.size();
+	});
+
+	size_t trieBytes = 0;
+	const double trieFold = Bench::BestOf(3, [&] { trieBytes = trie.Fold(Name).size(); });
+
+	size_t naiveFrames = 0;
+	for (const auto &[stack, count] : naive) {
+		naiveFrames += stack.size();
+	}
+
+	Bench::Header("std::map", "StackTrie");
+	Bench::Row("aggregate", naiveAdd, trieAdd);
+	Bench::Row("fold", naiveFold, trieFold);
+	std::printf(
+		"\n%zu distinct stacks: %zu stored frames vs %zu trie nodes; folded %s\n",
+		naive.size(),
+		naiveFrames,
+		trie.NodeCount(),
+		naiveBytes == trieBytes ? "output sizes match" : "OUTPUT SIZES DIFFER"
+	);
+	return naiveBytes == trieBytes ? 0 : 1;
+}
@@ -0,0 +1,210 @@
+#include "Check.hpp"
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <sstream>
+
+#include "StackTrie.hpp"
+
+using Frame = StackTrie::Frame;
+using Stacks = std::map<std::vector<Frame>, uint64_t>;
+
+static void Add(StackTrie &trie, std::vector<Frame> stack, uint64_t count = 1) {
+	trie.Add(stack, count);
+}
+
+static Stacks Collect(const StackTrie &trie) {
+	Stacks stacks;
+	trie.ForEachStack([&](std::span<const Frame> stack, uint64_t count) {
+		const bool inserted =
+			stacks.try_emplace({stack.begin(), stack.end()}, count).second;
+		CHECK(inserted); // Each path is visited once
+	});
+	return stacks;
+}
+
+static std::vector<std::string> SortedLines(const std::string &text) {
+	std::vector<std::string> lines;
+	std::istringstream in(text);
+	for (std::string line; std::getline(in, line);) {
+		lines.push_back(line);
+	}
+	std::sort(lines.begin(), lines.end());
+	return lines;
+}
+
+static void SharedPrefixesShareNodes() {
+	StackTrie trie;
+	CHECK(trie.NodeCount() == 0);
+	CHECK(trie.TotalSamples() == 0);
+
+	Add(trie, {1, 2, 3});
+	Add(trie, {1, 2, 4});
+	Add(trie, {1, 5});
+	Add(trie, {1, 2, 3}, 4);
+	CHECK(trie.NodeCount() == 5); // 1, 2, 3, 4, 5
+	CHECK(trie.TotalSamples() == 7);
+
+	// The same frame under another caller is a separate node.
+	Add(trie, {6, 2, 3});
+	CHECK(trie.NodeCount() == 8);
+
+	CHECK(
+		Collect(trie) == Stacks({
+							 {{1, 2, 3}, 5},
+							 {{1, 2, 4}, 1},
+							 {{1, 5}, 1},
+							 {{6, 2, 3}, 1},
+						 })
+	);
+}
+
+static void CountsAtInteriorNodes() {
+	StackTrie trie;
+	Add(trie, {1, 2, 3}, 2);
+	Add(trie, {1, 2}, 3); // Ends where another stack continues
+	Add(trie, {1}, 1);
+	Add(trie, {1, 2}, 1);
+	CHECK(trie.NodeCount() == 3);
+	CHECK(trie.TotalSamples() == 7);
+
+	CHECK(
+		Collect(trie) == Stacks({
+							 {{1}, 1},
+							 {{1, 2}, 4},
+							 {{1, 2, 3}, 2},
+						 })
+	);
+
+	// Depth first: a stack ending at an interior node comes before those below it.
+	std::vector<size_t> depths;
+	trie.ForEachStack([&](std::span<const Frame> stack, uint64_t) {
+		depths.push_back(stack.size());
+	});
+	CHECK(depths == std::vector<size_t>({1, 2, 3}));
+}
+
+static void EmptyStacksAndZeroCountsAreIgnored() {
+	StackTrie trie;
+	Add(trie, {});
+	Add(trie, {1, 2}, 0);
+	CHECK(trie.NodeCount() == 0);
+	CHECK(trie.TotalSamples() == 0);
+	CHECK(trie.Frames().empty());
+	CHECK(Collect(trie).empty());
+	CHECK(trie.Fold([](Frame) { return std::string("x"); }).empty());
+}
+
+static void FramesAreDistinct() {
+	StackTrie trie;
+	Add(trie, {7, 7, 7}); // Recursion
+	Add(trie, {8, 7});
+	Add(trie, {0xffffffffffffffff});
+
+	auto frames = trie.Frames();
+	std::sort(frames.begin(), frames.end());
+	CHECK(frames == std::vector<Frame>({7, 8, 0xffffffffffffffff}));
+}
+
+static void FoldNamesEachFrameOnce() {
+	StackTrie trie;
+	Add(trie, {1, 2, 3}, 5);
+	Add(trie, {1, 2}, 2);
+	Add(trie, {1, 4});
+	Add(trie, {2, 3});
+
+	std::map<Frame, int> calls;
+	const std::string folded = trie.Fold([&](Frame frame) {
+		++calls[frame];
+		return "f" + std::to_string(frame);
+	});
+
+	const std::map<Frame, int> once{{1, 1}, {2, 1}, {3, 1}, {4, 1}};
+	CHECK(calls == once);
+	CHECK(folded.back() == '\n');
+	CHECK(
+		SortedLines(folded) ==
+		std::vector<std::string>({"f1;f2 2", "f1;f2;f3 5", "f1;f4 1", "f2;f3 1"})
+	);
+}
+
+static void MapMergesStacksThatBecomeEqual() {
+	// Program counters mapped to the function holding them: 0x1010 and 0x1020 are
+	// both in 0x1000, and the callers 0x500 and 0x510 are both in 0x500.
+	StackTrie trie;
+	Add(trie, {0x500, 0x1010}, 3);
+	Add(trie, {0x500, 0x1020}, 5);
+	Add(trie, {0x510, 0x1020}, 1);
+	Add(trie, {0x500}, 2);
+
+	const auto function = [](Frame pc) { return pc & ~Frame(0xff); };
+	const StackTrie merged = trie.Map(function);
+	CHECK(merged.TotalSamples() == trie.TotalSamples());
+	CHECK(merged.NodeCount() == 2);
+	CHECK(
+		Collect(merged) == Stacks({
+							   {{0x500}, 2},
+							   {{0x500, 0x1000}, 9},
+						   })
+	);
+	CHECK(
+		SortedLines(merged.Fold([](Frame f) { return "f" + std::to_string(f); })) ==
+		std::vector<std::string>({"f1280 2", "f1280;f4096 9"})
+	);
+}
+
+static void DeepStacks() {
+	// The walk is iterative, so depth is bounded by memory, not the call stack.
+	std::vector<Frame> deep(100000);
+	for (size_t i = 0; i < deep.size(); ++i) {
+		deep[i] = i % 3;
+	}
+
+	StackTrie trie;
+	trie.Add(deep);
+	trie.Add(std::span<const Frame>(deep).first(50000), 2);
+	CHECK(trie.NodeCount() == deep.size());
+
+	size_t visits = 0;
+	trie.ForEachStack([&](std::span<const Frame> stack, uint64_t count) {
+		++visits;
+		CHECK(stack.size() == (count == 2 ? 50000 : deep.size()));
+		CHECK(stack.back() == deep[stack.size() - 1]);
+	});
+	CHECK(visits == 2);
+}
+
+static void MatchesNaiveAggregation() {
+	// Random stacks over a small alphabet, so paths branch and merge at every depth.
+	std::mt19937_64 rng(12345);
+	StackTrie trie;
+	Stacks expected;
+	uint64_t total = 0;
+
+	for (int i = 0; i < 20000; ++i) {
+		std::vector<Frame> stack(1 + rng() % 8);
+		for (auto &frame : stack) {
+			frame = rng() % 4;
+		}
+		const uint64_t count = 1 + rng() % 3;
+		trie.Add(stack, count);
+		expected[stack] += count;
+		total += count;
+	}
+
+	CHECK(trie.TotalSamples() == total);
+	CHECK(Collect(trie) == expected);
+}
+
+int main() {
+	SharedPrefixesShareNodes();
+	CountsAtInteriorNodes();
+	EmptyStacksAndZeroCountsAreIgnored();
+	FramesAreDistinct();
+	FoldNamesEachFrameOnce();
+	MapMergesStacksThatBecomeEqual();
+	DeepStacks();
+	MatchesNaiveAggregation();
+	return Check::Report();
+}
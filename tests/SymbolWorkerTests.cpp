@@ -0,0 +1,206 @@
+#include "Check.hpp"
+
+#include <atomic>
+#include <format>
+#include <mutex>
+
+#include "core/SymbolWorker.hpp"
+
+using Symbols::ResolveRequest;
+using ChannelResult = Result<std::unique_ptr<SymbolWorker::Channel>, Error>;
+
+static ResolveRequest Request(DWORD pid, std::vector<ULONG_PTR> addresses) {
+	ResolveRequest request{pid, {}};
+	for (ULONG_PTR address : addresses) {
+		request.Addresses.push_back(reinterpret_cast<PVOID>(address));
+	}
+	return request;
+}
+
+// Serves lines of a response block the way the pipe reader would.
+static std::function<bool(std::string &)> LinesOf(std::string block) {
+	auto offset = std::make_shared<size_t>(0);
+	return [block = std::move(block), offset](std::string &line) {
+		size_t end = block.find('\n', *offset);
+		if (end == std::string::npos) return false;
+		line.assign(block, *offset, end - *offset);
+		*offset = end + 1;
+		return true;
+	};
+}
+
+// Talks the wire protocol in memory: the request goes through Encode/Decode, the
+// "worker" answers "<pid>!<addr>" per address, and the reply is parsed back.
+class StubChannel : public SymbolWorker::Channel {
+public:
+	StubChannel(std::vector<DWORD> &log, std::mutex &mutex, DWORD failPid)
+		: m_log(log), m_mutex(mutex), m_failPid(failPid) {}
+
+	Result<std::vector<std::string>, Error>
+	Resolve(const ResolveRequest &request) override {
+		{
+			std::lock_guard lock(m_mutex);
+			m_log.push_back(request.Pid);
+		}
+		if (m_broken) return Error("Channel used after it failed");
+		if (request.Pid == m_failPid) {
+			m_broken = true;
+			return Error("Worker died");
+		}
+
+		std::string line = SymbolWorker::EncodeRequest(request);
+		line.pop_back(); // Newline
+		auto decoded = SymbolWorker::DecodeRequest(line);
+		if (!decoded) return Error("Request did not decode");
+
+		std::vector<std::string> symbols;
+		for (PVOID address : decoded->Addresses) {
+			const auto value = reinterpret_cast<ULONG_PTR>(address);
+			symbols.push_back(std::format("{}!{:x}", decoded->Pid, value));
+		}
+		return SymbolWorker::DecodeResponse(
+			request, LinesOf(SymbolWorker::EncodeResponse(symbols))
+		);
+	}
+
+private:
+	std::vector<DWORD> &m_log;
+	std::mutex &m_mutex;
+	DWORD m_failPid;
+	bool m_broken = false;
+};
+
+static void RequestRoundTrip() {
+	auto request = Request(1234, {0x7ff600001000, 0x10, 0});
+	std::string line = SymbolWorker::EncodeRequest(request);
+	CHECK(line == "1234 3 7ff600001000 10 0\n");
+
+	line.pop_back();
+	auto decoded = SymbolWorker::DecodeRequest(line);
+	CHECK(decoded.has_value());
+	CHECK(decoded && decoded->Pid == 1234);
+	CHECK(decoded && decoded->Addresses == request.Addresses);
+
+	auto empty = SymbolWorker::DecodeRequest("7 0");
+	CHECK(empty && empty->Pid == 7 && empty->Addresses.empty());
+
+	CHECK(!SymbolWorker::DecodeRequest(""));
+	CHECK(!SymbolWorker::DecodeRequest("12"));
+	CHECK(!SymbolWorker::DecodeRequest("12 2 10"));    // Fewer addresses than counted
+	CHECK(!SymbolWorker::DecodeRequest("12 1 10 20")); // Trailing garbage
+	CHECK(!SymbolWorker::DecodeRequest("12 1 xyz"));
+	CHECK(!SymbolWorker::DecodeRequest("-1 0"));
+}
+
+static void ResponseParsing() {
+	auto request = Request(42, {0x10, 0x20});
+
+	auto ok = SymbolWorker::DecodeResponse(request, LinesOf("2\na!f\nb!g+0x4\n"));
+	CHECK(ok.has_value());
+	CHECK(ok && ok.value() == std::vector<std::string>({"a!f", "b!g+0x4"}));
+
+	// Symbols may legitimately be empty lines.
+	auto blank = SymbolWorker::DecodeResponse(request, LinesOf("2\n\n\n"));
+	CHECK(blank && blank.value() == std::vector<std::string>({"", ""}));
+
+	auto none = SymbolWorker::DecodeResponse(request, LinesOf(""));
+	CHECK(!none && none.error().message == "Symbol worker returned no result for PID 42");
+	CHECK(!SymbolWorker::DecodeResponse(request, LinesOf("two\na\nb\n")));
+
+	auto mismatch = SymbolWorker::DecodeResponse(request, LinesOf("1\na\n"));
+	CHECK(
+		!mismatch && mismatch.error().message ==
+						 "Symbol worker returned 1 symbols for 2 addresses of PID 42"
+	);
+
+	auto died = SymbolWorker::DecodeResponse(request, LinesOf("2\na\n"));
+	CHECK(!died && died.error().message == "Symbol worker died while resolving PID 42");
+}
+
+static void LargestBatchesGoFirst() {
+	std::vector<DWORD> log;
+	std::mutex mutex;
+	SymbolWorker::Pool pool(1, [&]() -> ChannelResult {
+		return std::unique_ptr<SymbolWorker::Channel>(
+			std::make_unique<StubChannel>(log, mutex, 0)
+		);
+	});
+
+	auto results = pool.ResolveAll({
+		Request(1, {0x1}),
+		Request(2, {0x1, 0x2, 0x3}),
+		Request(3, {}),
+		Request(4, {0x1, 0x2}),
+		Request(5, {0x4, 0x5, 0x6}),
+	});
+
+	// Ties keep request order; results come back in request order regardless.
+	CHECK(log == std::vector<DWORD>({2, 5, 4, 1, 3}));
+	CHECK(results.size() == 5);
+	CHECK(results[0] && results[0].value() == std::vector<std::string>{"1!1"});
+	CHECK(results[2] && results[2].value().empty());
+	const std::vector<std::string> last{"5!4", "5!5", "5!6"};
+	CHECK(results[4] && results[4].value() == last);
+}
+
+static void FailedChannelIsReplaced() {
+	std::vector<DWORD> log;
+	std::mutex mutex;
+	int created = 0;
+	SymbolWorker::Pool pool(1, [&]() -> ChannelResult {
+		++created;
+		return std::unique_ptr<SymbolWorker::Channel>(
+			std::make_unique<StubChannel>(log, mutex, 2)
+		);
+	});
+
+	auto results = pool.ResolveAll({
+		Request(1, {0x1, 0x2, 0x3}),
+		Request(2, {0x1, 0x2}),
+		Request(3, {0x1}),
+	});
+
+	// The failed batch is not retried; the batches after it use a new channel.
+	CHECK(created == 2);
+	CHECK(log == std::vector<DWORD>({1, 2, 3}));
+	CHECK(results[0].has_value());
+	CHECK(!results[1] && results[1].error().message == "Worker died");
+	CHECK(results[2] && results[2].value() == std::vector<std::string>{"3!1"});
+}
+
+static void UnavailableWorkersLeaveBatchesToOthers() {
+	std::vector<DWORD> log;
+	std::mutex mutex;
+	std::atomic<int> attempts = 0;
+	SymbolWorker::Pool pool(2, [&]() -> ChannelResult {
+		if (attempts++ == 0) return Error("Failed to launch symbol worker process");
+		return std::unique_ptr<SymbolWorker::Channel>(
+			std::make_unique<StubChannel>(log, mutex, 0)
+		);
+	});
+
+	auto results = pool.ResolveAll({Request(1, {0x1}), Request(2, {0x2})});
+	CHECK(attempts == 2);
+	CHECK(results[0] && results[1]);
+
+	// With no worker at all, every batch reports that it wasn't processed.
+	SymbolWorker::Pool dead(3, []() -> ChannelResult {
+		return Error("Failed to launch symbol worker process");
+	});
+	auto failed = dead.ResolveAll({Request(1, {0x1}), Request(2, {0x2})});
+	CHECK(failed.size() == 2);
+	for (const auto &result : failed) {
+		CHECK(!result);
+		CHECK(result.error().message == "Batch was not processed by any symbol worker");
+	}
+	CHECK(dead.ResolveAll({}).empty());
+}
+
+int main() {
+	RequestRoundTrip();
+	ResponseParsing();
+	LargestBatchesGoFirst();
+	FailedChannelIsReplaced();
+	UnavailableWorkersLeaveBatchesToOthers();
+	return Check::Report();
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+// Just enough of the Win32 type vocabulary for the portable core headers to
+// compile off Windows. Only the test build puts this directory on the path.
+
+#include <cstddef>
+#include <cstdint>
+
+using BOOL = int;
+using BYTE = uint8_t;
+using DWORD = uint32_t;
+using LONG = int32_t;
+using ULONG = uint32_t;
+using ULONGLONG = uint64_t;
+using ULONG_PTR = uintptr_t;
+using SIZE_T = size_t;
+using PVOID = void *;
+using HANDLE = void *;
+using HMODULE = void *;
+using NTSTATUS = LONG;
+
+struct CONTEXT {};
@@ -0,0 +1,10 @@
+#pragma once
+
+// src/utils/source_location.h is a copy of the MSVC STL header. Off Windows it
+// is switched off here and the standard library's type is used instead.
+
+#include <source_location>
+
+#define _STL_COMPILER_PREPROCESSOR 0
+
+using std::source_location;